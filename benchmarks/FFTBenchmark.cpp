@@ -0,0 +1,102 @@
+// compares eng::FFT (used by AudioAnalyzer) with the recursive std::valarray FFT it replaced
+// built with -DBUILD_BENCHMARKS=ON, run bin/FFTBenchmark
+#include <SHADERed/Engine/FFT.h>
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <random>
+#include <valarray>
+#include <vector>
+
+#define FFT_BENCHMARK_MIN_TIME 0.25 // seconds per implementation & size
+
+// the old AudioAnalyzer::m_fftAlgorithm
+static void recursiveFFT(std::valarray<std::complex<double>>& input)
+{
+	const int len = input.size();
+	if (len <= 1) return;
+
+	std::valarray<std::complex<double>> even = input[std::slice(0, len / 2, 2)];
+	std::valarray<std::complex<double>> odd = input[std::slice(1, len / 2, 2)];
+
+	recursiveFFT(even);
+	recursiveFFT(odd);
+
+	for (int i = 0; i < len / 2; i++) {
+		std::complex<double> temp = std::polar(1.0, (double)-2 * M_PI * i / len) * odd[i];
+		input[i] = even[i] + temp;
+		input[i + len / 2] = even[i] - temp;
+	}
+}
+
+// runs func until FFT_BENCHMARK_MIN_TIME has passed, returns microseconds per call
+template <typename Func>
+static double measure(Func func)
+{
+	typedef std::chrono::steady_clock clock;
+
+	func(); // warm up
+
+	long long runs = 0;
+	clock::time_point start = clock::now();
+	double elapsed = 0.0;
+	do {
+		for (int i = 0; i < 16; i++)
+			func();
+		runs += 16;
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (elapsed < FFT_BENCHMARK_MIN_TIME);
+
+	return elapsed * 1000000.0 / runs;
+}
+
+int main()
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> dist(-32768.0f, 32767.0f); // same range as the 16bit samples AudioAnalyzer gets
+
+	const int sizes[] = { 1024, 2048, 4096 };
+
+	printf("%6s %16s %16s %9s %12s\n", "N", "recursive (us)", "iterative (us)", "speedup", "max error");
+	for (int size : sizes) {
+		std::vector<float> samples(size);
+		for (float& s : samples)
+			s = dist(rng);
+
+		// recursive - copies the input every run, same as AudioAnalyzer did every frame
+		std::valarray<std::complex<double>> refOut(size);
+		double recTime = measure([&]() {
+			std::valarray<std::complex<double>> data(size);
+			for (int i = 0; i < size; i++)
+				data[i] = samples[i];
+			recursiveFFT(data);
+			refOut = data;
+		});
+
+		// iterative - the input is written to the bit reversed slots, same as AudioAnalyzer::FFT
+		ed::eng::FFT fft(size);
+		std::vector<float> re(size), im(size);
+		double iterTime = measure([&]() {
+			for (int i = 0; i < size; i++)
+				re[fft.GetBitReversed(i)] = samples[i];
+			std::fill(im.begin(), im.end(), 0.0f);
+			fft.Compute(re.data(), im.data());
+		});
+
+		// error relative to the largest magnitude
+		double maxMag = 0.0, maxErr = 0.0;
+		for (int i = 0; i < size; i++) {
+			maxMag = std::max(maxMag, std::abs(refOut[i]));
+			maxErr = std::max(maxErr, std::abs(refOut[i] - std::complex<double>(re[i], im[i])));
+		}
+
+		printf("%6d %16.2f %16.2f %8.1fx %12.2e\n", size, recTime, iterTime, recTime / iterTime, maxErr / maxMag);
+	}
+
+	return 0;
+}
\ No newline at end of file
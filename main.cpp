@@ -4,6 +4,7 @@
 
 #include <SDL2/SDL.h>
 #include <SHADERed/EditorEngine.h>
+#include <SHADERed/HeadlessRenderer.h>
 #include <SHADERed/Objects/CommandLineOptionParser.h>
 #include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/Settings.h>
@@ -141,6 +142,16 @@ int main(int argc, char* argv[])
 	else
 		ed::Logger::Get().Log("Failed to initialize glslang", true);
 
+	// render the project to files and quit - no window or UI
+	if (coptsParser.Render) {
+		ed::HeadlessRenderer headless;
+		int ret = headless.Run(coptsParser);
+
+		ed::Logger::Get().Save();
+
+		return ret;
+	}
+
 	// init sdl2
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_AUDIO) < 0) {
 		ed::Logger::Get().Log("Failed to initialize SDL2", true);
@@ -0,0 +1,285 @@
+#include <SHADERed/Engine/BVH.h>
+#include <SHADERed/Engine/Ray.h>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BVH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace ed {
+	namespace eng {
+		namespace {
+			struct Bounds {
+				glm::vec3 Min = glm::vec3(std::numeric_limits<float>::infinity());
+				glm::vec3 Max = glm::vec3(-std::numeric_limits<float>::infinity());
+
+				inline void Grow(const glm::vec3& p)
+				{
+					Min = glm::min(Min, p);
+					Max = glm::max(Max, p);
+				}
+				inline void Grow(const Bounds& b)
+				{
+					Min = glm::min(Min, b.Min);
+					Max = glm::max(Max, b.Max);
+				}
+				inline float Area() const
+				{
+					glm::vec3 e = Max - Min;
+					if (e.x < 0.0f) return 0.0f; // empty
+					return e.x * e.y + e.y * e.z + e.z * e.x;
+				}
+			};
+
+			struct Ray {
+#if defined(BVH_USE_SSE)
+				__m128 Origin, InvDir;
+#else
+				glm::vec3 Origin, InvDir;
+#endif
+			};
+
+			// returns the entry distance or infinity if the box is missed or further away than maxDist
+			inline float intersectBox(const float* minp, const float* maxp, const Ray& ray, float maxDist)
+			{
+#if defined(BVH_USE_SSE)
+				// the 4th lane holds LeftFirst/Count and is never read back
+				__m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(minp), ray.Origin), ray.InvDir);
+				__m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(maxp), ray.Origin), ray.InvDir);
+				__m128 tmin = _mm_min_ps(t1, t2);
+				__m128 tmax = _mm_max_ps(t1, t2);
+
+				__m128 tnear4 = _mm_max_ss(_mm_max_ss(tmin, _mm_shuffle_ps(tmin, tmin, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(tmin, tmin, _MM_SHUFFLE(2, 2, 2, 2)));
+				__m128 tfar4 = _mm_min_ss(_mm_min_ss(tmax, _mm_shuffle_ps(tmax, tmax, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(tmax, tmax, _MM_SHUFFLE(2, 2, 2, 2)));
+
+				float tnear = _mm_cvtss_f32(tnear4);
+				float tfar = _mm_cvtss_f32(tfar4);
+#else
+				glm::vec3 t1 = (glm::vec3(minp[0], minp[1], minp[2]) - ray.Origin) * ray.InvDir;
+				glm::vec3 t2 = (glm::vec3(maxp[0], maxp[1], maxp[2]) - ray.Origin) * ray.InvDir;
+				glm::vec3 tmin = glm::min(t1, t2);
+				glm::vec3 tmax = glm::max(t1, t2);
+
+				float tnear = std::max<float>(std::max<float>(tmin.x, tmin.y), tmin.z);
+				float tfar = std::min<float>(std::min<float>(tmax.x, tmax.y), tmax.z);
+#endif
+				if (tfar >= tnear && tfar > 0.0f && tnear < maxDist)
+					return tnear;
+				return std::numeric_limits<float>::infinity();
+			}
+		}
+
+		void BVH::Clear()
+		{
+			m_nodes.clear();
+			m_positions.clear();
+			m_indices.clear();
+		}
+		void BVH::Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+		{
+			Clear();
+
+			m_positions = positions;
+			if (indices.empty()) {
+				m_indices.resize(positions.size() - positions.size() % 3);
+				for (unsigned int i = 0; i < m_indices.size(); i++)
+					m_indices[i] = i;
+			} else
+				m_indices.assign(indices.begin(), indices.begin() + (indices.size() - indices.size() % 3));
+
+			unsigned int triCount = m_indices.size() / 3;
+			if (triCount == 0)
+				return;
+
+			// per triangle bounds & centroids
+			std::vector<Bounds> triBounds(triCount);
+			std::vector<glm::vec3> centroids(triCount);
+			std::vector<unsigned int> order(triCount);
+			for (unsigned int i = 0; i < triCount; i++) {
+				for (int j = 0; j < 3; j++) {
+					unsigned int index = m_indices[i * 3 + j];
+					triBounds[i].Grow(index < m_positions.size() ? m_positions[index] : glm::vec3(0.0f));
+				}
+				centroids[i] = (triBounds[i].Min + triBounds[i].Max) * 0.5f;
+				order[i] = i;
+			}
+
+			m_nodes.reserve(triCount * 2);
+
+			Node root;
+			root.LeftFirst = 0;
+			root.Count = triCount;
+			m_nodes.push_back(root);
+
+			std::vector<std::pair<unsigned int, int>> stack; // node & depth
+			stack.push_back(std::make_pair(0u, 0));
+
+			while (!stack.empty()) {
+				unsigned int nodeIndex = stack.back().first;
+				int depth = stack.back().second;
+				stack.pop_back();
+
+				unsigned int first = m_nodes[nodeIndex].LeftFirst;
+				unsigned int count = m_nodes[nodeIndex].Count;
+
+				Bounds nodeBounds, centroidBounds;
+				for (unsigned int i = first; i < first + count; i++) {
+					nodeBounds.Grow(triBounds[order[i]]);
+					centroidBounds.Grow(centroids[order[i]]);
+				}
+				m_nodes[nodeIndex].Min = nodeBounds.Min;
+				m_nodes[nodeIndex].Max = nodeBounds.Max;
+
+				if (count <= 2 || depth >= BVH_MAX_DEPTH - 1)
+					continue;
+
+				// find the cheapest split plane with binned SAH
+				float bestCost = std::numeric_limits<float>::infinity();
+				int bestAxis = -1, bestSplit = 0;
+				for (int axis = 0; axis < 3; axis++) {
+					float extent = centroidBounds.Max[axis] - centroidBounds.Min[axis];
+					if (extent <= 0.0f)
+						continue;
+
+					Bounds bins[BVH_BIN_COUNT];
+					unsigned int binCount[BVH_BIN_COUNT] = { 0 };
+					float scale = BVH_BIN_COUNT / extent;
+					for (unsigned int i = first; i < first + count; i++) {
+						int bin = std::min<int>(BVH_BIN_COUNT - 1, (int)((centroids[order[i]][axis] - centroidBounds.Min[axis]) * scale));
+						bins[bin].Grow(triBounds[order[i]]);
+						binCount[bin]++;
+					}
+
+					// sweep from both sides
+					float leftArea[BVH_BIN_COUNT - 1], rightArea[BVH_BIN_COUNT - 1];
+					unsigned int leftCount[BVH_BIN_COUNT - 1], rightCount[BVH_BIN_COUNT - 1];
+					Bounds leftBox, rightBox;
+					unsigned int leftSum = 0, rightSum = 0;
+					for (int i = 0; i < BVH_BIN_COUNT - 1; i++) {
+						leftSum += binCount[i];
+						leftCount[i] = leftSum;
+						leftBox.Grow(bins[i]);
+						leftArea[i] = leftBox.Area();
+
+						rightSum += binCount[BVH_BIN_COUNT - 1 - i];
+						rightCount[BVH_BIN_COUNT - 2 - i] = rightSum;
+						rightBox.Grow(bins[BVH_BIN_COUNT - 1 - i]);
+						rightArea[BVH_BIN_COUNT - 2 - i] = rightBox.Area();
+					}
+
+					for (int i = 0; i < BVH_BIN_COUNT - 1; i++) {
+						float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+						if (cost < bestCost) {
+							bestCost = cost;
+							bestAxis = axis;
+							bestSplit = i;
+						}
+					}
+				}
+
+				// splitting doesn't pay off
+				float leafCost = count * nodeBounds.Area();
+				if (bestAxis == -1 || (bestCost >= leafCost && count <= BVH_MAX_LEAF_SIZE))
+					continue;
+
+				// partition the triangles
+				float splitMin = centroidBounds.Min[bestAxis];
+				float splitScale = BVH_BIN_COUNT / (centroidBounds.Max[bestAxis] - splitMin);
+				unsigned int* mid = std::partition(order.data() + first, order.data() + first + count, [&](unsigned int tri) {
+					int bin = std::min<int>(BVH_BIN_COUNT - 1, (int)((centroids[tri][bestAxis] - splitMin) * splitScale));
+					return bin <= bestSplit;
+				});
+				unsigned int leftCount = mid - (order.data() + first);
+				if (leftCount == 0 || leftCount == count)
+					continue;
+
+				Node left, right;
+				left.LeftFirst = first;
+				left.Count = leftCount;
+				right.LeftFirst = first + leftCount;
+				right.Count = count - leftCount;
+
+				unsigned int leftIndex = m_nodes.size();
+				m_nodes.push_back(left);
+				m_nodes.push_back(right);
+
+				m_nodes[nodeIndex].LeftFirst = leftIndex;
+				m_nodes[nodeIndex].Count = 0;
+
+				stack.push_back(std::make_pair(leftIndex, depth + 1));
+				stack.push_back(std::make_pair(leftIndex + 1, depth + 1));
+			}
+
+			// store the triangles in leaf order
+			std::vector<unsigned int> sorted(m_indices.size());
+			for (unsigned int i = 0; i < triCount; i++)
+				for (int j = 0; j < 3; j++)
+					sorted[i * 3 + j] = m_indices[order[i] * 3 + j];
+			m_indices = std::move(sorted);
+		}
+		bool BVH::Intersect(const glm::vec3& orig, const glm::vec3& dir, float& distHit, float maxDist) const
+		{
+			if (m_nodes.empty())
+				return false;
+
+			Ray ray;
+			glm::vec3 invDir = 1.0f / dir;
+#if defined(BVH_USE_SSE)
+			ray.Origin = _mm_set_ps(0.0f, orig.z, orig.y, orig.x);
+			ray.InvDir = _mm_set_ps(0.0f, invDir.z, invDir.y, invDir.x);
+#else
+			ray.Origin = orig;
+			ray.InvDir = invDir;
+#endif
+
+			float best = maxDist;
+			bool hit = false;
+
+			if (intersectBox(&m_nodes[0].Min.x, &m_nodes[0].Max.x, ray, best) == std::numeric_limits<float>::infinity())
+				return false;
+
+			unsigned int stack[BVH_MAX_DEPTH * 2];
+			int stackSize = 0;
+			stack[stackSize++] = 0;
+
+			while (stackSize > 0) {
+				const Node& node = m_nodes[stack[--stackSize]];
+
+				if (node.Count > 0) {
+					for (unsigned int i = node.LeftFirst; i < node.LeftFirst + node.Count; i++) {
+						unsigned int i0 = m_indices[i * 3 + 0], i1 = m_indices[i * 3 + 1], i2 = m_indices[i * 3 + 2];
+						if (i0 >= m_positions.size() || i1 >= m_positions.size() || i2 >= m_positions.size())
+							continue;
+
+						float triDist;
+						if (ray::IntersectTriangle(orig, dir, m_positions[i0], m_positions[i1], m_positions[i2], triDist) && triDist < best) {
+							best = triDist;
+							hit = true;
+						}
+					}
+					continue;
+				}
+
+				// visit the closer child first
+				unsigned int nearChild = node.LeftFirst, farChild = node.LeftFirst + 1;
+				float nearDist = intersectBox(&m_nodes[nearChild].Min.x, &m_nodes[nearChild].Max.x, ray, best);
+				float farDist = intersectBox(&m_nodes[farChild].Min.x, &m_nodes[farChild].Max.x, ray, best);
+				if (farDist < nearDist) {
+					std::swap(nearChild, farChild);
+					std::swap(nearDist, farDist);
+				}
+
+				if (farDist < best)
+					stack[stackSize++] = farChild;
+				if (nearDist < best)
+					stack[stackSize++] = nearChild;
+			}
+
+			if (hit)
+				distHit = best;
+
+			return hit;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <limits>
+#include <vector>
+
+#define BVH_BIN_COUNT 12
+#define BVH_MAX_LEAF_SIZE 4
+#define BVH_MAX_DEPTH 64
+
+namespace ed {
+	namespace eng {
+		// bounding volume hierarchy (binned SAH) over a triangle list - used for picking
+		class BVH {
+		public:
+			// indices can be empty - every three consecutive positions then form a triangle
+			void Build(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+			void Clear();
+
+			// distHit is in the units of dir (same as ray::IntersectTriangle), only hits closer than maxDist are reported
+			bool Intersect(const glm::vec3& orig, const glm::vec3& dir, float& distHit, float maxDist = std::numeric_limits<float>::infinity()) const;
+
+			inline bool IsBuilt() const { return !m_nodes.empty(); }
+			inline size_t GetTriangleCount() const { return m_indices.size() / 3; }
+			inline size_t GetNodeCount() const { return m_nodes.size(); }
+
+		private:
+			// 32 bytes - Min & Max can be loaded straight into SSE registers
+			struct Node {
+				glm::vec3 Min;
+				unsigned int LeftFirst; // first child if Count == 0, otherwise first triangle
+				glm::vec3 Max;
+				unsigned int Count;		// number of triangles in a leaf
+			};
+
+			std::vector<Node> m_nodes;
+			std::vector<glm::vec3> m_positions;
+			std::vector<unsigned int> m_indices; // triangles are sorted so that every leaf is a contiguous range
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <SHADERed/Engine/FFT.h>
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FFT_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace ed {
+	namespace eng {
+		FFT::FFT(int size)
+				: m_size(size)
+				, m_bitReverse(size)
+				, m_twiddleRe(size)
+				, m_twiddleIm(size)
+		{
+			int bits = 0;
+			while ((1 << bits) < size)
+				bits++;
+
+			for (int i = 0; i < size; i++) {
+				int rev = 0;
+				for (int b = 0; b < bits; b++)
+					rev |= ((i >> b) & 1) << (bits - 1 - b);
+				m_bitReverse[i] = rev;
+			}
+
+			// e^(-2*pi*i*k/len) for every stage
+			for (int half = 1; half < size; half *= 2) {
+				for (int k = 0; k < half; k++) {
+					double angle = -M_PI * k / half;
+					m_twiddleRe[half - 1 + k] = cos(angle);
+					m_twiddleIm[half - 1 + k] = sin(angle);
+				}
+			}
+			m_twiddleRe[size - 1] = m_twiddleIm[size - 1] = 0.0f; // unused
+		}
+		void FFT::Compute(float* re, float* im) const
+		{
+			for (int half = 1; half < m_size; half *= 2) {
+				const float* twRe = &m_twiddleRe[half - 1];
+				const float* twIm = &m_twiddleIm[half - 1];
+
+				for (int start = 0; start < m_size; start += half * 2) {
+					float* aRe = re + start;
+					float* aIm = im + start;
+					float* bRe = aRe + half;
+					float* bIm = aIm + half;
+
+					int k = 0;
+#if defined(FFT_USE_SSE)
+					// four butterflies at once
+					for (; k + 4 <= half; k += 4) {
+						__m128 wr = _mm_loadu_ps(twRe + k), wi = _mm_loadu_ps(twIm + k);
+						__m128 xr = _mm_loadu_ps(bRe + k), xi = _mm_loadu_ps(bIm + k);
+						__m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+						__m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+
+						__m128 ur = _mm_loadu_ps(aRe + k), ui = _mm_loadu_ps(aIm + k);
+						_mm_storeu_ps(aRe + k, _mm_add_ps(ur, tr));
+						_mm_storeu_ps(aIm + k, _mm_add_ps(ui, ti));
+						_mm_storeu_ps(bRe + k, _mm_sub_ps(ur, tr));
+						_mm_storeu_ps(bIm + k, _mm_sub_ps(ui, ti));
+					}
+#endif
+					for (; k < half; k++) {
+						float tr = bRe[k] * twRe[k] - bIm[k] * twIm[k];
+						float ti = bRe[k] * twIm[k] + bIm[k] * twRe[k];
+
+						bRe[k] = aRe[k] - tr;
+						bIm[k] = aIm[k] - ti;
+						aRe[k] += tr;
+						aIm[k] += ti;
+					}
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+
+namespace ed {
+	namespace eng {
+		// in-place iterative radix-2 FFT over separate real/imaginary arrays - the tables are built once for the given size
+		class FFT {
+		public:
+			FFT(int size); // has to be a power of two
+
+			inline int GetSize() const { return m_size; }
+			inline int GetBitReversed(int index) const { return m_bitReverse[index]; }
+
+			// re & im hold GetSize() values each, the input has to be stored in bit reversed order (see GetBitReversed)
+			void Compute(float* re, float* im) const;
+
+		private:
+			int m_size;
+			std::vector<int> m_bitReverse;
+
+			// twiddles are stored stage after stage: stage with N butterflies per group starts at [N - 1]
+			std::vector<float> m_twiddleRe, m_twiddleIm;
+		};
+	}
+}
\ No newline at end of file
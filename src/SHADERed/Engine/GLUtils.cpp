@@ -1,6 +1,7 @@
 #include <SHADERed/Engine/GLUtils.h>
 #include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/ObjectManager.h>
+#include <algorithm>
 #include <sstream>
 #include <string>
 
@@ -143,7 +144,7 @@ namespace ed {
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
 
-		void CreateVAO(GLuint& geoVAO, GLuint geoVBO, const std::vector<InputLayoutItem>& ilayout, GLuint geoEBO, GLuint bufVBO, std::vector<ed::ShaderVariable::ValueType> types)
+		void CreateVAO(GLuint& geoVAO, GLuint geoVBO, const std::vector<InputLayoutItem>& ilayout, GLuint geoEBO, GLuint bufVBO, std::vector<ed::ShaderVariable::ValueType> types, unsigned int attribMask, bool packed)
 		{
 			int fmtIndex = 0;
 
@@ -154,11 +155,29 @@ namespace ed {
 			glBindBuffer(GL_ARRAY_BUFFER, geoVBO);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geoEBO);
 
-			for (const auto& layitem : ilayout) {
-				// vertex positions
-				glVertexAttribPointer(fmtIndex, InputLayoutItem::GetValueSize(layitem.Value), GL_FLOAT, GL_FALSE, 18 * sizeof(float), (void*)(InputLayoutItem::GetValueOffset(layitem.Value) * sizeof(GLfloat)));
-				glEnableVertexAttribArray(fmtIndex);
-				fmtIndex++;
+			if (attribMask == 0) {
+				for (const auto& layitem : ilayout) {
+					// vertex positions
+					glVertexAttribPointer(fmtIndex, InputLayoutItem::GetValueSize(layitem.Value), GL_FLOAT, GL_FALSE, 18 * sizeof(float), (void*)(InputLayoutItem::GetValueOffset(layitem.Value) * sizeof(GLfloat)));
+					glEnableVertexAttribArray(fmtIndex);
+					fmtIndex++;
+				}
+			} else {
+				GLsizei stride = InputLayoutItem::GetPackedStride(attribMask, packed);
+				for (const auto& layitem : ilayout) {
+					void* offset = (void*)InputLayoutItem::GetPackedOffset(layitem.Value, attribMask, packed);
+
+					if (!packed || layitem.Value == InputLayoutValue::Position)
+						glVertexAttribPointer(fmtIndex, InputLayoutItem::GetValueSize(layitem.Value), GL_FLOAT, GL_FALSE, stride, offset);
+					else if (layitem.Value == InputLayoutValue::Texcoord)
+						glVertexAttribPointer(fmtIndex, 2, GL_HALF_FLOAT, GL_FALSE, stride, offset);
+					else if (layitem.Value == InputLayoutValue::Color)
+						glVertexAttribPointer(fmtIndex, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, offset);
+					else
+						glVertexAttribPointer(fmtIndex, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, offset);
+					glEnableVertexAttribArray(fmtIndex);
+					fmtIndex++;
+				}
 			}
 
 			// user defined
@@ -253,6 +272,41 @@ namespace ed {
 
 			free(bufPtr);
 		}
+		bool GetVertexBufferPositions(ObjectManager* objs, pipe::VertexBuffer* model, std::vector<glm::vec3>& positions)
+		{
+			BufferObject* buffer = (BufferObject*)model->Buffer;
+			if (buffer == nullptr)
+				return false;
+
+			std::vector<ShaderVariable::ValueType> tData = objs->ParseBufferFormat(buffer->ViewFormat);
+			if (tData.size() == 0)
+				return false;
+
+			ShaderVariable::ValueType posType = tData[0];
+			if (posType != ShaderVariable::ValueType::Float2 && posType != ShaderVariable::ValueType::Float3 && posType != ShaderVariable::ValueType::Float4)
+				return false;
+
+			int stride = 0;
+			for (const auto& dataEl : tData)
+				stride += ShaderVariable::GetSize(dataEl, true);
+
+			std::vector<char> data(buffer->Size);
+			glBindBuffer(GL_ARRAY_BUFFER, buffer->ID);
+			glGetBufferSubData(GL_ARRAY_BUFFER, 0, buffer->Size, data.data());
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			int rows = buffer->Size / stride;
+			int elCount = std::min<int>(3, ShaderVariable::GetSize(posType) / 4);
+
+			positions.resize(rows);
+			for (int r = 0; r < rows; r++) {
+				float pos[3] = { 0.0f, 0.0f, 0.0f };
+				memcpy(pos, data.data() + r * stride, elCount * sizeof(float));
+				positions[r] = glm::vec3(pos[0], pos[1], pos[2]);
+			}
+
+			return true;
+		}
 
 		bool isAllDigits(const std::string& str)
 		{
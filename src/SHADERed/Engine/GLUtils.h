@@ -29,9 +29,11 @@ namespace ed {
 		std::vector<MessageStack::Message> ParseGlslangMessages(const std::string& owner, ShaderStage stage, const std::string& str);
 
 		void CreateBufferVAO(GLuint& geoVAO, GLuint geoVBO, const std::vector<ed::ShaderVariable::ValueType>& ilayout);
-		void CreateVAO(GLuint& geoVAO, GLuint geoVBO, const std::vector<InputLayoutItem>& ilayout, GLuint geoEBO = 0, GLuint bufVBO = 0, std::vector<ed::ShaderVariable::ValueType> types = std::vector<ed::ShaderVariable::ValueType>());
+		// attribMask == 0: geoVBO has the 18 float layout, otherwise it's a compact buffer (see InputLayoutItem::GetPackedOffset())
+		void CreateVAO(GLuint& geoVAO, GLuint geoVBO, const std::vector<InputLayoutItem>& ilayout, GLuint geoEBO = 0, GLuint bufVBO = 0, std::vector<ed::ShaderVariable::ValueType> types = std::vector<ed::ShaderVariable::ValueType>(), unsigned int attribMask = 0, bool packed = false);
 
 		void GetVertexBufferBounds(ObjectManager* objs, pipe::VertexBuffer* model, glm::vec3& minPosItem, glm::vec3& maxPosItem);
+		bool GetVertexBufferPositions(ObjectManager* objs, pipe::VertexBuffer* model, std::vector<glm::vec3>& positions); // first element of every row
 
 		std::vector<InputLayoutItem> CreateDefaultInputLayout();
 	}
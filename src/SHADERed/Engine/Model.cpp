@@ -1,5 +1,9 @@
+#include <SHADERed/Engine/GLUtils.h>
 #include <SHADERed/Engine/Model.h>
+#include <SHADERed/Engine/Timer.h>
 #include <SHADERed/Objects/Logger.h>
+#include <SHADERed/Objects/Settings.h>
+#include <glm/gtc/packing.hpp>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -21,18 +25,19 @@ namespace ed {
 			Vertices = vertices;
 			Indices = indices;
 			Textures = textures;
-			m_setup();
+			VAO = VBO = EBO = 0;
+			m_vboMask = 0;
+			m_vboPacked = false;
 		}
 		void Model::Mesh::m_setup()
 		{
+			m_upload((1u << (int)InputLayoutValue::MaxCount) - 1, false);
+
 			glGenVertexArrays(1, &VAO);
-			glGenBuffers(1, &VBO);
 			glGenBuffers(1, &EBO);
 			glBindVertexArray(VAO);
 
 			glBindBuffer(GL_ARRAY_BUFFER, VBO);
-			glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), &Vertices[0],
-				GL_STATIC_DRAW);
 
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 			glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(unsigned int),
@@ -52,6 +57,87 @@ namespace ed {
 
 			glBindVertexArray(0);
 		}
+		void Model::Mesh::m_upload(unsigned int mask, bool packed)
+		{
+			if (VBO != 0 && mask == m_vboMask && packed == m_vboPacked)
+				return;
+
+			if (VBO == 0)
+				glGenBuffers(1, &VBO);
+			m_vboMask = mask;
+			m_vboPacked = packed;
+
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+			if (mask == (1u << (int)InputLayoutValue::MaxCount) - 1 && !packed)
+				glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), Vertices.data(), GL_STATIC_DRAW);
+			else {
+				std::vector<char> data(Vertices.size() * InputLayoutItem::GetPackedStride(mask, packed));
+				char* dst = data.data();
+				auto write = [&](const void* src, size_t size) {
+					memcpy(dst, src, size);
+					dst += size;
+				};
+				auto has = [mask](InputLayoutValue val) {
+					return (mask & (1u << (int)val)) != 0;
+				};
+
+				// same order as InputLayoutValue
+				for (const auto& v : Vertices) {
+					if (has(InputLayoutValue::Position))
+						write(&v.Position, sizeof(glm::vec3));
+
+					if (packed) {
+						uint32_t val;
+						if (has(InputLayoutValue::Normal)) {
+							val = glm::packSnorm3x10_1x2(glm::vec4(v.Normal, 0.0f));
+							write(&val, sizeof(val));
+						}
+						if (has(InputLayoutValue::Texcoord)) {
+							val = glm::packHalf2x16(v.TexCoords);
+							write(&val, sizeof(val));
+						}
+						if (has(InputLayoutValue::Tangent)) {
+							val = glm::packSnorm3x10_1x2(glm::vec4(v.Tangent, 0.0f));
+							write(&val, sizeof(val));
+						}
+						if (has(InputLayoutValue::Binormal)) {
+							val = glm::packSnorm3x10_1x2(glm::vec4(v.Binormal, 0.0f));
+							write(&val, sizeof(val));
+						}
+						if (has(InputLayoutValue::Color)) {
+							val = glm::packUnorm4x8(v.Color);
+							write(&val, sizeof(val));
+						}
+					} else {
+						if (has(InputLayoutValue::Normal))
+							write(&v.Normal, sizeof(glm::vec3));
+						if (has(InputLayoutValue::Texcoord))
+							write(&v.TexCoords, sizeof(glm::vec2));
+						if (has(InputLayoutValue::Tangent))
+							write(&v.Tangent, sizeof(glm::vec3));
+						if (has(InputLayoutValue::Binormal))
+							write(&v.Binormal, sizeof(glm::vec3));
+						if (has(InputLayoutValue::Color))
+							write(&v.Color, sizeof(glm::vec4));
+					}
+				}
+
+				glBufferData(GL_ARRAY_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+			}
+
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		void Model::Mesh::CreateVAO(const std::vector<InputLayoutItem>& ilayout, unsigned int bufVBO, const std::vector<ShaderVariable::ValueType>& types)
+		{
+			unsigned int mask = InputLayoutItem::GetValueMask(ilayout);
+			if (mask == 0)
+				mask = 1u << (int)InputLayoutValue::Position; // nothing is read, but keep something in the VBO
+
+			m_upload(mask, Settings::Instance().Preview.PackVertices);
+
+			gl::CreateVAO(VAO, VBO, ilayout, EBO, bufVBO, types, m_vboMask, m_vboPacked);
+		}
 		void Model::Mesh::Draw(bool instanced, int iCount)
 		{
 			// draw mesh
@@ -63,6 +149,11 @@ namespace ed {
 				glDrawElements(GL_TRIANGLES, Indices.size(), GL_UNSIGNED_INT, 0);
 		}
 
+		Model::Model()
+		{
+			m_minBound = m_maxBound = glm::vec3(0.0f);
+			m_uploaded = false;
+		}
 		Model::~Model()
 		{
 			for (int i = 0; i < Meshes.size(); i++) {
@@ -72,27 +163,54 @@ namespace ed {
 			}
 		}
 
-		bool Model::LoadFromFile(const std::string& path)
+		bool Model::LoadFromFile(const std::string& path, bool optimize)
 		{
 			ed::Logger::Get().Log("Loading a 3D model " + path);
 
+			if (!Import(path, optimize)) {
+				ed::Logger::Get().Log("Assimp has detected an error \"" + m_importError + "\"", true);
+				return false;
+			}
+
+			Upload();
+
+			return true;
+		}
+		bool Model::Import(const std::string& path, bool optimize)
+		{
+			unsigned int flags = aiProcess_Triangulate | aiProcess_FlipUVs;
+			if (optimize)
+				flags |= aiProcess_JoinIdenticalVertices | aiProcess_ImproveCacheLocality;
+
 			// read file via ASSIMP
 			Assimp::Importer importer;
-			const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+			const aiScene* scene = importer.ReadFile(path, flags);
 
 			// check for errors
 			if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
 			{
-				ed::Logger::Get().Log("Assimp has detected an error \"" + std::string(importer.GetErrorString()) + "\"", true);
+				m_importError = importer.GetErrorString();
 				return false;
 			}
 
 			Directory = path.substr(0, path.find_last_of("/\\"));
 			m_processNode(scene->mRootNode, scene);
 
+			return true;
+		}
+		void Model::Upload()
+		{
+			Meshes.insert(Meshes.end(), m_imported.begin(), m_imported.end());
+			m_imported.clear();
+
+			for (auto& mesh : Meshes)
+				if (mesh.VAO == 0)
+					mesh.m_setup();
+
 			m_findBounds();
+			m_bvh.clear();
 
-			return true;
+			m_uploaded = true;
 		}
 		void Model::m_findBounds()
 		{
@@ -110,6 +228,34 @@ namespace ed {
 				}
 			}
 		}
+		bool Model::Intersect(const glm::vec3& orig, const glm::vec3& dir, float& distHit, float maxDist)
+		{
+			if (m_bvh.size() != Meshes.size()) {
+				eng::Timer buildTimer;
+
+				m_bvh.resize(Meshes.size());
+				for (int i = 0; i < Meshes.size(); i++) {
+					std::vector<glm::vec3> positions(Meshes[i].Vertices.size());
+					for (int j = 0; j < positions.size(); j++)
+						positions[j] = Meshes[i].Vertices[j].Position;
+
+					m_bvh[i].Build(positions, Meshes[i].Indices);
+				}
+
+				ed::Logger::Get().Log("Built the picking BVH for a 3D model in " + std::to_string(buildTimer.GetElapsedTime() * 1000.0f) + "ms");
+			}
+
+			bool hit = false;
+			for (const auto& bvh : m_bvh) {
+				float meshDist;
+				if (bvh.Intersect(orig, dir, meshDist, maxDist)) {
+					maxDist = distHit = meshDist;
+					hit = true;
+				}
+			}
+
+			return hit;
+		}
 		std::vector<std::string> Model::GetMeshNames()
 		{
 			std::vector<std::string> ret;
@@ -132,7 +278,7 @@ namespace ed {
 		{
 			for (unsigned int i = 0; i < node->mNumMeshes; i++) {
 				aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-				Meshes.push_back(m_processMesh(mesh, scene));
+				m_imported.push_back(m_processMesh(mesh, scene));
 			}
 
 			for (unsigned int i = 0; i < node->mNumChildren; i++)
@@ -1,4 +1,7 @@
 #pragma once
+#include <SHADERed/Engine/BVH.h>
+#include <SHADERed/Objects/InputLayout.h>
+#include <SHADERed/Objects/ShaderVariable.h>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
@@ -35,28 +38,56 @@ namespace ed {
 
 				void Draw(bool instanced = false, int iCount = 0);
 
+				// recreates the VAO for a pass' input layout - the VBO is uploaded again with only the attributes that
+				// the layout reads (packed if Preview.PackVertices is on). the VBO starts with the whole Vertex struct
+				void CreateVAO(const std::vector<InputLayoutItem>& ilayout, unsigned int bufVBO = 0, const std::vector<ShaderVariable::ValueType>& types = std::vector<ShaderVariable::ValueType>());
+
 				unsigned int VAO, VBO, EBO;
 
 			private:
+				friend class Model;
 				void m_setup();
+				void m_upload(unsigned int mask, bool packed);
+
+				unsigned int m_vboMask; // attributes stored in VBO
+				bool m_vboPacked;
 			};
 
+			Model();
 			~Model();
 
 			std::vector<Mesh> Meshes;
 			std::string Directory;
 
 			std::vector<std::string> GetMeshNames();
-			bool LoadFromFile(const std::string& path);
+
+			// optimize: merge identical vertices & reorder the triangles for the post-transform vertex cache
+			// (fewer vertices, but their order and the vertex IDs won't match the file anymore)
+			bool LoadFromFile(const std::string& path, bool optimize = false);
+
+			// LoadFromFile() split in two: Import() only runs assimp (safe to call from a worker thread),
+			// Upload() has to be called on the main thread afterwards to create the GL buffers
+			bool Import(const std::string& path, bool optimize = false);
+			void Upload();
+			inline bool IsUploaded() { return m_uploaded; }
 			void Draw(bool instanced = false, int iCount = 0);
 			void Draw(const std::string& mesh);
 
 			inline glm::vec3 GetMinBound() { return m_minBound; }
 			inline glm::vec3 GetMaxBound() { return m_maxBound; }
 
+			// ray in model space - the BVHs are built on the first call
+			bool Intersect(const glm::vec3& orig, const glm::vec3& dir, float& distHit, float maxDist = std::numeric_limits<float>::infinity());
+
 		private:
 			void m_findBounds();
 
+			std::vector<BVH> m_bvh; // one per mesh
+
+			std::vector<Mesh> m_imported; // filled by Import(), moved to Meshes in Upload()
+			std::string m_importError;
+			bool m_uploaded;
+
 			glm::vec3 m_minBound, m_maxBound;
 			void m_processNode(aiNode* node, const aiScene* scene);
 			Model::Mesh m_processMesh(aiMesh* mesh, const aiScene* scene);
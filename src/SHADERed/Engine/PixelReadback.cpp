@@ -0,0 +1,84 @@
+#include <SHADERed/Engine/PixelReadback.h>
+#include <SHADERed/Objects/Logger.h>
+#include <string.h>
+
+namespace ed {
+	namespace eng {
+		PixelReadback::PixelReadback()
+		{
+			m_fbo = m_pbo = 0;
+			m_capacity = m_count = 0;
+		}
+		PixelReadback::~PixelReadback()
+		{
+			if (m_fbo != 0)
+				glDeleteFramebuffers(1, &m_fbo);
+			if (m_pbo != 0)
+				glDeleteBuffers(1, &m_pbo);
+		}
+		void PixelReadback::Begin(int pixelCount)
+		{
+			if (m_fbo == 0) {
+				glGenFramebuffers(1, &m_fbo);
+				glGenBuffers(1, &m_pbo);
+			}
+
+			if (pixelCount > m_capacity) {
+				m_capacity = pixelCount;
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+				glBufferData(GL_PIXEL_PACK_BUFFER, m_capacity * 4, nullptr, GL_STREAM_READ);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+
+			m_count = 0;
+			m_data.assign(pixelCount * 4, 0);
+		}
+		int PixelReadback::Read(GLuint tex, int x, int y)
+		{
+			int index = m_count;
+			if (index >= m_capacity)
+				return -1;
+			m_count++;
+
+			// glGetTextureSubImage() needs GL 4.5 - a read framebuffer works everywhere
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+			glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, (void*)(uintptr_t)(index * 4));
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+			return index;
+		}
+		bool PixelReadback::Finish()
+		{
+			if (m_count == 0)
+				return true;
+
+			GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			GLenum waitRes = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			while (waitRes == GL_TIMEOUT_EXPIRED)
+				waitRes = glClientWaitSync(fence, 0, 1000000); // 1ms
+			glDeleteSync(fence);
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo);
+			void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_count * 4, GL_MAP_READ_BIT);
+			if (data != nullptr) {
+				memcpy(m_data.data(), data, m_count * 4);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			if (data == nullptr) {
+				Logger::Get().Log("Failed to map the pixel buffer", true);
+				return false;
+			}
+
+			return true;
+		}
+	}
+}
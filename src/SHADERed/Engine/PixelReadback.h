@@ -0,0 +1,48 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+namespace ed {
+	namespace eng {
+		// reads single pixels of many textures in one round trip: every Read() is queued into the same
+		// pixel pack buffer and Finish() waits on one fence and maps the buffer once
+		class PixelReadback {
+		public:
+			PixelReadback();
+			~PixelReadback();
+
+			// pixelCount - max number of Read() calls before Finish()
+			void Begin(int pixelCount);
+
+			// the pixel is copied on the GPU right away, so later draws to tex don't change the result
+			// returns the index of the result
+			int Read(GLuint tex, int x, int y);
+
+			bool Finish();
+
+			inline glm::vec4 GetColor(int index) const
+			{
+				const uint8_t* px = &m_data[index * 4];
+				return glm::vec4(px[0] / 255.0f, px[1] / 255.0f, px[2] / 255.0f, px[3] / 255.0f);
+			}
+			inline uint32_t GetID(int index) const
+			{
+				const uint8_t* px = &m_data[index * 4];
+				return ((uint32_t)px[0] << 0) | ((uint32_t)px[1] << 8) | ((uint32_t)px[2] << 16) | ((uint32_t)px[3] << 24);
+			}
+
+		private:
+			GLuint m_fbo, m_pbo;
+			int m_capacity, m_count;
+			std::vector<uint8_t> m_data;
+		};
+	}
+}
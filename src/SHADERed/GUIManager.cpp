@@ -3,6 +3,7 @@
 #include <SHADERed/InterfaceManager.h>
 #include <SHADERed/Objects/CameraSnapshots.h>
 #include <SHADERed/Objects/Export/ExportCPP.h>
+#include <SHADERed/Objects/FrameCapture.h>
 #include <SHADERed/Objects/FunctionVariableManager.h>
 #include <SHADERed/Objects/KeyboardShortcuts.h>
 #include <SHADERed/Objects/Logger.h>
@@ -362,6 +363,8 @@ namespace ed {
 	}
 	void GUIManager::Update(float delta)
 	{
+		m_data->Renderer.FlushVisibleRTs();
+
 		// add star to the titlebar if project was modified
 		if (m_cacheProjectModified != m_data->Parser.IsProjectModified()) {
 			std::string projName = m_data->Parser.GetOpenedFile();
@@ -486,14 +489,13 @@ namespace ed {
 			if (!m_recompiledAll) {
 				std::vector<bool> needsUpdate = ((CodeEditorUI*)Get(ViewID::Code))->TrackedNeedsUpdate();
 				std::vector<PipelineItem*> passes = m_data->Pipeline.GetList();
-				int ind = 0;
+				std::vector<PipelineItem*> changed;
 				if (needsUpdate.size() >= passes.size()) {
-					for (PipelineItem*& pass : passes) {
-						if (needsUpdate[ind])
-							m_data->Renderer.Recompile(pass->Name);
-						ind++;
-					}
+					for (int i = 0; i < passes.size(); i++)
+						if (needsUpdate[i])
+							changed.push_back(passes[i]);
 				}
+				m_data->Renderer.Recompile(changed);
 			}
 
 			((CodeEditorUI*)Get(ViewID::Code))->EmptyTrackedFiles();
@@ -1699,10 +1701,15 @@ namespace ed {
 			ImGui::TextWrapped("Path: %s", m_previewSavePath.c_str());
 			ImGui::SameLine();
 			if (ImGui::Button("...##save_prev_path"))
-				igfd::ImGuiFileDialog::Instance()->OpenModal("SavePreviewDlg", "Save", "Image file (*.png;*.jpg;*.jpeg;*.bmp;*.tga){.png,.jpg,.jpeg,.bmp,.tga},.*", ".");
+				igfd::ImGuiFileDialog::Instance()->OpenModal("SavePreviewDlg", "Save", "Image file (*.png;*.jpg;*.jpeg;*.bmp;*.tga){.png,.jpg,.jpeg,.bmp,.tga},Video file (*.mp4;*.mkv;*.webm;*.y4m;*.raw){.mp4,.mkv,.webm,.y4m,.raw},.*", ".");
 			if (igfd::ImGuiFileDialog::Instance()->FileDialog("SavePreviewDlg")) {
-				if (igfd::ImGuiFileDialog::Instance()->IsOk)
+				if (igfd::ImGuiFileDialog::Instance()->IsOk) {
 					m_previewSavePath = igfd::ImGuiFileDialog::Instance()->GetFilepathName();
+
+					// videos are always recorded as a sequence
+					if (FrameCapture::IsVideoFile(m_previewSavePath))
+						m_savePreviewSeq = true;
+				}
 				igfd::ImGuiFileDialog::Instance()->CloseDialog("SavePreviewDlg");
 			}
 
@@ -1726,7 +1733,7 @@ namespace ed {
 
 			ImGui::Separator();
 			if (ImGui::CollapsingHeader("Sequence")) {
-				ImGui::TextWrapped("Export a sequence of images");
+				ImGui::TextWrapped("Export a sequence of images or a video (.mp4, .mkv & .webm require ffmpeg, .y4m & .raw are written directly)");
 
 				/* RECORD */
 				ImGui::Text("Record:");
@@ -1845,7 +1852,7 @@ namespace ed {
 				SystemVariableManager::Instance().SetSavingToFile(true);
 
 				// normal render
-				if (!m_savePreviewSeq) {
+				if (!m_savePreviewSeq && !FrameCapture::IsVideoFile(m_previewSavePath)) {
 					if (actualSizeX > 0 && actualSizeY > 0) {
 						SystemVariableManager::Instance().CopyState();
 
@@ -1906,139 +1913,33 @@ namespace ed {
 
 						GLuint tex = m_data->Renderer.GetTexture();
 
-						size_t lastDot = m_previewSavePath.find_last_of('.');
-						std::string ext = lastDot == std::string::npos ? "png" : m_previewSavePath.substr(lastDot + 1);
-						std::string filename = m_previewSavePath;
-
-						// allow only one %??d
-						bool inFormat = false;
-						int lastFormatPos = -1;
-						int formatCount = 0;
-						for (int i = 0; i < filename.size(); i++) {
-							if (filename[i] == '%') {
-								inFormat = true;
-								lastFormatPos = i;
-								continue;
-							}
-
-							if (inFormat) {
-								if (isdigit(filename[i])) {
-								} else {
-									if (filename[i] != '%' && ((filename[i] == 'd' && formatCount > 0) || (filename[i] != 'd'))) {
-										filename.insert(lastFormatPos, 1, '%');
-									}
-
-									if (filename[i] == 'd')
-										formatCount++;
-									inFormat = false;
-								}
-							}
-						}
-
-						// no %d found? add one
-						if (formatCount == 0)
-							filename.insert(lastDot == std::string::npos ? filename.size() : lastDot, "%d"); // frame%d
+						std::string filename = FrameCapture::GetFilenameFormat(m_previewSavePath);
 
 						SystemVariableManager::Instance().AdvanceTimer(m_savePreviewCachedTime - m_savePreviewTimeDelta);
 						SystemVariableManager::Instance().SetTimeDelta(seqDelta);
 
-						stbi_write_png_compression_level = 5; // set to lowest compression level
-
-						int tCount = std::thread::hardware_concurrency();
-						tCount = tCount == 0 ? 2 : tCount;
-
-						unsigned char** pixels = new unsigned char*[tCount];
-						unsigned char** outPixels = new unsigned char*[tCount];
-						int* curFrame = new int[tCount];
-						bool* needsUpdate = new bool[tCount];
-						std::thread** threadPool = new std::thread*[tCount];
-						std::atomic<bool> isOver = false;
-
-						for (int i = 0; i < tCount; i++) {
-							curFrame[i] = 0;
-							needsUpdate[i] = true;
-							pixels[i] = (unsigned char*)malloc(actualSizeX * actualSizeY * 4);
-
-							if (sizeMulti != 1)
-								outPixels[i] = (unsigned char*)malloc(m_previewSaveSize.x * m_previewSaveSize.y * 4);
-							else
-								outPixels[i] = nullptr;
-
-							threadPool[i] = new std::thread([ext, filename, sizeMulti, actualSizeX, actualSizeY, &outPixels, &pixels, &needsUpdate, &curFrame, &isOver](int worker, int w, int h) {
-								char prevSavePath[SHADERED_MAX_PATH];
-								while (!isOver) {
-									if (needsUpdate[worker])
-										continue;
-
-									// resize image
-									if (sizeMulti != 1) {
-										stbir_resize_uint8(pixels[worker], actualSizeX, actualSizeY, actualSizeX * 4,
-											outPixels[worker], w, h, w * 4, 4);
-									} else
-										outPixels[worker] = pixels[worker];
-
-									sprintf(prevSavePath, filename.c_str(), curFrame[worker]);
-
-									if (ext == "jpg" || ext == "jpeg")
-										stbi_write_jpg(prevSavePath, w, h, 4, outPixels[worker], 100);
-									else if (ext == "bmp")
-										stbi_write_bmp(prevSavePath, w, h, 4, outPixels[worker]);
-									else if (ext == "tga")
-										stbi_write_tga(prevSavePath, w, h, 4, outPixels[worker]);
-									else
-										stbi_write_png(prevSavePath, w, h, 4, outPixels[worker], w * 4);
-
-									needsUpdate[worker] = true;
-								}
-							},
-								i, m_previewSaveSize.x, m_previewSaveSize.y);
-						}
+						// readback & encoding happen asynchronously while the next frames are rendered
+						FrameCapture capture;
+						bool started = capture.Start(filename, actualSizeX, actualSizeY, m_previewSaveSize.x, m_previewSaveSize.y, m_savePreviewSeqFPS);
+						if (!started)
+							m_data->Messages.Add(ed::MessageStack::Type::Error, "", "Failed to start capturing frames to " + m_previewSavePath);
 
 						int globalFrame = 0;
-						while (curTime < m_savePreviewSeqDuration) {
-							int hasWork = -1;
-							for (int i = 0; i < tCount; i++)
-								if (needsUpdate[i]) {
-									hasWork = i;
-									break;
-								}
-
-							if (hasWork == -1)
-								continue;
-
+						while (started && curTime < m_savePreviewSeqDuration) {
 							SystemVariableManager::Instance().CopyState();
 							SystemVariableManager::Instance().SetFrameIndex(m_savePreviewFrameIndex + globalFrame);
 
 							m_data->Renderer.Render(actualSizeX, actualSizeY);
 
-							glBindTexture(GL_TEXTURE_2D, tex);
-							glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels[hasWork]);
-							glBindTexture(GL_TEXTURE_2D, 0);
+							capture.Capture(tex, globalFrame);
 
 							SystemVariableManager::Instance().AdvanceTimer(seqDelta);
 
 							curTime += seqDelta;
-							curFrame[hasWork] = globalFrame;
-							needsUpdate[hasWork] = false;
 							globalFrame++;
 						}
-						isOver = true;
-
-						for (int i = 0; i < tCount; i++) {
-							if (threadPool[i]->joinable())
-								threadPool[i]->join();
-							free(pixels[i]);
-							if (sizeMulti != 1)
-								free(outPixels[i]);
-							delete threadPool[i];
-						}
-						delete[] pixels;
-						delete[] outPixels;
-						delete[] curFrame;
-						delete[] needsUpdate;
-						delete[] threadPool;
 
-						stbi_write_png_compression_level = 8; // set back to default compression level
+						capture.Finish();
 
 						rerenderPreview = true;
 					}
@@ -0,0 +1,415 @@
+#include <SHADERed/HeadlessRenderer.h>
+#include <SHADERed/InterfaceManager.h>
+#include <SHADERed/Objects/AssetLoader.h>
+#include <SHADERed/Objects/FrameCapture.h>
+#include <SHADERed/Objects/Logger.h>
+#include <SHADERed/Objects/Settings.h>
+#include <SHADERed/Objects/SystemVariableManager.h>
+#include <SHADERed/Engine/Timer.h>
+
+#include <GL/glew.h>
+
+#if defined(SHADERED_USE_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <SDL2/SDL.h>
+#endif
+
+#include <stb/stb_image_write.h>
+
+#include <stdio.h>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#define REFERENCE_TOLERANCE 2 // max channel difference (0-255) that still counts as a match
+
+namespace ed {
+	HeadlessRenderer::HeadlessRenderer()
+	{
+		m_data = nullptr;
+		m_display = nullptr;
+		m_surface = nullptr;
+		m_context = nullptr;
+	}
+	HeadlessRenderer::~HeadlessRenderer()
+	{
+		delete m_data;
+		m_destroyContext();
+	}
+	int HeadlessRenderer::Run(const CommandLineOptionParser& opts)
+	{
+		if (opts.RenderProject.empty()) {
+			printf("No project file given to --render\n");
+			return 1;
+		}
+
+		if (!m_createContext()) {
+			printf("Failed to create an offscreen OpenGL context\n");
+			return 1;
+		}
+
+		// init glew - GLEW_ERROR_NO_GLX_DISPLAY only means that GLEW couldn't
+		// query GLX extensions, the GL functions themselves are loaded fine
+		glewExperimental = true;
+		GLenum glewRes = glewInit();
+#if defined(GLEW_ERROR_NO_GLX_DISPLAY)
+		if (glewRes == GLEW_ERROR_NO_GLX_DISPLAY)
+			glewRes = GLEW_OK;
+#endif
+		if (glewRes != GLEW_OK) {
+			printf("Failed to initialize GLEW\n");
+			return 1;
+		}
+		glGetError(); // glewExperimental can leave GL_INVALID_ENUM behind
+
+		glEnable(GL_DEPTH_TEST);
+		glEnable(GL_STENCIL_TEST);
+
+		Settings::Instance().Load();
+
+		// the reference is compared to the contents of a render texture - it can't share its memory
+		if (!opts.ReferenceOutput.empty())
+			Settings::Instance().Preview.ShareRTMemory = false;
+
+		// plugins are not loaded - they all expect the GUI to exist
+		m_data = new InterfaceManager(nullptr);
+		m_data->Renderer.AllowComputeShaders(GLEW_ARB_compute_shader);
+
+		m_data->Parser.Open(opts.RenderProject);
+		if (m_data->Parser.GetOpenedFile() != opts.RenderProject) {
+			printf("Failed to open project %s\n", opts.RenderProject.c_str());
+			return 1;
+		}
+
+		// textures & models are loaded in the background - every frame has to see them
+		AssetLoader::Instance().Flush();
+
+		// deterministic clock: real time is frozen at 0 and only advanced manually by 1/fps
+		SystemVariableManager& sysVars = SystemVariableManager::Instance();
+		sysVars.GetTimeClock().Pause();
+		sysVars.Reset();
+		sysVars.SetSavingToFile(true);
+
+		float delta = 1.0f / opts.RenderFPS;
+		int width = opts.RenderWidth, height = opts.RenderHeight;
+
+		std::string filename = FrameCapture::GetFilenameFormat(opts.RenderOutput, opts.RenderFrames > 1);
+
+		float renderTime = 0.0f;
+		eng::Timer totalTimer, frameTimer;
+
+		// readback & image encoding overlap with the rendering of the next frames
+		FrameCapture capture;
+		if (!capture.Start(filename, width, height, width, height, opts.RenderFPS)) {
+			printf("Failed to start capturing frames\n");
+			return 1;
+		}
+
+		for (int frame = 0; frame < opts.RenderFrames; frame++) {
+			frameTimer.Restart();
+
+			sysVars.SetTimeDelta(delta);
+			m_data->Renderer.Render(width, height);
+			capture.Capture(m_data->Renderer.GetTexture(), frame);
+
+			renderTime += frameTimer.Restart();
+
+			// shaders are compiled on the first render
+			if (frame == 0) {
+				for (const auto& msg : m_data->Messages.GetMessages())
+					if (msg.MType == MessageStack::Type::Error)
+						printf("[%s] %s\n", msg.Group.c_str(), msg.Text.c_str());
+			}
+
+			// golden image - uses the same time & uniforms as the last GPU frame
+			if (frame == opts.RenderFrames - 1 && !opts.ReferenceOutput.empty()) {
+				m_renderReference(opts, width, height);
+				frameTimer.Restart();
+			}
+
+			sysVars.AdvanceTimer(delta);
+		}
+
+		capture.Finish();
+
+		float totalTime = totalTimer.GetElapsedTime();
+		int frameCount = opts.RenderFrames;
+
+		sysVars.SetSavingToFile(false);
+
+		printf("Rendered %d frame(s) at %dx%d in %.3fs - %.2f FPS\n", frameCount, width, height, totalTime, frameCount / std::max<float>(totalTime, 1e-6f));
+		printf("\trender: %.3f ms/frame\n", renderTime * 1000.0f / frameCount);
+		printf("\twritten: %d/%d frames\n", capture.GetWrittenFrameCount(), frameCount);
+
+		size_t rtMemory = 0, rtMemoryUnshared = 0;
+		m_data->Objects.GetRenderTextureMemory(rtMemory, rtMemoryUnshared);
+		printf("\trender textures: %.2f MB (%.2f MB without sharing)\n", rtMemory / (1024.0f * 1024.0f), rtMemoryUnshared / (1024.0f * 1024.0f));
+
+		if (!opts.BounceOutput.empty())
+			m_bounceAudio(opts);
+
+		m_data->Pipeline.Clear();
+
+		return 0;
+	}
+
+	void HeadlessRenderer::m_renderReference(const CommandLineOptionParser& opts, int width, int height)
+	{
+		GLuint windowRT = m_data->Renderer.GetTexture();
+
+		// pick the pass & its render texture
+		PipelineItem* pass = nullptr;
+		int rtIndex = 0;
+		if (opts.ReferencePass.empty()) {
+			for (PipelineItem* item : m_data->Pipeline.GetList()) {
+				if (item->Type != PipelineItem::ItemType::ShaderPass)
+					continue;
+
+				pipe::ShaderPass* data = (pipe::ShaderPass*)item->Data;
+				if (!data->Active)
+					continue;
+
+				for (int i = 0; i < data->RTCount; i++)
+					if (data->RenderTextures[i] == windowRT) {
+						pass = item;
+						rtIndex = i;
+					}
+			}
+		} else {
+			pass = m_data->Pipeline.Get(opts.ReferencePass.c_str());
+			if (pass != nullptr && pass->Type != PipelineItem::ItemType::ShaderPass)
+				pass = nullptr;
+		}
+
+		if (pass == nullptr) {
+			printf("Couldn't find a shader pass for --reference\n");
+			return;
+		}
+
+		pipe::ShaderPass* passData = (pipe::ShaderPass*)pass->Data;
+		GLuint rt = passData->RenderTextures[rtIndex];
+
+		glm::ivec2 size(width, height);
+		glm::vec4 clearColor = Settings::Instance().Project.ClearColor;
+		if (rt != windowRT) {
+			RenderTextureObject* rtObject = m_data->Objects.GetRenderTexture(rt);
+			if (rtObject == nullptr) {
+				printf("Couldn't find the render texture of %s\n", pass->Name);
+				return;
+			}
+			size = rtObject->CalculateSize(width, height);
+			clearColor = rtObject->ClearColor;
+		}
+
+		std::vector<unsigned char> refPixels;
+		ReferenceRenderInfo info;
+		if (!m_data->Debugger.RenderReference(pass, rtIndex, size, clearColor, refPixels, &info)) {
+			printf("Failed to render the reference image of %s\n", pass->Name);
+			return;
+		}
+
+		// GPU output
+		std::vector<unsigned char> gpuPixels(size.x * size.y * 4);
+		glBindTexture(GL_TEXTURE_2D, rt);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, gpuPixels.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		int maxDiff = 0;
+		size_t diffCount = 0;
+		for (size_t i = 0; i < refPixels.size(); i += 4) {
+			int pxDiff = 0;
+			for (int c = 0; c < 4; c++)
+				pxDiff = std::max<int>(pxDiff, abs((int)refPixels[i + c] - (int)gpuPixels[i + c]));
+
+			maxDiff = std::max<int>(maxDiff, pxDiff);
+			if (pxDiff > REFERENCE_TOLERANCE)
+				diffCount++;
+		}
+
+		if (!stbi_write_png(opts.ReferenceOutput.c_str(), size.x, size.y, 4, refPixels.data(), size.x * 4))
+			printf("Failed to write %s\n", opts.ReferenceOutput.c_str());
+
+		printf("Reference render of %s at %dx%d in %.3fs - %.0f pixels/s on %d thread(s)\n", pass->Name, size.x, size.y, info.Time, size.x * size.y / std::max<float>(info.Time, 1e-6f), info.Threads);
+		printf("\tcovered: %zu pixels, %zu shader invocations\n", info.Pixels, info.Invocations);
+		printf("\tdifference: %zu pixels over %d/255, max %d/255\n", diffCount, REFERENCE_TOLERANCE, maxDiff);
+	}
+	void HeadlessRenderer::m_bounceAudio(const CommandLineOptionParser& opts)
+	{
+		std::vector<PipelineItem*> passes;
+		for (PipelineItem* item : m_data->Pipeline.GetList())
+			if (item->Type == PipelineItem::ItemType::AudioPass)
+				passes.push_back(item);
+
+		if (passes.empty()) {
+			printf("No audio passes to --bounce\n");
+			return;
+		}
+
+		std::filesystem::path outPath(opts.BounceOutput);
+		for (PipelineItem* pass : passes) {
+			pipe::AudioPass* data = (pipe::AudioPass*)pass->Data;
+
+			// one file per pass: out_[pass].wav
+			std::string path = opts.BounceOutput;
+			if (passes.size() > 1)
+				path = (outPath.parent_path() / (outPath.stem().string() + "_" + pass->Name + outPath.extension().string())).generic_string();
+
+			// the live stream would keep rendering on the same GL context
+			data->Stream.stop();
+
+			eng::Timer timer;
+			if (!m_data->Renderer.BounceAudio(pass, path, opts.BounceLength)) {
+				printf("Failed to bounce %s to %s\n", pass->Name, path.c_str());
+				continue;
+			}
+			float time = timer.GetElapsedTime();
+
+			printf("Bounced %.2fs of %s (%d Hz, %d channel(s)) in %.3fs - %.1fx real time\n", opts.BounceLength, pass->Name, data->Stream.getSampleRate(), data->Stream.getChannels(), time, opts.BounceLength / std::max<float>(time, 1e-6f));
+		}
+	}
+
+#if defined(SHADERED_USE_EGL)
+	bool HeadlessRenderer::m_createContext()
+	{
+		EGLDisplay display = EGL_NO_DISPLAY;
+
+		// prefer a surfaceless display so that no X11/Wayland server is needed
+#if defined(EGL_PLATFORM_SURFACELESS_MESA)
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay)
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+		if (display == EGL_NO_DISPLAY)
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+		EGLint major = 0, minor = 0;
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+			Logger::Get().Log("Failed to initialize EGL", true);
+			return false;
+		}
+		m_display = display;
+
+		Logger::Get().Log("Initialized EGL " + std::to_string(major) + "." + std::to_string(minor));
+
+		const EGLint configAttribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_STENCIL_SIZE, 8,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE
+		};
+		EGLConfig config;
+		EGLint configCount = 0;
+		if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+			Logger::Get().Log("Failed to find a suitable EGL config", true);
+			return false;
+		}
+
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			Logger::Get().Log("EGL doesn't support desktop OpenGL", true);
+			return false;
+		}
+
+		const EGLint contextAttribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+		if (context == EGL_NO_CONTEXT) {
+			Logger::Get().Log("Failed to create an EGL context", true);
+			return false;
+		}
+		m_context = context;
+
+		// we never draw to the default framebuffer - go surfaceless if possible
+		const char* exts = eglQueryString(display, EGL_EXTENSIONS);
+		bool surfaceless = exts != nullptr && strstr(exts, "EGL_KHR_surfaceless_context") != nullptr;
+
+		EGLSurface surface = EGL_NO_SURFACE;
+		if (!surfaceless) {
+			const EGLint pbufferAttribs[] = {
+				EGL_WIDTH, 16,
+				EGL_HEIGHT, 16,
+				EGL_NONE
+			};
+			surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+			if (surface == EGL_NO_SURFACE) {
+				Logger::Get().Log("Failed to create an EGL pbuffer surface", true);
+				return false;
+			}
+			m_surface = surface;
+		}
+
+		if (!eglMakeCurrent(display, surface, surface, context)) {
+			Logger::Get().Log("Failed to make the EGL context current", true);
+			return false;
+		}
+
+		return true;
+	}
+	void HeadlessRenderer::m_destroyContext()
+	{
+		if (m_display == nullptr)
+			return;
+
+		eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_surface)
+			eglDestroySurface(m_display, m_surface);
+		if (m_context)
+			eglDestroyContext(m_display, m_context);
+		eglTerminate(m_display);
+
+		m_display = m_surface = m_context = nullptr;
+	}
+#else
+	// no EGL - fall back to a hidden SDL window
+	bool HeadlessRenderer::m_createContext()
+	{
+		if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+			Logger::Get().Log("Failed to initialize SDL2", true);
+			return false;
+		}
+
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+		SDL_Window* wnd = SDL_CreateWindow("SHADERed", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 16, 16, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+		if (wnd == nullptr) {
+			Logger::Get().Log("Failed to create a hidden SDL window", true);
+			return false;
+		}
+		m_surface = wnd;
+
+		SDL_GLContext context = SDL_GL_CreateContext(wnd);
+		if (context == nullptr) {
+			Logger::Get().Log("Failed to create an OpenGL context", true);
+			return false;
+		}
+		m_context = context;
+
+		SDL_GL_MakeCurrent(wnd, context);
+
+		return true;
+	}
+	void HeadlessRenderer::m_destroyContext()
+	{
+		if (m_context)
+			SDL_GL_DeleteContext(m_context);
+		if (m_surface)
+			SDL_DestroyWindow((SDL_Window*)m_surface);
+		if (m_surface || m_context)
+			SDL_Quit();
+
+		m_surface = m_context = nullptr;
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <SHADERed/Objects/CommandLineOptionParser.h>
+
+namespace ed {
+	class InterfaceManager;
+
+	// renders a project to image files or a video without a window or ImGui - used by the --render option
+	class HeadlessRenderer {
+	public:
+		HeadlessRenderer();
+		~HeadlessRenderer();
+
+		// returns the process' exit code
+		int Run(const CommandLineOptionParser& opts);
+
+	private:
+		bool m_createContext();
+		void m_destroyContext();
+
+		// renders the pass with the shader debugger and compares the result with the GPU output
+		void m_renderReference(const CommandLineOptionParser& opts, int width, int height);
+
+		// renders the audio passes to opts.BounceOutput
+		void m_bounceAudio(const CommandLineOptionParser& opts);
+
+		InterfaceManager* m_data;
+
+		// EGLDisplay/EGLSurface/EGLContext or SDL_Window/SDL_GLContext
+		void* m_display;
+		void* m_surface;
+		void* m_context;
+	};
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <SHADERed/GUIManager.h>
 #include <SHADERed/InterfaceManager.h>
+#include <SHADERed/Objects/AssetLoader.h>
 #include <SHADERed/Objects/Names.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
@@ -7,30 +8,6 @@
 #include <glm/gtc/type_ptr.hpp>
 
 namespace ed {
-	uint8_t* getRawPixel(GLuint rt, uint8_t* data, int x, int y, int width)
-	{
-		uint8_t* ret = &data[(x + y * width) * 4];
-
-		if (glGetTextureSubImage) {
-			ret = &data[0];
-			glGetTextureSubImage(rt, 0, x, y, 0, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, 4 * sizeof(uint8_t), data);
-		} else {
-			glBindTexture(GL_TEXTURE_2D, rt);
-			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-			glBindTexture(GL_TEXTURE_2D, 0);
-		}
-		return ret;
-	}
-	glm::vec4 getPixelColor(GLuint rt, uint8_t* data, int x, int y, int width)
-	{
-		uint8_t* pxData = getRawPixel(rt, data, x, y, width);
-		return glm::vec4(pxData[0] / 255.0f, pxData[1] / 255.0f, pxData[2] / 255.0f, pxData[3] / 255.0f);
-	}
-	uint32_t getPixelID(GLuint rt, uint8_t* data, int x, int y, int width)
-	{
-		uint8_t* pxData = getRawPixel(rt, data, x, y, width);
-		return ((uint32_t)pxData[0] << 0) | ((uint32_t)pxData[1] << 8) | ((uint32_t)pxData[2] << 16) | ((uint32_t)pxData[3] << 24);
-	}
 	void copyFloatData(eng::Model::Mesh::Vertex& out, GLfloat* bufData)
 	{
 		out.Position = glm::vec3(bufData[0], bufData[1], bufData[2]);
@@ -52,6 +29,7 @@ namespace ed {
 	}
 	InterfaceManager::~InterfaceManager()
 	{
+		AssetLoader::Instance().CancelAll();
 		Objects.Clear();
 		Plugins.Destroy();
 	}
@@ -65,7 +43,6 @@ namespace ed {
 		// info
 		const std::vector<ObjectManagerItem*>& objs = Objects.GetItemDataList();
 		glm::ivec2 previewSize = Renderer.GetLastRenderSize();
-		glm::ivec2 maxRTSize = previewSize;
 		GLuint previewTexture = Renderer.GetTexture();
 
 		int x = r.x * previewSize.x;
@@ -75,46 +52,33 @@ namespace ed {
 		std::unordered_map<GLuint, glm::vec4> pixelColors;
 		std::unordered_map<GLuint, std::pair<PipelineItem*, PipelineItem*>> pipelineItems;
 
-		// get max RT size
+		// window & every render texture
+		std::vector<std::pair<GLuint, glm::ivec2>> targets;
+		targets.push_back(std::make_pair(previewTexture, glm::ivec2(x, y)));
 		for (int i = 0; i < objs.size(); i++) {
 			if (objs[i]->RT != nullptr) {
 				glm::ivec2 rtSize = Objects.GetRenderTextureSize(objs[i]->RT->Name);
-				if (rtSize.x > maxRTSize.x)
-					maxRTSize.x = rtSize.x;
-				if (rtSize.y > maxRTSize.y)
-					maxRTSize.y = rtSize.y;
+				targets.push_back(std::make_pair(objs[i]->Texture, glm::ivec2(r.x * rtSize.x, r.y * rtSize.y)));
 			}
 		}
 
-		uint8_t* mainPixelData = new uint8_t[maxRTSize.x * maxRTSize.y * 4]; // copy gpu data to cpu
-		
-		// window pixel color
-		pixelColors[previewTexture] = getPixelColor(previewTexture, mainPixelData, x, y, previewSize.x);
-
-		// rt pixel colors
-		for (int i = 0; i < objs.size(); i++) {
-			if (objs[i]->RT != nullptr) {
-				GLuint tex = objs[i]->Texture;
-				glm::ivec2 rtSize = Objects.GetRenderTextureSize(objs[i]->RT->Name);
-
-				pixelColors[tex] = getPixelColor(tex, mainPixelData, r.x * rtSize.x, r.y * rtSize.y, rtSize.x);
-			}
-		}
+		// colors and object IDs go to the same pixel buffer - GL executes the reads in order
+		// so the colors are copied before the ID render overwrites them and both arrive with a single map
+		m_pixelReadback.Begin(targets.size() * 2);
+		for (const auto& target : targets)
+			m_pixelReadback.Read(target.first, target.second.x, target.second.y);
 
 		// render with object IDs
 		Renderer.Render(true);
 
-		// window pipeline item
-		pipelineItems[previewTexture] = Renderer.GetPipelineItemByDebugID(0x00FFFFFF & getPixelID(previewTexture, mainPixelData, x, y, previewSize.x));
+		for (const auto& target : targets)
+			m_pixelReadback.Read(target.first, target.second.x, target.second.y);
 
-		// rt pipeline item
-		for (int i = 0; i < objs.size(); i++) {
-			if (objs[i]->RT != nullptr) {
-				GLuint tex = objs[i]->Texture;
-				glm::ivec2 rtSize = Objects.GetRenderTextureSize(objs[i]->RT->Name);
+		m_pixelReadback.Finish();
 
-				pipelineItems[tex] = Renderer.GetPipelineItemByDebugID(0x00FFFFFF & getPixelID(tex, mainPixelData, r.x * rtSize.x, r.y * rtSize.y, rtSize.x));
-			}
+		for (int i = 0; i < targets.size(); i++) {
+			pixelColors[targets[i].first] = m_pixelReadback.GetColor(i);
+			pipelineItems[targets[i].first] = Renderer.GetPipelineItemByDebugID(0x00FFFFFF & m_pixelReadback.GetID(targets.size() + i));
 		}
 
 		// add PixelInformation objects
@@ -189,11 +153,14 @@ namespace ed {
 	}
 	void InterfaceManager::FetchPixel(PixelInformation& pixel)
 	{
-		int vertexGroupID = Renderer.DebugVertexPick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, -1);
-		int vertexID = Renderer.DebugVertexPick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, vertexGroupID);
+		int vertexID = 0, instanceID = 0;
+		if (!Renderer.DebugPick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, vertexID, instanceID)) {
+			int vertexGroupID = Renderer.DebugVertexPick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, -1);
+			vertexID = Renderer.DebugVertexPick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, vertexGroupID);
 
-		int instanceGroupID = Renderer.DebugInstancePick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, -1);
-		int instanceID = Renderer.DebugInstancePick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, instanceGroupID);
+			int instanceGroupID = Renderer.DebugInstancePick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, -1);
+			instanceID = Renderer.DebugInstancePick(pixel.Pass, pixel.Object, pixel.RelativeCoordinate, instanceGroupID);
+		}
 
 		pixel.InstanceID = instanceID;
 		pixel.VertexID = vertexID;
@@ -340,6 +307,8 @@ namespace ed {
 	}
 	void InterfaceManager::Update(float delta)
 	{
+		// create the GL objects for the textures & models that finished loading in the background
+		AssetLoader::Instance().Update();
 	}
 	bool InterfaceManager::m_canDebug()
 	{
@@ -1,5 +1,6 @@
 #pragma once
 #include <SDL2/SDL_events.h>
+#include <SHADERed/Engine/PixelReadback.h>
 #include <SHADERed/Objects/DebugInformation.h>
 #include <SHADERed/Objects/MessageStack.h>
 #include <SHADERed/Objects/ObjectManager.h>
@@ -34,6 +35,7 @@ namespace ed {
 
 	private:
 		GUIManager* m_ui;
+		eng::PixelReadback m_pixelReadback;
 
 		void m_fetchVertices(PixelInformation& pixel);
 		bool m_canDebug();
@@ -0,0 +1,142 @@
+#include <SHADERed/Engine/Timer.h>
+#include <SHADERed/Objects/AssetLoader.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace ed {
+	AssetLoader::AssetLoader()
+	{
+		m_done = false;
+		m_maxInFlight = 0;
+	}
+	AssetLoader::~AssetLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_done = true;
+			m_queue.clear();
+		}
+		m_hasWork.notify_all();
+
+		for (auto& worker : m_workers)
+			if (worker.joinable())
+				worker.join();
+
+		// the GL context is gone by now - just drop the results
+		m_ready.clear();
+	}
+	void AssetLoader::Add(void* owner, std::function<bool()> load, std::function<void(bool)> upload)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// start the workers on the first use
+			if (m_workers.empty()) {
+				int tCount = std::thread::hardware_concurrency();
+				tCount = std::max<int>(1, std::min<int>(tCount - 1, ASSET_LOADER_MAX_THREADS));
+
+				m_maxInFlight = tCount * 2;
+				for (int i = 0; i < tCount; i++)
+					m_workers.push_back(std::thread(&AssetLoader::m_work, this));
+			}
+
+			Job job;
+			job.Owner = owner;
+			job.Load = load;
+			job.Upload = upload;
+			job.Result = false;
+			m_queue.push_back(job);
+		}
+		m_hasWork.notify_one();
+	}
+	void AssetLoader::Update(float budget)
+	{
+		eng::Timer timer;
+
+		while (true) {
+			Job job;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_ready.empty())
+					break;
+
+				job = m_ready.front();
+				m_ready.pop_front();
+			}
+			m_hasWork.notify_one(); // a slot has been freed
+
+			job.Upload(job.Result);
+
+			if (timer.GetElapsedTime() >= budget)
+				break;
+		}
+	}
+	void AssetLoader::Flush()
+	{
+		while (true) {
+			Update(std::numeric_limits<float>::infinity());
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_queue.empty() && m_loading.empty() && m_ready.empty())
+				break;
+
+			m_hasResult.wait(lock, [&] { return !m_ready.empty() || (m_queue.empty() && m_loading.empty()); });
+		}
+	}
+	void AssetLoader::Cancel(void* owner)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		auto isOwner = [&](const Job& job) { return job.Owner == owner; };
+		m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), isOwner), m_queue.end());
+
+		// load() writes to the owner so let it finish
+		m_hasResult.wait(lock, [&] { return std::count(m_loading.begin(), m_loading.end(), owner) == 0; });
+
+		m_ready.erase(std::remove_if(m_ready.begin(), m_ready.end(), isOwner), m_ready.end());
+
+		lock.unlock();
+		m_hasWork.notify_all();
+	}
+	void AssetLoader::CancelAll()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_queue.clear();
+		m_hasResult.wait(lock, [&] { return m_loading.empty(); });
+		m_ready.clear();
+
+		lock.unlock();
+		m_hasWork.notify_all();
+	}
+	int AssetLoader::GetPendingCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue.size() + m_loading.size() + m_ready.size();
+	}
+	void AssetLoader::m_work()
+	{
+		while (true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_hasWork.wait(lock, [&] { return m_done || (!m_queue.empty() && (int)(m_loading.size() + m_ready.size()) < m_maxInFlight); });
+				if (m_done)
+					return;
+
+				job = m_queue.front();
+				m_queue.pop_front();
+				m_loading.push_back(job.Owner);
+			}
+
+			job.Result = job.Load();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_loading.erase(std::find(m_loading.begin(), m_loading.end(), job.Owner));
+				m_ready.push_back(job);
+			}
+			m_hasResult.notify_all();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define ASSET_LOADER_MAX_THREADS 8
+#define ASSET_LOADER_UPLOAD_BUDGET 0.008f // seconds spent on GL uploads per frame
+
+namespace ed {
+	// decodes images & imports models on worker threads while the project keeps running
+	// the results go through an upload queue which is drained on the main thread (the one that owns the GL context)
+	class AssetLoader {
+	public:
+		~AssetLoader();
+
+		// load() runs on a worker thread and mustn't touch GL, upload() runs on the main thread and gets load()'s return value
+		// owner is the object that the job writes to - it's used to cancel the job before the owner gets destroyed
+		void Add(void* owner, std::function<bool()> load, std::function<void(bool)> upload);
+
+		// main thread - uploads the finished jobs until the time budget (in seconds) runs out
+		void Update(float budget = ASSET_LOADER_UPLOAD_BUDGET);
+
+		// main thread - blocks until every job is loaded and uploaded
+		void Flush();
+
+		// drops the owner's jobs (waits if one of them is being loaded right now)
+		void Cancel(void* owner);
+		void CancelAll();
+
+		int GetPendingCount();
+
+		static inline AssetLoader& Instance()
+		{
+			static AssetLoader ret;
+			return ret;
+		}
+
+	private:
+		AssetLoader();
+
+		struct Job {
+			void* Owner;
+			std::function<bool()> Load;
+			std::function<void(bool)> Upload;
+			bool Result;
+		};
+
+		void m_work();
+
+		std::vector<std::thread> m_workers;
+		int m_maxInFlight; // loaded jobs hold decoded pixels - don't decode much further ahead of the uploads
+
+		std::deque<Job> m_queue, m_ready;
+		std::vector<void*> m_loading; // owners of the jobs that are on the workers right now
+		std::mutex m_mutex;
+		std::condition_variable m_hasWork, m_hasResult;
+		bool m_done;
+	};
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <string.h>
 
 const float ed::AudioAnalyzer::Smooth[] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
 const float ed::AudioAnalyzer::Gravity = 0.0006f;
@@ -13,6 +14,7 @@ namespace ed {
 		https://github.com/dgranosa/liveW
 	***************************************/
 	AudioAnalyzer::AudioAnalyzer()
+			: m_fft(SampleCount)
 	{
 		m_sensitivity = 1.0;
 		m_isSetup = 0;
@@ -60,23 +62,24 @@ namespace ed {
 			m_isSetup = rate;
 		}
 
-		// Spliting channels
+		// Spliting channels - written straight to the bit reversed positions
 		int n = 0;
-		std::valarray<std::complex<double>> fftIn(SampleCount);
+		memset(m_fftRe, 0, sizeof(m_fftRe));
+		memset(m_fftIm, 0, sizeof(m_fftIm));
 		for (int i = 0; i < SampleCount / 2; i += 2) {
 			if (curSample + i > samplersPerChannel * channels || curSample + i + 1 > samplersPerChannel * channels)
 				continue;
 
-			fftIn[n] = (samples[curSample + i] + samples[curSample + i + 1]) / 2; // TODO: Add stereo option
+			m_fftRe[m_fft.GetBitReversed(n)] = (samples[curSample + i] + samples[curSample + i + 1]) / 2; // TODO: Add stereo option
 			n++;
 			if (n == SampleCount - 1) n = 0;
 		}
 
 		// Run fftw
-		m_fftAlgorithm(fftIn);
+		m_fft.Compute(m_fftRe, m_fftIm);
 
 		// Separate fftw output
-		m_seperateFreqBands(&fftIn[0], BufferOutSize, m_lcf, m_hcf, m_smoothing, m_sensitivity, BufferOutSize);
+		m_seperateFreqBands(m_fftRe, m_fftIm, BufferOutSize, m_lcf, m_hcf, m_smoothing, m_sensitivity);
 
 		/* Processing */
 		// Waves
@@ -129,43 +132,17 @@ namespace ed {
 
 		return &m_fftOut[0];
 	}
-	void AudioAnalyzer::m_fftAlgorithm(std::valarray<std::complex<double>>& input)
+	void AudioAnalyzer::m_seperateFreqBands(const float* re, const float* im, int n, int* lcf, int* hcf, float* k, double sensitivity)
 	{
-		const int len = input.size();
-		if (len <= 1) return;
-
-		std::valarray<std::complex<double>> even = input[std::slice(0, len / 2, 2)];
-		std::valarray<std::complex<double>> odd = input[std::slice(1, len / 2, 2)];
-
-		m_fftAlgorithm(even);
-		m_fftAlgorithm(odd);
-
-		for (int i = 0; i < len / 2; i++) {
-			std::complex<double> temp = std::polar(1.0, (double)-2 * M_PI * i / len) * odd[i];
-			input[i] = even[i] + temp;
-			input[i + len / 2] = even[i] - temp;
-		}
-	}
-	void AudioAnalyzer::m_seperateFreqBands(std::complex<double>* in, int n, int* lcf, int* hcf, float* k, double sensitivity, int in_samples)
-	{
-		double* peak = new double[n];
-		double* y = new double[in_samples];
-		double temp;
-
 		for (int i = 0; i < n; i++) {
-			peak[i] = 0;
+			double peak = 0;
 
-			for (int j = lcf[i]; j <= hcf[i]; j++) {
-				y[j] = sqrt(in[j].real() * in[j].real() + in[j].imag() * in[j].imag());
-				peak[i] += y[j];
-			}
+			for (int j = lcf[i]; j <= hcf[i]; j++)
+				peak += sqrt((double)re[j] * re[j] + (double)im[j] * im[j]);
 
-			peak[i] = peak[i] / (hcf[i] - lcf[i] + 1);
-			temp = peak[i] * sensitivity * k[i] / 1000000;
+			peak = peak / (hcf[i] - lcf[i] + 1);
+			double temp = peak * sensitivity * k[i] / 1000000;
 			m_fftOut[i] = temp / 100.0;
 		}
-
-		delete[] peak;
-		delete[] y;
 	}
 }
\ No newline at end of file
@@ -1,6 +1,5 @@
 #pragma once
-#include <complex>
-#include <valarray>
+#include <SHADERed/Engine/FFT.h>
 #include <vector>
 
 #include <SFML/Audio/SoundBuffer.hpp>
@@ -23,8 +22,10 @@ namespace ed {
 		double* FFT(sf::SoundBuffer& file, int curSample);
 
 	private:
-		void m_fftAlgorithm(std::valarray<std::complex<double>>& x);
-		void m_seperateFreqBands(std::complex<double>* in, int n, int* lcf, int* hcf, float* k, double sensitivity, int in_samples);
+		void m_seperateFreqBands(const float* re, const float* im, int n, int* lcf, int* hcf, float* k, double sensitivity);
+
+		eng::FFT m_fft;
+		float m_fftRe[SampleCount], m_fftIm[SampleCount];
 
 		int m_isSetup;
 		void m_setup(int rate);
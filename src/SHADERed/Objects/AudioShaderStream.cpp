@@ -1,42 +1,145 @@
 #include <SHADERed/Engine/GLUtils.h>
 #include <SHADERed/Engine/GeometryFactory.h>
 #include <SHADERed/Objects/AudioShaderStream.h>
+#include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
+#include <SFML/Audio/OutputSoundFile.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace ed {
 	AudioShaderStream::AudioShaderStream()
 	{
 		m_fboBuffers = GL_COLOR_ATTACHMENT0;
-		m_curTime = 0.0f;
+		m_fsRectVAO = m_fsRectVBO = 0;
+		m_fbo = m_rt = m_depth = 0;
+		m_shader = 0;
+		m_svarCurTimeLoc = -1;
+		m_renderTime = 0.0f;
 
-		memset(m_pixels, 0, sizeof(char) * 1024);
-		m_needsUpdate = false;
+		m_sampleRate = 44100;
+		m_blockSize = 1024;
+		m_channels = 2;
 
-		initialize(2, 44100);
+		for (int i = 0; i < AUDIO_SHADER_PBO_COUNT; i++) {
+			m_pbo[i] = 0;
+			m_fence[i] = nullptr;
+			m_pboOrder[i] = -1;
+		}
+		m_issued = m_collected = 0;
+
+		m_resizeBuffers();
+		m_ringRead = m_ringWrite = 0;
+		m_holdingChunk = false;
+		m_seeked = false;
+		m_seekTime = 0.0f;
+
+		initialize(m_channels, m_sampleRate);
 	}
 	AudioShaderStream::~AudioShaderStream()
 	{
-		gl::FreeSimpleFramebuffer(m_fbo, m_rt, m_depth);
-		glDeleteVertexArrays(1, &m_fsRectVAO);
-		glDeleteBuffers(1, &m_fsRectVBO);
-		glDeleteProgram(m_shader);
 		stop();
+
+		for (int i = 0; i < AUDIO_SHADER_PBO_COUNT; i++)
+			if (m_fence[i] != nullptr)
+				glDeleteSync(m_fence[i]);
+		glDeleteBuffers(AUDIO_SHADER_PBO_COUNT, m_pbo);
+
+		if (m_fbo != 0) {
+			gl::FreeSimpleFramebuffer(m_fbo, m_rt, m_depth);
+			glDeleteVertexArrays(1, &m_fsRectVAO);
+			glDeleteBuffers(1, &m_fsRectVBO);
+		}
+		if (m_shader != 0)
+			glDeleteProgram(m_shader);
 	}
+	bool AudioShaderStream::setFormat(int sampleRate, int blockSize, int channels)
+	{
+		sampleRate = std::max<int>(8000, std::min<int>(192000, sampleRate));
+		blockSize = std::max<int>(AUDIO_SHADER_MIN_BLOCK, std::min<int>(AUDIO_SHADER_MAX_BLOCK, blockSize));
+		channels = std::max<int>(1, std::min<int>(2, channels));
 
-	bool AudioShaderStream::onGetData(Chunk& data)
+		if (sampleRate == m_sampleRate && blockSize == m_blockSize && channels == m_channels)
+			return false;
+
+		// the audio thread reads the ring - it has to be stopped before the buffers are resized
+		bool wasPlaying = getStatus() == sf::SoundSource::Status::Playing;
+		stop();
+
+		bool rateChanged = sampleRate != m_sampleRate;
+
+		m_sampleRate = sampleRate;
+		m_blockSize = blockSize;
+		m_channels = channels;
+
+		m_dropChunks();
+		m_resizeBuffers();
+		m_ringRead = m_ringWrite = 0;
+		m_holdingChunk = false;
+		m_seeked = false;
+		m_renderTime = 0.0f;
+
+		initialize(m_channels, m_sampleRate);
+
+		// otherwise compileFromShaderSource() restarts the stream
+		if (wasPlaying && !rateChanged)
+			play();
+
+		return rateChanged;
+	}
+	void AudioShaderStream::m_resizeBuffers()
 	{
-		m_mutex.lock();
+		for (int i = 0; i < AUDIO_SHADER_RING_SIZE; i++)
+			m_ring[i].assign(m_blockSize * m_channels, 0);
+		m_silence.assign(m_blockSize * m_channels, 0);
 
-		data.samples = m_audio;
-		data.sampleCount = 1024 * 2;
+		if (m_fbo != 0) {
+			glBindTexture(GL_TEXTURE_2D, m_rt);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, m_blockSize, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			glBindTexture(GL_TEXTURE_2D, m_depth);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, m_blockSize, 1, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+
+		if (m_pbo[0] != 0) {
+			for (int i = 0; i < AUDIO_SHADER_PBO_COUNT; i++) {
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[i]);
+				glBufferData(GL_PIXEL_PACK_BUFFER, m_blockSize * 4 * sizeof(float), nullptr, GL_STREAM_READ);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+	}
+	void AudioShaderStream::m_dropChunks()
+	{
+		for (int i = 0; i < AUDIO_SHADER_PBO_COUNT; i++) {
+			if (m_fence[i] != nullptr)
+				glDeleteSync(m_fence[i]);
+			m_fence[i] = nullptr;
+			m_pboOrder[i] = -1;
+		}
+		m_issued = m_collected = 0;
+	}
+
+	bool AudioShaderStream::onGetData(Chunk& data)
+	{
+		unsigned int read = m_ringRead.load(std::memory_order_relaxed);
 
-		m_curTime += 1024.0f / 44100.0f;
-		m_needsUpdate = true;
+		// SFML is done with the chunk that we gave it last time
+		if (m_holdingChunk) {
+			read++;
+			m_ringRead.store(read, std::memory_order_release);
+			m_holdingChunk = false;
+		}
 
-		m_mutex.unlock();
+		data.sampleCount = m_blockSize * m_channels;
+		if (read != m_ringWrite.load(std::memory_order_acquire)) {
+			data.samples = m_ring[read % AUDIO_SHADER_RING_SIZE].data();
+			m_holdingChunk = true;
+		} else
+			data.samples = m_silence.data(); // underrun - keep the stream alive
 
 		return true;
 	}
@@ -54,6 +157,9 @@ namespace ed {
 				gl_Position = vec4(pos, 0.0, 0.0);	
 			}
 		)";
+		// the sample rate is baked into the shader - setFormat() asks for a recompile when it changes
+		std::string sampleRate = std::to_string(m_sampleRate) + ".0f";
+
 		std::string psCodeIn = str;
 		if (isHLSL) {
 			psCodeIn += R"(
@@ -66,7 +172,7 @@ namespace ed {
 					float sedCurrentTime;
 				};
 				float4 main(PSInput inp) : SV_TARGET {
-					float time = sedCurrentTime + inp.Pos.x / 44100.0f;
+					float time = sedCurrentTime + inp.Pos.x / )" + sampleRate + R"(;
 					float2 v = mainSound(time);
 					return float4(v.x, v.y, 0, 0); // TODO: put 4 samples in one pixel
 				}
@@ -76,7 +182,7 @@ namespace ed {
 				out vec4 fragColor;
 				uniform float sedCurrentTime;
 				void main() {
-					float time = sedCurrentTime + gl_FragCoord.x / 44100.0f;
+					float time = sedCurrentTime + gl_FragCoord.x / )" + sampleRate + R"(;
 					vec2 v = mainSound(time);
 					fragColor = vec4(v.x, v.y, 0, 0); // TODO: put 4 samples in one pixel
 				}
@@ -105,6 +211,9 @@ namespace ed {
 		glShaderSource(audioPS, 1, &psSource, nullptr);
 		glCompileShader(audioPS);
 
+		if (m_shader != 0)
+			glDeleteProgram(m_shader);
+
 		// create a shader program for cubemap preview
 		m_shader = glCreateProgram();
 		glAttachShader(m_shader, audioVS);
@@ -114,8 +223,16 @@ namespace ed {
 		glDeleteShader(audioVS);
 		glDeleteShader(audioPS);
 
-		m_fsRectVAO = ed::eng::GeometryFactory::CreateScreenQuadNDC(m_fsRectVBO, gl::CreateDefaultInputLayout());
-		m_fbo = gl::CreateSimpleFramebuffer(1024, 1, m_rt, m_depth, GL_RGBA32F);
+		// the quad & the render target only depend on the format - keep them between recompiles
+		if (m_fbo == 0) {
+			m_fsRectVAO = ed::eng::GeometryFactory::CreateScreenQuadNDC(m_fsRectVBO, gl::CreateDefaultInputLayout());
+			m_fbo = gl::CreateSimpleFramebuffer(m_blockSize, 1, m_rt, m_depth, GL_RGBA32F);
+		}
+
+		if (m_pbo[0] == 0) {
+			glGenBuffers(AUDIO_SHADER_PBO_COUNT, m_pbo);
+			m_resizeBuffers();
+		}
 
 		m_svarCurTimeLoc = glGetUniformLocation(m_shader, "sedCurrentTime");
 
@@ -124,39 +241,163 @@ namespace ed {
 	}
 	void AudioShaderStream::renderAudio()
 	{
-		if (!m_needsUpdate)
+		if (m_pbo[0] == 0)
 			return;
 
-		m_mutex.lock();
+		// the chunks on the GPU were rendered for the old position
+		if (m_seeked.exchange(false)) {
+			m_dropChunks();
+			m_renderTime = m_seekTime;
+		}
 
+		m_collectChunks();
+
+		// render ahead until the ring would be full
+		int queued = m_ringWrite.load(std::memory_order_relaxed) - m_ringRead.load(std::memory_order_acquire);
+		for (int i = 0; i < AUDIO_SHADER_PBO_COUNT; i++) {
+			if (queued + (m_issued - m_collected) >= AUDIO_SHADER_RING_SIZE)
+				break;
+			if (m_pboOrder[i] == -1)
+				m_renderChunk(i);
+		}
+	}
+	void AudioShaderStream::m_collectChunks()
+	{
+		// oldest chunk first so that they get to the ring in order
+		while (m_collected < m_issued) {
+			int slot = std::distance(m_pboOrder, std::find(m_pboOrder, m_pboOrder + AUDIO_SHADER_PBO_COUNT, m_collected));
+			if (slot >= AUDIO_SHADER_PBO_COUNT)
+				break;
+
+			// still being rendered - try again on the next frame
+			GLenum waitRes = glClientWaitSync(m_fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if (waitRes != GL_ALREADY_SIGNALED && waitRes != GL_CONDITION_SATISFIED)
+				break;
+
+			unsigned int write = m_ringWrite.load(std::memory_order_relaxed);
+			if (write - m_ringRead.load(std::memory_order_acquire) >= AUDIO_SHADER_RING_SIZE)
+				break;
+
+			glDeleteSync(m_fence[slot]);
+			m_fence[slot] = nullptr;
+
+			std::vector<sf::Int16>& audio = m_ring[write % AUDIO_SHADER_RING_SIZE];
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[slot]);
+			const float* pixels = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_blockSize * 4 * sizeof(float), GL_MAP_READ_BIT);
+			if (pixels != nullptr) {
+				m_convertSamples(pixels, audio.data(), m_blockSize);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			} else
+				std::fill(audio.begin(), audio.end(), 0);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			m_ringWrite.store(write + 1, std::memory_order_release);
+
+			m_pboOrder[slot] = -1;
+			m_collected++;
+		}
+	}
+	void AudioShaderStream::m_convertSamples(const float* pixels, sf::Int16* out, int count)
+	{
+		// one sample per pixel, the channels are stored in the RG components
+		for (int s = 0; s < count; s++)
+			for (int c = 0; c < m_channels; c++)
+				out[s * m_channels + c] = std::max<float>(-1.0f, std::min<float>(1.0f, pixels[s * 4 + c])) * INT16_MAX;
+	}
+	void AudioShaderStream::m_drawBlock(GLuint fbo, GLuint pbo, int blockSize, float time)
+	{
 		glUseProgram(m_shader);
-		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
 		glDrawBuffers(1, &m_fboBuffers);
 		glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
 		glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)));
-		glViewport(0, 0, 1024, 1);
+		glViewport(0, 0, blockSize, 1);
 
-		glUniform1f(m_svarCurTimeLoc, m_curTime);
+		glUniform1f(m_svarCurTimeLoc, time);
 		glBindVertexArray(m_fsRectVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
+		// async copy into the PBO
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+		glReadPixels(0, 0, blockSize, 1, GL_RGBA, GL_FLOAT, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glBindTexture(GL_TEXTURE_2D, m_rt);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, m_pixels);
-		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	void AudioShaderStream::m_renderChunk(int slot)
+	{
+		m_drawBlock(m_fbo, m_pbo[slot], m_blockSize, m_renderTime);
 
-		for (int s = 0; s < 1024; s++) {
-			int off = s * 4;
-			m_audio[s * 2] = m_pixels[off + 0] * INT16_MAX;
-			m_audio[s * 2 + 1] = m_pixels[off + 1] * INT16_MAX;
+		// collected once the fence is signaled
+		m_fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_pboOrder[slot] = m_issued++;
+
+		m_renderTime += m_blockSize / (float)m_sampleRate;
+	}
+	bool AudioShaderStream::bounce(const std::string& path, float length, int blockSize)
+	{
+		if (m_shader == 0 || m_fbo == 0 || length <= 0.0f)
+			return false;
+
+		blockSize = std::max<int>(AUDIO_SHADER_MIN_BLOCK, std::min<int>(AUDIO_SHADER_MAX_BLOCK, blockSize));
+
+		sf::OutputSoundFile file;
+		if (!file.openFromFile(path, m_sampleRate, m_channels)) {
+			ed::Logger::Get().Log("Failed to open \"" + path + "\" for writing", true);
+			return false;
 		}
 
-		m_needsUpdate = false;
+		GLuint rt, depth;
+		GLuint fbo = gl::CreateSimpleFramebuffer(blockSize, 1, rt, depth, GL_RGBA32F);
+
+		GLuint pbo[2];
+		glGenBuffers(2, pbo);
+		for (int i = 0; i < 2; i++) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, blockSize * 4 * sizeof(float), nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		sf::Uint64 sampleCount = (sf::Uint64)std::ceil((double)length * m_sampleRate);
+		sf::Uint64 blockCount = (sampleCount + blockSize - 1) / blockSize;
+		std::vector<sf::Int16> samples(blockSize * m_channels);
+
+		// block b is rendered while block b-1 is written - the GPU never waits for the disk
+		for (sf::Uint64 b = 0; b <= blockCount; b++) {
+			if (b < blockCount)
+				m_drawBlock(fbo, pbo[b % 2], blockSize, (float)((double)b * blockSize / m_sampleRate));
 
-		m_mutex.unlock();
+			if (b == 0)
+				continue;
+
+			sf::Uint64 first = (b - 1) * blockSize;
+			int count = (int)std::min<sf::Uint64>(blockSize, sampleCount - first);
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[(b - 1) % 2]);
+			const float* pixels = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, blockSize * 4 * sizeof(float), GL_MAP_READ_BIT);
+			if (pixels != nullptr) {
+				m_convertSamples(pixels, samples.data(), count);
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			} else
+				std::fill(samples.begin(), samples.end(), 0);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			file.write(samples.data(), count * m_channels);
+		}
+
+		glDeleteBuffers(2, pbo);
+		gl::FreeSimpleFramebuffer(fbo, rt, depth);
+
+		return true;
 	}
 	void AudioShaderStream::onSeek(sf::Time timeOffset)
 	{
-		m_curTime = timeOffset.asSeconds();
+		// the streaming thread is stopped while SFML seeks - drop the queued chunks and let the producer restart
+		m_holdingChunk = false;
+		m_ringRead.store(m_ringWrite.load(std::memory_order_acquire), std::memory_order_release);
+
+		m_seekTime = timeOffset.asSeconds();
+		m_seeked = true;
 	}
 }
\ No newline at end of file
@@ -15,7 +15,16 @@
 #include <SHADERed/Objects/ProjectParser.h>
 #include <SHADERed/Objects/ShaderMacro.h>
 
+#define AUDIO_SHADER_PBO_COUNT 2  // chunks that can be on the GPU at once
+#define AUDIO_SHADER_RING_SIZE 4  // converted chunks waiting for the audio thread (latency = 4 blocks)
+#define AUDIO_SHADER_MIN_BLOCK 64
+#define AUDIO_SHADER_MAX_BLOCK 16384
+#define AUDIO_SHADER_BOUNCE_BLOCK 16384
+
 namespace ed {
+	// audio shaders render a block of samples per chunk into a [block size]x1 texture - the chunk is read back through
+	// a PBO + fence and handed to the SFML audio thread through a lock-free single producer/single consumer ring
+	// the main thread (renderAudio) is the producer, onGetData (audio thread) is the consumer
 	class AudioShaderStream : public sf::SoundStream {
 		virtual bool onGetData(Chunk& data);
 		virtual void onSeek(sf::Time timeOffset);
@@ -29,17 +38,46 @@ namespace ed {
 
 		inline GLuint getShader() { return m_shader; }
 
+		// stops the stream while the buffers are resized - returns true if the shader has to be recompiled (the sample rate is baked into it)
+		bool setFormat(int sampleRate, int blockSize, int channels);
+		inline int getSampleRate() { return m_sampleRate; }
+		inline int getBlockSize() { return m_blockSize; }
+		inline int getChannels() { return m_channels; }
+
+		// renders [0, length] seconds to a .wav/.ogg/.flac file as fast as the GPU allows, in large blocks & without touching the audio device
+		// the pass' uniforms and textures have to be bound already
+		bool bounce(const std::string& path, float length, int blockSize = AUDIO_SHADER_BOUNCE_BLOCK);
+
 	private:
-		std::atomic<bool> m_needsUpdate;
-		sf::Mutex m_mutex;
+		void m_collectChunks();
+		void m_renderChunk(int slot);
+		void m_dropChunks();
+		void m_resizeBuffers();
+		void m_drawBlock(GLuint fbo, GLuint pbo, int blockSize, float time);
+		void m_convertSamples(const float* pixels, sf::Int16* out, int count);
+
+		int m_sampleRate, m_blockSize, m_channels;
+
+		// producer side - GL objects are only touched on the main thread
+		float m_renderTime; // time of the next chunk that will be rendered
+		GLuint m_pbo[AUDIO_SHADER_PBO_COUNT];
+		GLsync m_fence[AUDIO_SHADER_PBO_COUNT];
+		int m_pboOrder[AUDIO_SHADER_PBO_COUNT]; // order in which the chunks were issued, -1 if the PBO is free
+		int m_issued, m_collected;
+
+		// ring - m_ringWrite is only written by the producer, m_ringRead only by the consumer
+		std::vector<sf::Int16> m_ring[AUDIO_SHADER_RING_SIZE];
+		std::atomic<unsigned int> m_ringRead, m_ringWrite;
+		bool m_holdingChunk; // consumer: SFML reads the last returned chunk until the next onGetData() call
+		std::vector<sf::Int16> m_silence;
+
+		// seeking/stopping (audio thread) - the producer drops its in-flight chunks and restarts from m_seekTime
+		std::atomic<bool> m_seeked;
+		std::atomic<float> m_seekTime;
 
-		float m_curTime;
 		GLuint m_fboBuffers;
 		GLuint m_fsRectVAO, m_fsRectVBO;
 		GLuint m_fbo, m_rt, m_depth;
 		GLuint m_shader, m_svarCurTimeLoc;
-
-		sf::Int16 m_audio[1024 * 2];
-		float m_pixels[1024 * 4];
 	};
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <SHADERed/Objects/CommandLineOptionParser.h>
 #include <string.h>
+#include <algorithm>
 #include <filesystem>
 #include <vector>
 
@@ -13,6 +14,17 @@ namespace ed {
 		LaunchUI = true;
 		ProjectFile = "";
 		WindowWidth = WindowHeight = 0;
+		Render = false;
+		RenderProject = "";
+		RenderOutput = "";
+		RenderWidth = 800;
+		RenderHeight = 600;
+		RenderFrames = 1;
+		RenderFPS = 60.0f;
+		ReferenceOutput = "";
+		ReferencePass = "";
+		BounceOutput = "";
+		BounceLength = 10.0f;
 	}
 	void CommandLineOptionParser::Parse(const std::filesystem::path& cmdDir, int argc, char* argv[])
 	{
@@ -51,6 +63,78 @@ namespace ed {
 			else if (strcmp(argv[i], "--performance") == 0 || strcmp(argv[i], "-p") == 0) {
 				PerformanceMode = true;
 			}
+			// --render, -r [project]
+			else if (strcmp(argv[i], "--render") == 0 || strcmp(argv[i], "-r") == 0) {
+				Render = true;
+				if (i + 1 < argc) {
+					RenderProject = (cmdDir / argv[i + 1]).generic_string();
+					i++;
+				}
+			}
+			// --out, -o [file]
+			else if (strcmp(argv[i], "--out") == 0 || strcmp(argv[i], "-o") == 0) {
+				if (i + 1 < argc) {
+					RenderOutput = (cmdDir / argv[i + 1]).generic_string();
+					i++;
+				}
+			}
+			// --size, -s [width]x[height]
+			else if (strcmp(argv[i], "--size") == 0 || strcmp(argv[i], "-s") == 0) {
+				if (i + 1 < argc) {
+					int width = 0, height = 0;
+					if (sscanf(argv[i + 1], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+						RenderWidth = width;
+						RenderHeight = height;
+					}
+					i++;
+				}
+			}
+			// --frames, -f [count]
+			else if (strcmp(argv[i], "--frames") == 0 || strcmp(argv[i], "-f") == 0) {
+				if (i + 1 < argc) {
+					RenderFrames = std::max<int>(1, atoi(argv[i + 1]));
+					i++;
+				}
+			}
+			// --fps [fps]
+			else if (strcmp(argv[i], "--fps") == 0) {
+				if (i + 1 < argc) {
+					float fps = atof(argv[i + 1]);
+					if (fps > 0.0f)
+						RenderFPS = fps;
+					i++;
+				}
+			}
+			// --reference [file]
+			else if (strcmp(argv[i], "--reference") == 0) {
+				if (i + 1 < argc) {
+					ReferenceOutput = (cmdDir / argv[i + 1]).generic_string();
+					i++;
+				}
+			}
+			// --reference-pass [name]
+			else if (strcmp(argv[i], "--reference-pass") == 0) {
+				if (i + 1 < argc) {
+					ReferencePass = argv[i + 1];
+					i++;
+				}
+			}
+			// --bounce [file]
+			else if (strcmp(argv[i], "--bounce") == 0) {
+				if (i + 1 < argc) {
+					BounceOutput = (cmdDir / argv[i + 1]).generic_string();
+					i++;
+				}
+			}
+			// --bounce-length [seconds]
+			else if (strcmp(argv[i], "--bounce-length") == 0) {
+				if (i + 1 < argc) {
+					float length = atof(argv[i + 1]);
+					if (length > 0.0f)
+						BounceLength = length;
+					i++;
+				}
+			}
 			// --help, -h
 			else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
 				static const std::vector<std::pair<std::string, std::string>> opts = {
@@ -61,6 +145,15 @@ namespace ed {
 					{ "--fullscreen | -fs", "launch SHADERed in fullscreen mode" },
 					{ "--maxmimized | -max", "maximize SHADERed's window" },
 					{ "--performance | -p", "launch SHADERed in performance mode" },
+					{ "--render | -r [project]", "render the project to image files without opening a window" },
+					{ "--out | -o [file]", "output file for --render, use %d for the frame number or .mp4/.mkv/.webm (ffmpeg), .y4m, .raw for a video (default: render.png)" },
+					{ "--size | -s [width]x[height]", "output size for --render (default: 800x600)" },
+					{ "--frames | -f [count]", "number of frames to render with --render (default: 1)" },
+					{ "--fps [fps]", "frame rate used to advance time with --render (default: 60)" },
+					{ "--reference [file]", "also render the last frame on the CPU with the shader debugger, save it as a .png and compare it to the GPU output" },
+					{ "--reference-pass [name]", "shader pass used by --reference (default: the last pass that renders to the window)" },
+					{ "--bounce [file]", "render the audio passes to a .wav/.ogg/.flac file with --render (faster than real time, no audio device needed)" },
+					{ "--bounce-length [seconds]", "length of the --bounce output (default: 10)" },
 				};
 
 				int maxSize = 0;
@@ -76,5 +169,9 @@ namespace ed {
 			else if (std::filesystem::exists(cmdDir / argv[i]))
 				ProjectFile = (cmdDir / argv[i]).generic_string();
 		}
+
+		// relative to the directory SHADERed was called from, not the working directory
+		if (Render && RenderOutput.empty())
+			RenderOutput = (cmdDir / "render.png").generic_string();
 	}
 }
\ No newline at end of file
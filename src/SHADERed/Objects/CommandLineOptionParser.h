@@ -17,5 +17,17 @@ namespace ed {
 		int WindowWidth, WindowHeight;
 		bool MinimalMode;
 		std::string ProjectFile;
+
+		// headless rendering
+		bool Render;
+		std::string RenderProject;
+		std::string RenderOutput;
+		int RenderWidth, RenderHeight;
+		int RenderFrames;
+		float RenderFPS;
+		std::string ReferenceOutput; // CPU (SPIR-V VM) render of the last frame
+		std::string ReferencePass;
+		std::string BounceOutput; // audio passes -> .wav/.ogg/.flac
+		float BounceLength;
 	};
 }
\ No newline at end of file
@@ -1,7 +1,14 @@
+#include <SHADERed/Engine/Timer.h>
 #include <SHADERed/Objects/DebugInformation.h>
+#include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iomanip>
+#include <mutex>
+#include <thread>
 
 #define GET_VALUE_WITH_CHECK_FLOAT(val, c) (val == nullptr ? 0.0f : val->members[c].value.f)
 #define GET_VALUE2_WITH_CHECK_FLOAT(val, c, r) (val == nullptr ? 0.0f : val->members[c].members[r].value.f)
@@ -25,17 +32,41 @@ namespace ed {
 		m_shaderImmediate = nullptr;
 		m_msgs = msgs;
 
+		for (int i = 0; i < 4; i++)
+			m_quadFragCoord[i] = glm::vec2(1.0f);
+
 		m_vmContext = spvm_context_initialize();
 		m_vmGLSL = spvm_build_glsl450_ext();
 	}
 	DebugInformation::~DebugInformation()
 	{
 		m_resetVM();
+		ClearImageCache();
 
 		free(m_vmGLSL);
 		spvm_context_deinitialize(m_vmContext);
 	}
 	
+	void DebugInformation::ClearImageCache()
+	{
+		for (auto& cached : m_imageCache) {
+			free(cached.second.Image->data);
+			free(cached.second.Image);
+		}
+		m_imageCache.clear();
+	}
+	void DebugInformation::m_pruneImageCache()
+	{
+		// drop the copies of textures that were written to or deleted since they were read
+		for (auto it = m_imageCache.begin(); it != m_imageCache.end();) {
+			if (m_objs->GetTextureGeneration(it->first) != it->second.Generation) {
+				free(it->second.Image->data);
+				free(it->second.Image);
+				it = m_imageCache.erase(it);
+			} else
+				it++;
+		}
+	}
 	void DebugInformation::m_resetVM()
 	{
 		for (spvm_image_t img : m_images) {
@@ -360,6 +391,7 @@ namespace ed {
 		}
 
 		// textures, buffers [TODO], etc...
+		m_pruneImageCache();
 		int sampler2Dloc = 0;
 		for (spvm_word i = 0; i < m_shader->bound; i++) {
 			spvm_result_t slot = &m_vm->results[i];
@@ -406,6 +438,18 @@ namespace ed {
 							sampler2Dloc++;
 						} 
 						else {
+							// unchanged textures are shared between debug sessions - storage images aren't since the shader can write to them
+							GLuint cacheTex = pluginUsesCustomTextures ? 0 : srvs[sampler2Dloc];
+							unsigned int cacheGeneration = (cacheTex != 0 && type_info->value_type == spvm_value_type_sampled_image) ? m_objs->GetTextureGeneration(cacheTex) : 0;
+							if (cacheGeneration != 0) {
+								auto cached = m_imageCache.find(cacheTex);
+								if (cached != m_imageCache.end() && cached->second.Generation == cacheGeneration) {
+									slot->members[0].image_data = cached->second.Image;
+									sampler2Dloc++;
+									continue;
+								}
+							}
+
 							spvm_image_t img = (spvm_image_t)malloc(sizeof(spvm_image));
 							
 							if (type_info->image_info == NULL)
@@ -545,7 +589,10 @@ namespace ed {
 								img->user_data = (void*)srvs[sampler2Dloc];
 
 							slot->members[0].image_data = img;
-							m_images.push_back(img);
+							if (cacheGeneration != 0)
+								m_imageCache[cacheTex] = { cacheGeneration, img };
+							else
+								m_images.push_back(img);
 							sampler2Dloc++;
 						}
 					}
@@ -1138,51 +1185,64 @@ namespace ed {
 	{
 		m_pixel = &pixel;
 
-		glm::vec3 weights = m_processWeight(glm::ivec2(0, 0));
-		m_interpolateValues(m_vm, weights);
+		const std::vector<struct spvm_result>* vsOutput[3] = { &pixel.VertexShaderOutput[0], &pixel.VertexShaderOutput[1], &pixel.VertexShaderOutput[2] };
 
+		// the 2x2 quad: the picked pixel + its neighbours in the lanes that spvm uses for dFdx/dFdy/fwidth & implicit LOD
+		spvm_state_t lanes[4] = { m_vm, nullptr, nullptr, nullptr };
 		if (m_vm->derivative_used && !m_vm->_derivative_is_group_member) {
-			spvm_byte isOddX = ((int)pixel.Coordinate.x) % 2 != 0;
-			spvm_byte isOddY = ((int)pixel.Coordinate.y) % 2 != 0;
-			float modX = 1, modY = 1;
+			lanes[1] = m_vm->derivative_group_x;
+			lanes[2] = m_vm->derivative_group_y;
+			lanes[3] = m_vm->derivative_group_d;
+		}
 
-			// setup frag_coord
-			if (isOddX) modX = -1;
-			if (isOddY) modY = -1;
-			
-			if (m_vm->derivative_group_x) {
-				weights = m_processWeight(glm::ivec2(modX, 0));
-				m_interpolateValues(m_vm->derivative_group_x, weights);
-			}
-			if (m_vm->derivative_group_y) {
-				weights = m_processWeight(glm::ivec2(0, modY));
-				m_interpolateValues(m_vm->derivative_group_y, weights);
-			}
-			if (m_vm->derivative_group_d) {
-				weights = m_processWeight(glm::ivec2(modX, modY));
-				m_interpolateValues(m_vm->derivative_group_d, weights);
-			}
+		glm::ivec2 mod = m_getQuadDirection(pixel.Coordinate);
+		glm::ivec2 offsets[4] = { glm::ivec2(0, 0), glm::ivec2(mod.x, 0), glm::ivec2(0, mod.y), mod };
+
+		glm::vec3 invW(0.0f);
+		for (int i = 0; i < 3; i++)
+			invW[i] = pixel.glPosition[i].w == 0.0f ? 0.0f : (1.0f / pixel.glPosition[i].w);
+		glm::vec3 ndcZ = glm::vec3(pixel.glPosition[0].z, pixel.glPosition[1].z, pixel.glPosition[2].z) * invW;
+
+		for (int i = 0; i < 4; i++) {
+			if (lanes[i] == nullptr)
+				continue;
+
+			// z and 1/w are linear in screen space, the varyings are perspective corrected
+			glm::vec3 weights = m_getScreenWeights(offsets[i]);
+			m_quadFragCoord[i] = glm::vec2(glm::dot(weights, ndcZ) * 0.5f + 0.5f, glm::dot(weights, invW));
+
+			m_interpolateValues(lanes[i], vsOutput, weights * invW);
 		}
 	}
-	glm::vec3 DebugInformation::m_processWeight(glm::ivec2 offset)
+	glm::vec3 DebugInformation::m_getScreenWeights(glm::ivec2 offset)
 	{
 		// !!! m_pixel must be set !!!
 
-		glm::vec2 pxPosition = glm::vec2(m_pixel->Coordinate + offset) / glm::vec2(m_pixel->RenderTextureSize - 1);
+		// sample at the pixel center, like the rasterizer does
+		glm::vec2 pxPosition = (glm::vec2(m_pixel->Coordinate + offset) + 0.5f) / glm::vec2(m_pixel->RenderTextureSize);
 
-		// weigths
 		glm::vec2 scrnPos1 = m_getScreenCoord(m_pixel->glPosition[0]);
 		glm::vec2 scrnPos2 = m_getScreenCoord(m_pixel->glPosition[1]);
 		glm::vec2 scrnPos3 = m_getScreenCoord(m_pixel->glPosition[2]);
-		glm::vec3 weights = m_getWeights(scrnPos1, scrnPos2, scrnPos3, pxPosition);
-		weights *= glm::vec3(m_pixel->glPosition[0].w == 0.0f ? 0.0f : (1.0f / m_pixel->glPosition[0].w), m_pixel->glPosition[1].w == 0.0f ? 0.0f : (1.0f / m_pixel->glPosition[1].w), m_pixel->glPosition[2].w == 0.0f ? 0.0f : (1.0f / m_pixel->glPosition[2].w));
-	
-		return weights;
+		return m_getWeights(scrnPos1, scrnPos2, scrnPos3, pxPosition);
 	}
-	void DebugInformation::m_interpolateValues(spvm_state_t state, glm::vec3 weights)
+	void DebugInformation::m_setFragCoord(int x, int y)
 	{
-		// !!! m_pixel must be set !!!
+		// spvm_state_set_frag_coord hands the same z & w to the whole quad - overwrite the neighbours' values
+		spvm_state_set_frag_coord(m_vm, x + 0.5f, y + 0.5f, m_quadFragCoord[0].x, m_quadFragCoord[0].y);
 
+		if (!m_vm->derivative_used || m_vm->_derivative_is_group_member)
+			return;
+
+		glm::ivec2 mod = m_getQuadDirection(glm::ivec2(x, y));
+		spvm_state_t lanes[3] = { m_vm->derivative_group_x, m_vm->derivative_group_y, m_vm->derivative_group_d };
+		glm::ivec2 offsets[3] = { glm::ivec2(mod.x, 0), glm::ivec2(0, mod.y), mod };
+		for (int i = 0; i < 3; i++)
+			if (lanes[i])
+				spvm_state_set_frag_coord(lanes[i], x + offsets[i].x + 0.5f, y + offsets[i].y + 0.5f, m_quadFragCoord[i + 1].x, m_quadFragCoord[i + 1].y);
+	}
+	void DebugInformation::m_interpolateValues(spvm_state_t state, const std::vector<struct spvm_result>* const vsOutput[3], glm::vec3 weights)
+	{
 		float weightSum = weights.x + weights.y + weights.z;
 
 		// match the ps input with vs output
@@ -1205,12 +1265,12 @@ namespace ed {
 					}
 
 				// get vs output index
-				for (int j = 0; j < m_pixel->VertexShaderOutput[0].size(); j++) {
-					const struct spvm_result* vsOutput = &m_pixel->VertexShaderOutput[0][j];
-					if (vsOutput->return_type == loc) {
+				for (int j = 0; j < vsOutput[0]->size(); j++) {
+					const struct spvm_result* output = &(*vsOutput[0])[j];
+					if (output->return_type == loc) {
 						if (loc == -1) {
-							if (vsOutput->name && slot->name)
-								if (strcmp(vsOutput->name, slot->name) == 0) {
+							if (output->name && slot->name)
+								if (strcmp(output->name, slot->name) == 0) {
 									outputIndex = j;
 									break;
 								}
@@ -1223,9 +1283,9 @@ namespace ed {
 
 				// copy and interpolate values
 				if (outputIndex >= 0) {
-					const struct spvm_result* value0 = m_pixel->VertexShaderOutput[0].empty() ? nullptr : &m_pixel->VertexShaderOutput[0][outputIndex];
-					const struct spvm_result* value1 = m_pixel->VertexShaderOutput[1].empty() ? nullptr : &m_pixel->VertexShaderOutput[1][outputIndex];
-					const struct spvm_result* value2 = m_pixel->VertexShaderOutput[2].empty() ? nullptr : &m_pixel->VertexShaderOutput[2][outputIndex];
+					const struct spvm_result* value0 = vsOutput[0]->empty() ? nullptr : &(*vsOutput[0])[outputIndex];
+					const struct spvm_result* value1 = vsOutput[1]->empty() ? nullptr : &(*vsOutput[1])[outputIndex];
+					const struct spvm_result* value2 = vsOutput[2]->empty() ? nullptr : &(*vsOutput[2])[outputIndex];
 
 					// get type
 					spvm_result_t memType = spvm_state_get_type_info(state->results, pointer);
@@ -1272,20 +1332,21 @@ namespace ed {
 			return glm::vec4(0.0f);
 
 		spvm_state_prepare(m_vm, fnMain);
-		spvm_state_set_frag_coord(m_vm, x + 0.5f, y + 0.5f, 1.0f, 1.0f); // TODO: z and w components
+		m_setFragCoord(x, y);
 		spvm_state_call_function(m_vm);
 
+		return m_getPixelShaderOutput(m_vm, loc);
+	}
+	glm::vec4 DebugInformation::m_getPixelShaderOutput(spvm_state_t state, int loc)
+	{
 		glm::vec4 ret(0.0f);
 
-		spvm_word mCount = 0;
-		spvm_member_t pointer = nullptr;
-
 		for (spvm_word i = 0; i < m_shader->bound; i++) {
-			spvm_result_t slot = &m_vm->results[i];
+			spvm_result_t slot = &state->results[i];
 			spvm_result_t type = nullptr, pointerType = nullptr;
 			if (slot->pointer) {
-				type = spvm_state_get_type_info(m_vm->results, &m_vm->results[slot->pointer]);
-				pointerType = &m_vm->results[slot->pointer];
+				type = spvm_state_get_type_info(state->results, &state->results[slot->pointer]);
+				pointerType = &state->results[slot->pointer];
 			}
 
 			if (slot->member_count == 0 || pointerType == nullptr || pointerType->storage_class != SpvStorageClassOutput)
@@ -1311,6 +1372,444 @@ namespace ed {
 		return glm::clamp(ret, 0.0f, 1.0f);
 	}
 
+	bool DebugInformation::m_getReferenceVertices(PipelineItem* item, std::vector<eng::Model::Mesh::Vertex>& verts, int& instanceCount, BufferObject*& instanceBuffer)
+	{
+		instanceCount = 1;
+		instanceBuffer = nullptr;
+
+		if (item->Type == PipelineItem::ItemType::Geometry) {
+			pipe::GeometryItem* geoData = (pipe::GeometryItem*)item->Data;
+			if (geoData->Topology != GL_TRIANGLES)
+				return false;
+
+			if (geoData->Instanced) {
+				instanceCount = std::max<int>(1, geoData->InstanceCount);
+				instanceBuffer = (BufferObject*)geoData->InstanceBuffer;
+			}
+
+			bool isNDC = geoData->Type == pipe::GeometryItem::GeometryType::ScreenQuadNDC;
+			int stride = isNDC ? 4 : 18;
+
+			GLint bufSize = 0;
+			glBindBuffer(GL_ARRAY_BUFFER, geoData->VBO);
+			glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufSize);
+			std::vector<GLfloat> bufData(bufSize / sizeof(GLfloat));
+			glGetBufferSubData(GL_ARRAY_BUFFER, 0, bufData.size() * sizeof(GLfloat), bufData.data());
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			verts.resize(bufData.size() / stride);
+			for (int i = 0; i < verts.size(); i++) {
+				const GLfloat* vData = &bufData[i * stride];
+				if (isNDC) {
+					verts[i].Position = glm::vec3(vData[0], vData[1], 0.0f);
+					verts[i].TexCoords = glm::vec2(vData[2], vData[3]);
+				} else {
+					verts[i].Position = glm::make_vec3(vData + 0);
+					verts[i].Normal = glm::make_vec3(vData + 3);
+					verts[i].TexCoords = glm::make_vec2(vData + 6);
+					verts[i].Tangent = glm::make_vec3(vData + 8);
+					verts[i].Binormal = glm::make_vec3(vData + 11);
+					verts[i].Color = glm::make_vec4(vData + 14);
+				}
+			}
+
+			return true;
+		} else if (item->Type == PipelineItem::ItemType::Model) {
+			pipe::Model* objData = (pipe::Model*)item->Data;
+			if (objData->Data == nullptr)
+				return false;
+
+			if (objData->Instanced) {
+				instanceCount = std::max<int>(1, objData->InstanceCount);
+				instanceBuffer = (BufferObject*)objData->InstanceBuffer;
+			}
+
+			for (const auto& mesh : objData->Data->Meshes) {
+				if (objData->OnlyGroup && mesh.Name != objData->GroupName)
+					continue;
+
+				for (unsigned int index : mesh.Indices)
+					verts.push_back(mesh.Vertices[index]);
+			}
+
+			return true;
+		} else if (item->Type == PipelineItem::ItemType::VertexBuffer) {
+			pipe::VertexBuffer* vbData = (pipe::VertexBuffer*)item->Data;
+			BufferObject* bufData = (BufferObject*)vbData->Buffer;
+			if (vbData->Topology != GL_TRIANGLES || bufData == nullptr || bufData->Data == nullptr)
+				return false;
+
+			std::vector<ShaderVariable::ValueType> tData = m_objs->ParseBufferFormat(bufData->ViewFormat);
+
+			int stride = 0;
+			for (const auto& dataEl : tData)
+				stride += ShaderVariable::GetSize(dataEl, true);
+			if (stride == 0)
+				return false;
+
+			verts.resize(bufData->Size / stride);
+			for (int i = 0; i < verts.size(); i++) {
+				const GLfloat* vData = (const GLfloat*)((const char*)bufData->Data + i * stride);
+
+				int iOffset = 0;
+				for (int j = 0; j < tData.size() && j < 3; j++) {
+					if (j == 0) /* POSITION */
+						verts[i].Position = glm::make_vec3(vData + iOffset);
+					else if (j == 1)
+						verts[i].Normal = glm::make_vec3(vData + iOffset);
+					else if (j == 2)
+						verts[i].TexCoords = glm::make_vec2(vData + iOffset);
+
+					iOffset += ShaderVariable::GetSize(tData[j]) / 4;
+				}
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+	spvm_state_t DebugInformation::m_createSharedState(std::vector<std::pair<spvm_result_t, spvm_result>>& borrowed)
+	{
+		spvm_state_t state = _spvm_state_create_base(m_shader, 1, 0);
+		spvm_state_set_extension(state, "GLSL.std.450", m_vmGLSL);
+
+		// point uniforms, textures and buffers to m_vm's values instead of copying them
+		spvm_state_t targets[4] = { state, state->derivative_group_x, state->derivative_group_y, state->derivative_group_d };
+		for (int t = 0; t < 4; t++) {
+			if (targets[t] == nullptr)
+				continue;
+
+			for (spvm_word i = 0; i < m_shader->bound; i++) {
+				spvm_result_t src = &m_vm->results[i];
+				if (src->pointer == 0 || src->members == nullptr)
+					continue;
+
+				spvm_result_t ptrInfo = &m_vm->results[src->pointer];
+				if (ptrInfo->value_type != spvm_value_type_pointer)
+					continue;
+				if (ptrInfo->storage_class != SpvStorageClassUniform && ptrInfo->storage_class != SpvStorageClassUniformConstant && ptrInfo->storage_class != SpvStorageClassStorageBuffer)
+					continue;
+
+				spvm_result_t dst = &targets[t]->results[i];
+				borrowed.push_back(std::make_pair(dst, *dst));
+				dst->members = src->members;
+				dst->member_count = src->member_count;
+			}
+		}
+
+		return state;
+	}
+	bool DebugInformation::m_writesSharedMemory()
+	{
+		// storage buffers & storage images - they are borrowed from m_vm by m_createSharedState()
+		for (spvm_word i = 0; i < m_shader->bound; i++) {
+			spvm_result_t slot = &m_vm->results[i];
+			if (slot->pointer == 0)
+				continue;
+
+			spvm_result_t pointerInfo = &m_vm->results[slot->pointer];
+			if (pointerInfo->value_type != spvm_value_type_pointer)
+				continue;
+
+			if (pointerInfo->storage_class == SpvStorageClassStorageBuffer)
+				return true;
+
+			spvm_result_t type_info = spvm_state_get_type_info(m_vm->results, pointerInfo);
+			if (pointerInfo->storage_class == SpvStorageClassUniform) {
+				for (int j = 0; j < type_info->decoration_count; j++)
+					if (type_info->decorations[j].type == SpvDecorationBufferBlock)
+						return true;
+			} else if (pointerInfo->storage_class == SpvStorageClassUniformConstant && type_info->value_type == spvm_value_type_image)
+				return true;
+		}
+
+		return false;
+	}
+	void DebugInformation::m_deleteSharedState(spvm_state_t state, std::vector<std::pair<spvm_result_t, spvm_result>>& borrowed)
+	{
+		// give back the state's own values so that m_vm's don't get freed twice
+		for (auto& b : borrowed) {
+			b.first->members = b.second.members;
+			b.first->member_count = b.second.member_count;
+		}
+		borrowed.clear();
+
+		spvm_state_delete(state);
+	}
+	bool DebugInformation::RenderReference(PipelineItem* pass, int loc, glm::ivec2 size, const glm::vec4& clearColor, std::vector<unsigned char>& outPixels, ReferenceRenderInfo* info)
+	{
+		if (pass->Type != PipelineItem::ItemType::ShaderPass) {
+			Logger::Get().Log("Reference rendering is only supported for shader passes", true);
+			return false;
+		}
+		if (size.x <= 0 || size.y <= 0)
+			return false;
+
+		pipe::ShaderPass* passData = (pipe::ShaderPass*)pass->Data;
+
+		eng::Timer timer;
+
+		int tCount = std::thread::hardware_concurrency();
+		tCount = tCount == 0 ? 2 : tCount;
+
+		glm::ivec2 tiles = (size + DEBUG_REFERENCE_TILE_SIZE - 1) / DEBUG_REFERENCE_TILE_SIZE;
+		int tileCount = tiles.x * tiles.y;
+		tCount = std::min<int>(tCount, tileCount);
+
+		std::vector<glm::vec4> colors(size.x * size.y, clearColor);
+		std::vector<float> depth(size.x * size.y, 1.0f);
+		std::atomic<size_t> pixelCount(0), invocationCount(0);
+		int usedThreads = 1;
+
+		// viewport size for the system variables
+		PixelInformation px;
+		px.RenderTextureSize = size;
+
+		for (PipelineItem* item : passData->Items) {
+			std::vector<eng::Model::Mesh::Vertex> verts;
+			int instanceCount = 1;
+			BufferObject* instanceBuffer = nullptr;
+			if (!m_getReferenceVertices(item, verts, instanceCount, instanceBuffer)) {
+				Logger::Get().Log("Skipping " + std::string(item->Name) + " in the reference render - only triangle lists are supported");
+				continue;
+			}
+
+			// vertex shader - runs on this thread since it might have to read instance data from GL
+			std::vector<glm::vec4> positions;
+			std::vector<std::vector<struct spvm_result>> outputs;
+			positions.reserve(verts.size() * instanceCount);
+			outputs.reserve(verts.size() * instanceCount);
+
+			PrepareVertexShader(pass, item, &px);
+			if (m_vm == nullptr)
+				continue;
+			for (int inst = 0; inst < instanceCount; inst++) {
+				for (int v = 0; v < verts.size(); v++) {
+					SetVertexShaderInput(pass, verts[v], v, inst, instanceBuffer);
+					positions.push_back(ExecuteVertexShader());
+
+					PixelInformation vsCopy;
+					CopyVertexShaderOutput(vsCopy, 0);
+					outputs.push_back(std::move(vsCopy.VertexShaderOutput[0]));
+				}
+			}
+
+			// primitive setup & binning
+			struct Triangle {
+				int Vertex; // first vertex
+				glm::vec2 Screen[3];
+				glm::vec3 Z;
+				glm::vec3 InvW;
+			};
+			std::vector<Triangle> tris;
+			std::vector<std::vector<int>> bins(tileCount);
+			for (int v = 0; v + 2 < positions.size(); v += 3) {
+				// no near plane clipping
+				if (positions[v].w <= 0.0f || positions[v + 1].w <= 0.0f || positions[v + 2].w <= 0.0f)
+					continue;
+
+				Triangle tri;
+				tri.Vertex = v;
+				for (int j = 0; j < 3; j++) {
+					tri.Screen[j] = m_getScreenCoord(positions[v + j]);
+					tri.Z[j] = positions[v + j].z / positions[v + j].w;
+					tri.InvW[j] = 1.0f / positions[v + j].w;
+				}
+
+				glm::vec2 bbMin = glm::min(tri.Screen[0], glm::min(tri.Screen[1], tri.Screen[2])) * glm::vec2(size);
+				glm::vec2 bbMax = glm::max(tri.Screen[0], glm::max(tri.Screen[1], tri.Screen[2])) * glm::vec2(size);
+				glm::ivec2 tMin = glm::clamp(glm::ivec2(glm::floor(bbMin)) / DEBUG_REFERENCE_TILE_SIZE, glm::ivec2(0), tiles - 1);
+				glm::ivec2 tMax = glm::clamp(glm::ivec2(glm::floor(bbMax)) / DEBUG_REFERENCE_TILE_SIZE, glm::ivec2(0), tiles - 1);
+				if (bbMax.x < 0.0f || bbMax.y < 0.0f || bbMin.x > size.x || bbMin.y > size.y)
+					continue;
+
+				int triIndex = tris.size();
+				tris.push_back(tri);
+				for (int ty = tMin.y; ty <= tMax.y; ty++)
+					for (int tx = tMin.x; tx <= tMax.x; tx++)
+						bins[ty * tiles.x + tx].push_back(triIndex);
+			}
+
+			// pixel shader
+			PreparePixelShader(pass, item, &px);
+			spvm_word fnMain = m_vm == nullptr ? 0 : spvm_state_get_result_location(m_vm, "main");
+			if (fnMain != 0 && !tris.empty()) {
+				// the workers share m_vm's buffers & images - the order of the writes to them would depend on the scheduling
+				int wCount = m_writesSharedMemory() ? 1 : tCount;
+				usedThreads = std::max<int>(usedThreads, wCount);
+
+				std::vector<spvm_state_t> states(wCount);
+				std::vector<std::vector<std::pair<spvm_result_t, spvm_result>>> borrowed(wCount);
+				for (int i = 0; i < wCount; i++)
+					states[i] = m_createSharedState(borrowed[i]);
+
+				auto shadeTile = [&](int worker, int tile) {
+					spvm_state_t state = states[worker];
+					spvm_state_t groups[3] = { state->derivative_group_x, state->derivative_group_y, state->derivative_group_d };
+					bool useDerivatives = state->derivative_used && !state->_derivative_is_group_member;
+
+					struct Fragment {
+						float Z;
+						int Triangle;
+						glm::vec3 Weights;
+					};
+					std::vector<Fragment> frags;
+
+					glm::ivec2 tMin = glm::ivec2(tile % tiles.x, tile / tiles.x) * DEBUG_REFERENCE_TILE_SIZE;
+					glm::ivec2 tMax = glm::min(tMin + DEBUG_REFERENCE_TILE_SIZE, size);
+
+					for (int y = tMin.y; y < tMax.y; y++) {
+						for (int x = tMin.x; x < tMax.x; x++) {
+							int index = y * size.x + x;
+							glm::vec2 pxPosition((x + 0.5f) / size.x, (y + 0.5f) / size.y);
+
+							// all the fragments that pass the depth test, nearest first
+							frags.clear();
+							for (int triIndex : bins[tile]) {
+								const Triangle& tri = tris[triIndex];
+								glm::vec3 weights = m_getWeights(tri.Screen[0], tri.Screen[1], tri.Screen[2], pxPosition);
+								if (weights.x < 0.0f || weights.y < 0.0f || weights.z < 0.0f)
+									continue;
+
+								float z = glm::dot(weights, tri.Z);
+								if (z < -1.0f || z > 1.0f || z * 0.5f + 0.5f >= depth[index])
+									continue;
+
+								frags.push_back({ z, triIndex, weights });
+							}
+							std::sort(frags.begin(), frags.end(), [](const Fragment& a, const Fragment& b) { return a.Z < b.Z; });
+
+							for (const Fragment& frag : frags) {
+								const Triangle& tri = tris[frag.Triangle];
+								const std::vector<struct spvm_result>* vsOutput[3] = { &outputs[tri.Vertex], &outputs[tri.Vertex + 1], &outputs[tri.Vertex + 2] };
+
+								m_interpolateValues(state, vsOutput, frag.Weights * tri.InvW);
+
+								// the other pixels in the 2x2 quad - gl_FragCoord.zw of each lane, same as m_setFragCoord()
+								glm::vec2 offsets[3];
+								glm::vec2 laneFragCoord[3];
+								if (useDerivatives) {
+									glm::ivec2 mod = m_getQuadDirection(glm::ivec2(x, y));
+									offsets[0] = glm::vec2(mod.x, 0.0f);
+									offsets[1] = glm::vec2(0.0f, mod.y);
+									offsets[2] = glm::vec2(mod);
+
+									for (int g = 0; g < 3; g++) {
+										if (groups[g] == nullptr)
+											continue;
+
+										glm::vec2 nPosition = pxPosition + offsets[g] / glm::vec2(size);
+										glm::vec3 nWeights = m_getWeights(tri.Screen[0], tri.Screen[1], tri.Screen[2], nPosition);
+										m_interpolateValues(groups[g], vsOutput, nWeights * tri.InvW);
+										laneFragCoord[g] = glm::vec2(glm::dot(nWeights, tri.Z) * 0.5f + 0.5f, glm::dot(nWeights, tri.InvW));
+									}
+								}
+
+								state->discarded = 0;
+								spvm_state_prepare(state, fnMain);
+								spvm_state_set_frag_coord(state, x + 0.5f, y + 0.5f, frag.Z * 0.5f + 0.5f, glm::dot(frag.Weights, tri.InvW));
+								if (useDerivatives)
+									for (int g = 0; g < 3; g++)
+										if (groups[g] != nullptr)
+											spvm_state_set_frag_coord(groups[g], x + offsets[g].x + 0.5f, y + offsets[g].y + 0.5f, laneFragCoord[g].x, laneFragCoord[g].y);
+								spvm_state_call_function(state);
+								invocationCount++;
+
+								if (state->discarded)
+									continue;
+
+								colors[index] = m_getPixelShaderOutput(state, loc);
+								depth[index] = frag.Z * 0.5f + 0.5f;
+								pixelCount++;
+								break;
+							}
+						}
+					}
+				};
+
+				// work stealing - each worker starts with its own range of tiles and steals from the back of the busiest queue once it's done
+				std::vector<std::deque<int>> queues(wCount);
+				std::vector<std::mutex> queueLocks(wCount);
+				for (int i = 0; i < tileCount; i++)
+					queues[(size_t)i * wCount / tileCount].push_back(i);
+
+				auto work = [&](int worker) {
+					while (true) {
+						int tile = -1;
+						{
+							std::lock_guard<std::mutex> lock(queueLocks[worker]);
+							if (!queues[worker].empty()) {
+								tile = queues[worker].front();
+								queues[worker].pop_front();
+							}
+						}
+
+						if (tile == -1) {
+							int victim = -1;
+							size_t victimSize = 0;
+							for (int i = 0; i < wCount; i++) {
+								std::lock_guard<std::mutex> lock(queueLocks[i]);
+								if (queues[i].size() > victimSize) {
+									victimSize = queues[i].size();
+									victim = i;
+								}
+							}
+
+							if (victim == -1)
+								break;
+
+							std::lock_guard<std::mutex> lock(queueLocks[victim]);
+							if (queues[victim].empty())
+								continue;
+							tile = queues[victim].back();
+							queues[victim].pop_back();
+						}
+
+						shadeTile(worker, tile);
+					}
+				};
+
+				std::vector<std::thread> threads;
+				for (int i = 1; i < wCount; i++)
+					threads.push_back(std::thread(work, i));
+				work(0);
+				for (auto& thread : threads)
+					thread.join();
+
+				for (int i = 0; i < wCount; i++)
+					m_deleteSharedState(states[i], borrowed[i]);
+			}
+
+			for (auto& vertexOutput : outputs) {
+				for (auto& output : vertexOutput) {
+					if (output.name != nullptr)
+						free(output.name);
+					spvm_member_free(output.members, output.member_count);
+				}
+			}
+		}
+
+		m_resetVM();
+
+		outPixels.resize(size.x * size.y * 4);
+		for (int i = 0; i < colors.size(); i++)
+			for (int c = 0; c < 4; c++)
+				outPixels[i * 4 + c] = (unsigned char)(colors[i][c] * 255.0f + 0.5f);
+
+		float time = timer.GetElapsedTime();
+		if (info != nullptr) {
+			info->Threads = usedThreads;
+			info->Pixels = pixelCount;
+			info->Invocations = invocationCount;
+			info->Time = time;
+		}
+
+		Logger::Get().Log("Reference render of " + std::string(pass->Name) + " took " + std::to_string(time) + "s (" + std::to_string((size_t)(size.x * size.y / std::max<float>(time, 1e-6f))) + " pixels/s)");
+
+		return true;
+	}
+
 	void DebugInformation::PrepareDebugger()
 	{
 		spvm_word fnMain = spvm_state_get_result_location(m_vm, "main");
@@ -1323,7 +1822,7 @@ namespace ed {
 		spvm_state_prepare(m_vm, fnMain);
 
 		if (m_stage == ShaderStage::Pixel && m_pixel != nullptr)
-			spvm_state_set_frag_coord(m_vm, m_pixel->Coordinate.x + 0.5f, m_pixel->Coordinate.y + 0.5f, 1.0f, 1.0f); // TODO: z and w components
+			m_setFragCoord(m_pixel->Coordinate.x, m_pixel->Coordinate.y);
 
 		// move to cursor to first line in the function
 		spvm_state_step_into(m_vm);
@@ -9,6 +9,9 @@
 #endif
 
 #include <sstream>
+#include <unordered_map>
+
+#define DEBUG_REFERENCE_TILE_SIZE 16
 
 extern "C" {
 	#include <spvm/program.h>
@@ -17,6 +20,13 @@ extern "C" {
 }
 
 namespace ed {
+	struct ReferenceRenderInfo {
+		int Threads;
+		size_t Pixels;		// fragments written to the render target
+		size_t Invocations; // pixel shader executions, discarded fragments included
+		float Time;			// in seconds
+	};
+
 	class DebugInformation {
 	public:
 		DebugInformation(ObjectManager* objs, RenderEngine* renderer, MessageStack* msgs);
@@ -45,8 +55,17 @@ namespace ed {
 		void SetPixelShaderInput(PixelInformation& pixel);
 		glm::vec4 ExecutePixelShader(int x, int y, int loc = 0);
 
+		// GPU-free reference render: the pass' shaders run in the SPIR-V VM for every pixel of its loc-th render target,
+		// in parallel (one VM state per worker, the program, uniforms and textures are shared)
+		// only the vertex data and textures are read from GL - outPixels is RGBA8 with the bottom row first, like glGetTexImage
+		// opaque rendering with a GL_LESS depth test, render states and blending are ignored
+		bool RenderReference(PipelineItem* pass, int loc, glm::ivec2 size, const glm::vec4& clearColor, std::vector<unsigned char>& outPixels, ReferenceRenderInfo* info = nullptr);
+
 		spvm_result_t Immediate(const std::string& entry, spvm_result_t& outType);
 
+		// frees the copies of the textures that are kept between debug sessions
+		void ClearImageCache();
+
 		void PrepareDebugger();
 
 		void Jump(int line);
@@ -102,11 +121,31 @@ namespace ed {
 		}
 		glm::vec3 m_getWeights(glm::vec2 a, glm::vec2 b, glm::vec2 c, glm::vec2 p);
 
-		glm::vec3 m_processWeight(glm::ivec2 offset);
-		void m_interpolateValues(spvm_state_t state, glm::vec3 weights);
+		glm::vec3 m_getScreenWeights(glm::ivec2 offset);
+		void m_interpolateValues(spvm_state_t state, const std::vector<struct spvm_result>* const vsOutput[3], glm::vec3 weights);
+		glm::vec4 m_getPixelShaderOutput(spvm_state_t state, int loc);
+
+		// 2x2 quad execution - m_vm and its derivative_group_x/y/d states run in lockstep as the picked pixel's quad,
+		// each lane with its own inputs & gl_FragCoord so that derivatives and the implicit LOD match the GPU
+		inline glm::ivec2 m_getQuadDirection(const glm::ivec2& px) { return glm::ivec2(px.x % 2 != 0 ? -1 : 1, px.y % 2 != 0 ? -1 : 1); }
+		glm::vec2 m_quadFragCoord[4]; // gl_FragCoord.zw of each lane
+		void m_setFragCoord(int x, int y);
+
+		bool m_getReferenceVertices(PipelineItem* item, std::vector<eng::Model::Mesh::Vertex>& verts, int& instanceCount, BufferObject*& instanceBuffer);
+		spvm_state_t m_createSharedState(std::vector<std::pair<spvm_result_t, spvm_result>>& borrowed);
+		void m_deleteSharedState(spvm_state_t state, std::vector<std::pair<spvm_result_t, spvm_result>>& borrowed);
+		bool m_writesSharedMemory(); // pixel shader has storage buffers or images - the reference render then runs on one thread
 
 		std::vector<spvm_image_t> m_images; // TODO: clear these + smart cache
 
+		// texture contents read back by m_copyUniforms - reused while ObjectManager's generation of the texture stays the same
+		struct CachedImage {
+			unsigned int Generation;
+			spvm_image_t Image;
+		};
+		std::unordered_map<GLuint, CachedImage> m_imageCache;
+		void m_pruneImageCache();
+
 
 		spvm_context_t m_vmContext;
 		spvm_ext_opcode_func* m_vmGLSL;
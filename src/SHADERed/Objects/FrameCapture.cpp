@@ -0,0 +1,569 @@
+#include <SHADERed/Objects/FrameCapture.h>
+#include <SHADERed/Objects/Logger.h>
+#include <SHADERed/Options.h>
+
+#include <stb/stb_image_resize.h>
+#include <stb/stb_image_write.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+#define FRAME_CAPTURE_MEMORY_BUDGET (512ull * 1024 * 1024)
+
+namespace ed {
+#if defined(_WIN32)
+	// CommandLineToArgvW() rules - backslashes are only special in front of a quote
+	static std::string quoteArgument(const std::string& arg)
+	{
+		std::string ret = "\"";
+		size_t slashes = 0;
+		for (char c : arg) {
+			if (c == '\\')
+				slashes++;
+			else {
+				if (c == '"')
+					ret.append(slashes + 1, '\\');
+				slashes = 0;
+			}
+			ret += c;
+		}
+		ret.append(slashes, '\\');
+		ret += '"';
+		return ret;
+	}
+#else
+	// ffmpeg can exit early (or not be installed) - writes to its pipe have to fail with EPIPE instead of killing the process
+	// SIGPIPE is only blocked for the calling thread and a SIGPIPE raised in the meantime is dropped before the mask is restored
+	class SIGPIPEBlocker {
+	public:
+		SIGPIPEBlocker()
+		{
+			sigemptyset(&m_set);
+			sigaddset(&m_set, SIGPIPE);
+			pthread_sigmask(SIG_BLOCK, &m_set, &m_old);
+		}
+		~SIGPIPEBlocker()
+		{
+			sigset_t pending;
+			sigpending(&pending);
+			if (sigismember(&pending, SIGPIPE) && !sigismember(&m_old, SIGPIPE)) {
+				int sig;
+				sigwait(&m_set, &sig);
+			}
+			pthread_sigmask(SIG_SETMASK, &m_old, nullptr);
+		}
+
+	private:
+		sigset_t m_set, m_old;
+	};
+#endif
+
+	FrameCapture::FrameCapture()
+	{
+		m_started = false;
+		m_done = false;
+		m_written = 0;
+		m_type = OutputType::Images;
+		m_stream = nullptr;
+		m_ffmpeg = 0;
+		m_curSlot = 0;
+		m_rWidth = m_rHeight = m_width = m_height = 0;
+
+		for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++) {
+			m_pbo[i] = 0;
+			m_fence[i] = nullptr;
+			m_pboFrame[i] = -1;
+		}
+	}
+	FrameCapture::~FrameCapture()
+	{
+		Finish();
+	}
+	bool FrameCapture::Start(const std::string& filenameFormat, int renderWidth, int renderHeight, int width, int height, float fps)
+	{
+		if (m_started || renderWidth <= 0 || renderHeight <= 0 || width <= 0 || height <= 0)
+			return false;
+
+		m_filename = filenameFormat;
+		size_t lastDot = m_filename.find_last_of('.');
+		m_ext = lastDot == std::string::npos ? "png" : m_filename.substr(lastDot + 1);
+		std::transform(m_ext.begin(), m_ext.end(), m_ext.begin(), ::tolower);
+
+		m_rWidth = renderWidth;
+		m_rHeight = renderHeight;
+		m_width = width;
+		m_height = height;
+		m_curSlot = 0;
+		m_written = 0;
+		m_done = false;
+
+		m_type = OutputType::Images;
+		if (m_ext == "y4m")
+			m_type = OutputType::Y4M;
+		else if (m_ext == "raw")
+			m_type = OutputType::Raw;
+		else if (IsVideoFile(m_filename))
+			m_type = OutputType::FFmpeg;
+
+		if (m_type != OutputType::Images && !m_openStream(fps))
+			return false;
+
+		size_t frameSize = (size_t)m_rWidth * m_rHeight * 4;
+
+		glGenBuffers(FRAME_CAPTURE_RING_SIZE, m_pbo);
+		for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+			m_fence[i] = nullptr;
+			m_pboFrame[i] = -1;
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		// two buffers per encoder, but don't eat up all the memory with huge supersampled frames
+		int tCount = std::thread::hardware_concurrency();
+		tCount = tCount == 0 ? 2 : tCount;
+
+		int bufferCount = std::max<int>(2, std::min<size_t>(tCount * 2, FRAME_CAPTURE_MEMORY_BUDGET / frameSize));
+		tCount = std::min<int>(tCount, bufferCount);
+
+		// frames have to reach the stream in order
+		if (m_type != OutputType::Images)
+			tCount = 1;
+
+		for (int i = 0; i < bufferCount; i++) {
+			unsigned char* buffer = (unsigned char*)malloc(frameSize);
+			if (buffer == nullptr)
+				break;
+			m_buffers.push_back(buffer);
+		}
+		m_freeBuffers = m_buffers;
+
+		if (m_buffers.empty()) {
+			Logger::Get().Log("Failed to allocate memory for frame capture", true);
+			glDeleteBuffers(FRAME_CAPTURE_RING_SIZE, m_pbo);
+			m_closeStream();
+			return false;
+		}
+
+		stbi_write_png_compression_level = 5; // set to lowest compression level
+
+		for (int i = 0; i < tCount; i++)
+			m_workers.push_back(std::thread(&FrameCapture::m_encode, this));
+
+		m_started = true;
+
+		return true;
+	}
+	void FrameCapture::Capture(GLuint tex, int frame)
+	{
+		if (!m_started)
+			return;
+
+		int slot = m_curSlot;
+
+		// this slot still holds the frame from FRAME_CAPTURE_RING_SIZE captures ago - copy it out first
+		if (m_pboFrame[slot] != -1)
+			m_readback(slot);
+
+		// asynchronous copy to the PBO
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[slot]);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		m_fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_pboFrame[slot] = frame;
+
+		m_curSlot = (slot + 1) % FRAME_CAPTURE_RING_SIZE;
+	}
+	void FrameCapture::Finish()
+	{
+		if (!m_started)
+			return;
+
+		// flush the frames that are still on the GPU, oldest first
+		for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++) {
+			int slot = (m_curSlot + i) % FRAME_CAPTURE_RING_SIZE;
+			if (m_pboFrame[slot] != -1)
+				m_readback(slot);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_done = true;
+		}
+		m_hasWork.notify_all();
+
+		for (auto& worker : m_workers)
+			if (worker.joinable())
+				worker.join();
+		m_workers.clear();
+
+		for (unsigned char* buffer : m_buffers)
+			free(buffer);
+		m_buffers.clear();
+		m_freeBuffers.clear();
+
+		m_closeStream();
+
+		glDeleteBuffers(FRAME_CAPTURE_RING_SIZE, m_pbo);
+		for (int i = 0; i < FRAME_CAPTURE_RING_SIZE; i++)
+			m_pbo[i] = 0;
+
+		stbi_write_png_compression_level = 8; // set back to default compression level
+
+		m_started = false;
+
+		Logger::Get().Log("Captured " + std::to_string(m_written) + " frames");
+	}
+	void FrameCapture::m_readback(int slot)
+	{
+		size_t frameSize = (size_t)m_rWidth * m_rHeight * 4;
+
+		// frame was issued FRAME_CAPTURE_RING_SIZE-1 renders ago so this rarely has to wait
+		GLenum waitRes = glClientWaitSync(m_fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (waitRes == GL_TIMEOUT_EXPIRED)
+			waitRes = glClientWaitSync(m_fence[slot], 0, 1000000); // 1ms
+		glDeleteSync(m_fence[slot]);
+		m_fence[slot] = nullptr;
+
+		int frame = m_pboFrame[slot];
+		m_pboFrame[slot] = -1;
+
+		// blocks when the encoders fall behind
+		unsigned char* pixels = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_hasFreeBuffer.wait(lock, [&] { return !m_freeBuffers.empty(); });
+			pixels = m_freeBuffers.back();
+			m_freeBuffers.pop_back();
+		}
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[slot]);
+		void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+		if (data != nullptr) {
+			memcpy(pixels, data, frameSize);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		if (data == nullptr) {
+			Logger::Get().Log("Failed to map the pixel buffer for frame " + std::to_string(frame), true);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_freeBuffers.push_back(pixels);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queue.push({ frame, pixels });
+		}
+		m_hasWork.notify_one();
+	}
+	void FrameCapture::m_encode()
+	{
+		bool isResized = m_rWidth != m_width || m_rHeight != m_height;
+
+		std::vector<unsigned char> resized, yuv;
+		if (isResized)
+			resized.resize((size_t)m_width * m_height * 4);
+
+		char path[SHADERED_MAX_PATH];
+
+		while (true) {
+			Frame frame;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_hasWork.wait(lock, [&] { return !m_queue.empty() || m_done; });
+				if (m_queue.empty())
+					break;
+				frame = m_queue.front();
+				m_queue.pop();
+			}
+
+			unsigned char* outPixels = frame.Pixels;
+
+			// resize image
+			if (isResized) {
+				stbir_resize_uint8(frame.Pixels, m_rWidth, m_rHeight, m_rWidth * 4,
+					resized.data(), m_width, m_height, m_width * 4, 4);
+				outPixels = resized.data();
+			}
+
+			bool written = false;
+			if (m_type != OutputType::Images)
+				written = m_writeStream(outPixels, yuv);
+			else {
+				snprintf(path, SHADERED_MAX_PATH, m_filename.c_str(), frame.Index);
+
+				if (m_ext == "jpg" || m_ext == "jpeg")
+					written = stbi_write_jpg(path, m_width, m_height, 4, outPixels, 100);
+				else if (m_ext == "bmp")
+					written = stbi_write_bmp(path, m_width, m_height, 4, outPixels);
+				else if (m_ext == "tga")
+					written = stbi_write_tga(path, m_width, m_height, 4, outPixels);
+				else
+					written = stbi_write_png(path, m_width, m_height, 4, outPixels, m_width * 4);
+
+				if (!written)
+					Logger::Get().Log("Failed to write " + std::string(path), true);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_freeBuffers.push_back(frame.Pixels);
+				m_written += written;
+			}
+			m_hasFreeBuffer.notify_one();
+		}
+	}
+
+	bool FrameCapture::m_openStream(float fps)
+	{
+		if (m_type == OutputType::FFmpeg) {
+			// m_writeStream() flips the rows to top-down, yuv420p needs even dimensions
+			// the arguments are passed as is - no shell is involved
+			char size[64], rate[64];
+			snprintf(size, sizeof(size), "%dx%d", m_width, m_height);
+			snprintf(rate, sizeof(rate), "%.3f", fps);
+			std::vector<std::string> args = { "ffmpeg", "-y", "-loglevel", "error", "-f", "rawvideo", "-pix_fmt", "rgba", "-s", size, "-r", rate, "-i", "-",
+				"-vf", "pad=ceil(iw/2)*2:ceil(ih/2)*2", "-pix_fmt", "yuv420p", m_filename };
+
+#if defined(_WIN32)
+			std::string cmd = "";
+			for (const auto& arg : args)
+				cmd += (cmd.empty() ? "" : " ") + quoteArgument(arg);
+
+			// only the read end is inherited by ffmpeg
+			SECURITY_ATTRIBUTES sa = { sizeof(SECURITY_ATTRIBUTES), NULL, TRUE };
+			HANDLE pipeRead = NULL, pipeWrite = NULL;
+			if (!CreatePipe(&pipeRead, &pipeWrite, &sa, 0)) {
+				Logger::Get().Log("Failed to create a pipe for ffmpeg", true);
+				return false;
+			}
+			SetHandleInformation(pipeWrite, HANDLE_FLAG_INHERIT, 0);
+
+			STARTUPINFOA si = { 0 };
+			si.cb = sizeof(si);
+			si.dwFlags = STARTF_USESTDHANDLES;
+			si.hStdInput = pipeRead;
+			si.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+			si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+			PROCESS_INFORMATION pi = { 0 };
+			std::vector<char> cmdBuffer(cmd.begin(), cmd.end());
+			cmdBuffer.push_back(0);
+			BOOL created = CreateProcessA(NULL, cmdBuffer.data(), NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi);
+			CloseHandle(pipeRead);
+
+			if (!created) {
+				CloseHandle(pipeWrite);
+				Logger::Get().Log("Failed to start ffmpeg", true);
+				return false;
+			}
+			CloseHandle(pi.hThread);
+			m_ffmpeg = pi.hProcess;
+
+			int fd = _open_osfhandle((intptr_t)pipeWrite, _O_WRONLY | _O_BINARY);
+			m_stream = fd == -1 ? nullptr : _fdopen(fd, "wb");
+#else
+			std::vector<char*> argv;
+			for (auto& arg : args)
+				argv.push_back(&arg[0]);
+			argv.push_back(nullptr);
+
+			int fds[2];
+			if (pipe(fds) != 0) {
+				Logger::Get().Log("Failed to create a pipe for ffmpeg", true);
+				return false;
+			}
+			fcntl(fds[1], F_SETFD, FD_CLOEXEC); // don't leak the write end into other child processes
+
+			posix_spawn_file_actions_t actions;
+			posix_spawn_file_actions_init(&actions);
+			posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+			posix_spawn_file_actions_addclose(&actions, fds[0]);
+			posix_spawn_file_actions_addclose(&actions, fds[1]);
+
+			int err = posix_spawnp(&m_ffmpeg, "ffmpeg", &actions, nullptr, argv.data(), environ);
+			posix_spawn_file_actions_destroy(&actions);
+			close(fds[0]);
+
+			if (err != 0) {
+				close(fds[1]);
+				m_ffmpeg = 0;
+				Logger::Get().Log("Failed to start ffmpeg: " + std::string(strerror(err)), true);
+				return false;
+			}
+
+			m_stream = fdopen(fds[1], "wb");
+#endif
+			if (m_stream == nullptr) {
+				Logger::Get().Log("Failed to open the pipe to ffmpeg", true);
+				m_closeStream();
+				return false;
+			}
+
+			std::string cmdLine = "";
+			for (const auto& arg : args)
+				cmdLine += (cmdLine.empty() ? "" : " ") + arg;
+			Logger::Get().Log("Streaming frames to ffmpeg: " + cmdLine);
+		} else {
+			m_stream = fopen(m_filename.c_str(), "wb");
+			if (m_stream == nullptr) {
+				Logger::Get().Log("Failed to open " + m_filename, true);
+				return false;
+			}
+
+			if (m_type == OutputType::Y4M) {
+				// 4:4:4 so that no chroma subsampling is needed, frame rate as a rational
+				fprintf(m_stream, "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C444\n", m_width, m_height, (int)(fps * 1000.0f + 0.5f));
+			}
+		}
+
+		return true;
+	}
+	bool FrameCapture::m_writeStream(const unsigned char* pixels, std::vector<unsigned char>& yuv)
+	{
+		if (m_stream == nullptr)
+			return false;
+
+		size_t rowSize = (size_t)m_width * 4;
+
+#if !defined(_WIN32)
+		SIGPIPEBlocker sigBlock;
+#endif
+
+		// rows are stored bottom-up in the texture
+		if (m_type == OutputType::Raw || m_type == OutputType::FFmpeg) {
+			for (int y = m_height - 1; y >= 0; y--)
+				if (fwrite(pixels + y * rowSize, 1, rowSize, m_stream) != rowSize)
+					return false;
+			return true;
+		}
+
+		// Y4M - BT.601 limited range, planar
+		size_t planeSize = (size_t)m_width * m_height;
+		yuv.resize(planeSize * 3);
+
+		unsigned char* yPlane = yuv.data();
+		unsigned char* uPlane = yPlane + planeSize;
+		unsigned char* vPlane = uPlane + planeSize;
+
+		for (int y = 0; y < m_height; y++) {
+			const unsigned char* row = pixels + (m_height - 1 - y) * rowSize;
+			size_t out = (size_t)y * m_width;
+
+			for (int x = 0; x < m_width; x++, out++) {
+				int r = row[x * 4 + 0], g = row[x * 4 + 1], b = row[x * 4 + 2];
+				yPlane[out] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+				uPlane[out] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				vPlane[out] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+		}
+
+		if (fwrite("FRAME\n", 1, 6, m_stream) != 6)
+			return false;
+		return fwrite(yuv.data(), 1, yuv.size(), m_stream) == yuv.size();
+	}
+	void FrameCapture::m_closeStream()
+	{
+		if (m_type == OutputType::FFmpeg) {
+#if defined(_WIN32)
+			if (m_stream != nullptr)
+				fclose(m_stream); // EOF - ffmpeg finishes the file
+			if (m_ffmpeg != nullptr) {
+				DWORD ret = 0;
+				WaitForSingleObject((HANDLE)m_ffmpeg, INFINITE);
+				GetExitCodeProcess((HANDLE)m_ffmpeg, &ret);
+				CloseHandle((HANDLE)m_ffmpeg);
+				if (ret != 0)
+					Logger::Get().Log("ffmpeg exited with code " + std::to_string(ret), true);
+			}
+#else
+			if (m_stream != nullptr) {
+				SIGPIPEBlocker sigBlock; // the final flush
+				fclose(m_stream);
+			}
+			if (m_ffmpeg != 0) {
+				int status = 0;
+				while (waitpid(m_ffmpeg, &status, 0) == -1 && errno == EINTR)
+					;
+				if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+					Logger::Get().Log("ffmpeg exited with code " + std::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : -1), true);
+			}
+#endif
+			m_ffmpeg = 0;
+		} else if (m_stream != nullptr)
+			fclose(m_stream);
+
+		m_stream = nullptr;
+	}
+
+	bool FrameCapture::IsVideoFile(const std::string& path)
+	{
+		size_t lastDot = path.find_last_of('.');
+		if (lastDot == std::string::npos)
+			return false;
+
+		std::string ext = path.substr(lastDot + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+		return ext == "mp4" || ext == "mkv" || ext == "webm" || ext == "mov" || ext == "avi" || ext == "y4m" || ext == "raw";
+	}
+	std::string FrameCapture::GetFilenameFormat(const std::string& path, bool forceFrameNumber)
+	{
+		// every frame goes to the same file
+		if (IsVideoFile(path))
+			return path;
+
+		std::string filename = path;
+
+		// allow only one %??d - escape every other %
+		bool hasFormat = false;
+		for (int i = 0; i < filename.size(); i++) {
+			if (filename[i] != '%')
+				continue;
+
+			int end = i + 1;
+			while (end < filename.size() && isdigit(filename[end]))
+				end++;
+
+			if (end < filename.size() && filename[end] == 'd' && !hasFormat)
+				hasFormat = true;
+			else
+				filename.insert(i++, 1, '%');
+		}
+
+		// no %d found? add one
+		if (!hasFormat && forceFrameNumber) {
+			size_t lastDot = filename.find_last_of('.');
+			size_t lastSlash = filename.find_last_of("/\\");
+			if (lastDot == std::string::npos || (lastSlash != std::string::npos && lastDot < lastSlash))
+				lastDot = filename.size();
+			filename.insert(lastDot, "%d"); // frame%d
+		}
+
+		return filename;
+	}
+}
\ No newline at end of file
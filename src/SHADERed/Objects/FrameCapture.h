@@ -0,0 +1,90 @@
+#pragma once
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#if !defined(_WIN32)
+#include <sys/types.h>
+#endif
+
+#define FRAME_CAPTURE_RING_SIZE 3
+
+namespace ed {
+	// writes a sequence of rendered frames to image files or a video stream without stalling the GPU:
+	// frames are read back through a ring of PBOs + fences and encoded on worker threads
+	class FrameCapture {
+	public:
+		FrameCapture();
+		~FrameCapture();
+
+		// renderWidth & renderHeight - texture size, width & height - output size (supersampled frames get resized on the workers)
+		bool Start(const std::string& filenameFormat, int renderWidth, int renderHeight, int width, int height, float fps = 60.0f);
+		void Capture(GLuint tex, int frame);
+		void Finish();
+
+		inline int GetWrittenFrameCount() { return m_written; }
+
+		// .mp4, .mkv, .webm, .mov, .avi (piped to ffmpeg), .y4m & .raw - all frames go to a single file
+		static bool IsVideoFile(const std::string& path);
+
+		// makes sure that the path has exactly one %d (%0Nd) and that every other % is escaped
+		static std::string GetFilenameFormat(const std::string& path, bool forceFrameNumber = true);
+
+	private:
+		enum class OutputType {
+			Images,
+			FFmpeg,
+			Y4M,
+			Raw
+		};
+		struct Frame {
+			int Index;
+			unsigned char* Pixels;
+		};
+
+		void m_readback(int slot);
+		void m_encode();
+
+		bool m_openStream(float fps);
+		bool m_writeStream(const unsigned char* pixels, std::vector<unsigned char>& yuv);
+		void m_closeStream();
+
+		std::string m_filename, m_ext;
+		OutputType m_type;
+		FILE* m_stream;
+#if defined(_WIN32)
+		void* m_ffmpeg; // process handle
+#else
+		pid_t m_ffmpeg;
+#endif
+		int m_rWidth, m_rHeight, m_width, m_height;
+		bool m_started;
+
+		GLuint m_pbo[FRAME_CAPTURE_RING_SIZE];
+		GLsync m_fence[FRAME_CAPTURE_RING_SIZE];
+		int m_pboFrame[FRAME_CAPTURE_RING_SIZE];
+		int m_curSlot;
+
+		// bounded producer/consumer queue - the producer blocks when all buffers are in use
+		std::vector<std::thread> m_workers;
+		std::vector<unsigned char*> m_buffers;
+		std::vector<unsigned char*> m_freeBuffers;
+		std::queue<Frame> m_queue;
+		std::mutex m_mutex;
+		std::condition_variable m_hasWork, m_hasFreeBuffer;
+		bool m_done;
+		int m_written;
+	};
+}
\ No newline at end of file
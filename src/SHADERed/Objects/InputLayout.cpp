@@ -25,4 +25,29 @@ namespace ed {
 		}
 		return 0;
 	}
+	unsigned int InputLayoutItem::GetValueMask(const std::vector<InputLayoutItem>& layout)
+	{
+		unsigned int ret = 0;
+		for (const auto& item : layout)
+			ret |= 1u << (int)item.Value;
+		return ret;
+	}
+	size_t InputLayoutItem::GetPackedSize(InputLayoutValue val, bool packed)
+	{
+		if (!packed || val == InputLayoutValue::Position)
+			return GetValueSize(val) * sizeof(float);
+		return 4;
+	}
+	size_t InputLayoutItem::GetPackedOffset(InputLayoutValue val, unsigned int mask, bool packed)
+	{
+		size_t ret = 0;
+		for (int i = 0; i < (int)val; i++)
+			if (mask & (1u << i))
+				ret += GetPackedSize((InputLayoutValue)i, packed);
+		return ret;
+	}
+	size_t InputLayoutItem::GetPackedStride(unsigned int mask, bool packed)
+	{
+		return GetPackedOffset(InputLayoutValue::MaxCount, mask, packed);
+	}
 }
\ No newline at end of file
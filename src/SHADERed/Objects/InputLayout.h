@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 
 namespace ed {
 	enum class InputLayoutValue {
@@ -19,5 +20,12 @@ namespace ed {
 
 		static size_t GetValueSize(InputLayoutValue val);
 		static size_t GetValueOffset(InputLayoutValue val);
+
+		// compact vertex buffers (3D models) only store the attributes in the mask (1 << InputLayoutValue), in InputLayoutValue order
+		// packed: normals, tangents & binormals are snorm 10_10_10_2, texcoords are half floats and colors are unorm8 - sizes are in bytes
+		static unsigned int GetValueMask(const std::vector<InputLayoutItem>& layout);
+		static size_t GetPackedSize(InputLayoutValue val, bool packed);
+		static size_t GetPackedOffset(InputLayoutValue val, unsigned int mask, bool packed);
+		static size_t GetPackedStride(unsigned int mask, bool packed);
 	};
 }
\ No newline at end of file
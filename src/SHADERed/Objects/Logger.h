@@ -1,5 +1,6 @@
 #pragma once
 #include <SHADERed/Objects/MessageStack.h>
+#include <mutex>
 #include <string>
 
 namespace ed {
@@ -22,6 +23,7 @@ namespace ed {
 		void Save();
 
 	private:
+		std::mutex m_mutex; // shaders are compiled on multiple threads
 		std::vector<std::string> m_msgs;
 	};
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <SHADERed/Engine/GLUtils.h>
+#include <SHADERed/Objects/AssetLoader.h>
 #include <SHADERed/Objects/Logger.h>
 #include <SHADERed/Objects/ObjectManager.h>
 #include <SHADERed/Objects/RenderEngine.h>
@@ -8,67 +9,180 @@
 #include <SFML/Audio/Sound.hpp>
 #include <SFML/Audio/SoundBuffer.hpp>
 
+#include <algorithm>
 #include <unordered_map>
 #include <fstream>
+#include <memory>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
 
+#define BUFFER_STAGING_CHUNK (4 * 1024 * 1024)
+#define BUFFER_STAGING_COUNT 3 // chunks that can be in flight
+
 namespace ed {
+	// read-only view of the whole file, nullptr if it can't be mapped (or is empty)
+	static void* mapFile(const std::string& path, size_t& size)
+	{
+		size = 0;
+
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return nullptr;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		// the view keeps the mapping alive
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+
+		if (view == nullptr)
+			return nullptr;
+		size = fileSize.QuadPart;
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return nullptr;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0) {
+			close(fd);
+			return nullptr;
+		}
+
+		void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		if (view == MAP_FAILED)
+			return nullptr;
+		madvise(view, st.st_size, MADV_SEQUENTIAL);
+		size = st.st_size;
+#endif
+
+		return view;
+	}
+	static void unmapFile(void* view, size_t size)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(view);
+#else
+		munmap(view, size);
+#endif
+	}
+
+	void BufferObject::Resize(int size)
+	{
+		size = std::max(size, 0);
+		int oldSize = Size;
+
+		Data = realloc(Data, size);
+
+		if (size > oldSize)
+			memset((char*)Data + oldSize, 0, size - oldSize);
+
+		Size = size;
+	}
+	void BufferObject::Release()
+	{
+		free(Data);
+
+		Data = nullptr;
+		Size = 0;
+	}
+
 	ObjectManager::ObjectManager(ProjectParser* parser, RenderEngine* rnd)
 			: m_parser(parser)
 			, m_renderer(rnd)
 	{
 		m_binds.clear();
 		memset(m_kbTexture, 0, sizeof(unsigned char) * 256 * 3);
+		m_lastTexGeneration = 0;
 	}
 	ObjectManager::~ObjectManager()
 	{
 		Clear();
 	}
 
-	void loadCubemapFace(GLuint face, const std::string& path, int& w, int& h)
+	// stbi_load(..., STBI_rgb_alpha) that ignores stbi_set_flip_vertically_on_load() - the flag is a
+	// global in this version of stb_image so it can't be relied on from the asset loader's threads
+	unsigned char* loadImageRGBA(const std::string& path, int& w, int& h)
 	{
-		stbi_set_flip_vertically_on_load(0);
+		FILE* f = stbi__fopen(path.c_str(), "rb");
+		if (f == nullptr)
+			return nullptr;
+
+		stbi__context ctx;
+		stbi__start_file(&ctx, f);
 
 		int nrChannels = 0;
-		unsigned char* data = stbi_load(path.c_str(), &w, &h, &nrChannels, 0);
-		unsigned char* paddedData = nullptr;
-
-		if (nrChannels != 4) {
-			paddedData = (unsigned char*)malloc(w * h * 4);
-			for (int x = 0; x < w; x++) {
-				for (int y = 0; y < h; y++) {
-					if (nrChannels == 3) {
-						paddedData[(y * w + x) * 4 + 0] = data[(y * w + x) * 3 + 0];
-						paddedData[(y * w + x) * 4 + 1] = data[(y * w + x) * 3 + 1];
-						paddedData[(y * w + x) * 4 + 2] = data[(y * w + x) * 3 + 2];
-					} else if (nrChannels == 1) {
-						unsigned char val = data[(y * w + x) * 1 + 0];
-						paddedData[(y * w + x) * 4 + 0] = val;
-						paddedData[(y * w + x) * 4 + 1] = val;
-						paddedData[(y * w + x) * 4 + 2] = val;
-					}
-					paddedData[(y * w + x) * 4 + 3] = 255;
-				}
-			}
-		}
+		stbi__result_info ri;
+		void* data = stbi__load_main(&ctx, &w, &h, &nrChannels, STBI_rgb_alpha, &ri, 8);
+		if (data != nullptr && ri.bits_per_channel != 8)
+			data = stbi__convert_16_to_8((stbi__uint16*)data, w, h, STBI_rgb_alpha);
 
-		glTexImage2D(
-			face,
-			0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, paddedData == nullptr ? data : paddedData);
+		fclose(f);
 
-		if (paddedData != nullptr)
-			free(paddedData);
-		stbi_image_free(data);
+		return (unsigned char*)data;
 	}
+	unsigned char* flipImageRGBA(const unsigned char* data, int w, int h)
+	{
+		unsigned char* flippedData = (unsigned char*)malloc(w * h * 4);
+		for (int y = 0; y < h; y++)
+			memcpy(flippedData + y * w * 4, data + (h - y - 1) * w * 4, w * 4);
+		return flippedData;
+	}
+
+	// pixels decoded on a worker thread, waiting for the upload
+	struct LoadedImage {
+		LoadedImage()
+		{
+			memset(Width, 0, sizeof(Width));
+			memset(Height, 0, sizeof(Height));
+			memset(Pixels, 0, sizeof(Pixels));
+			Flipped = nullptr;
+		}
+		~LoadedImage()
+		{
+			for (int i = 0; i < 6; i++)
+				if (Pixels[i] != nullptr)
+					stbi_image_free(Pixels[i]);
+			if (Flipped != nullptr)
+				free(Flipped);
+		}
+
+		int Width[6], Height[6];
+		unsigned char* Pixels[6]; // one for textures, six for cubemaps
+		unsigned char* Flipped;
+	};
+
+	// bound while the actual texture is still being decoded
+	const unsigned char PlaceholderPixel[4] = { 128, 128, 128, 255 };
 
 	void ObjectManager::Clear()
 	{
 		Logger::Get().Log("Clearing ObjectManager contents...");
 
 		for (int i = 0; i < m_itemData.size(); i++) {
+			if (m_itemData[i]->IsTexture || m_itemData[i]->IsCube)
+				AssetLoader::Instance().Cancel(m_itemData[i]);
+
 			if (m_itemData[i]->Plugin != nullptr) {
 				PluginObject* pobj = m_itemData[i]->Plugin;
 				pobj->Owner->Object_Remove(m_items[i].c_str(), pobj->Type, pobj->Data, pobj->ID);
@@ -77,6 +191,7 @@ namespace ed {
 			delete m_itemData[i];
 		}
 
+		m_texGeneration.clear();
 		m_binds.clear();
 		m_uniformBinds.clear();
 		m_items.clear();
@@ -110,29 +225,23 @@ namespace ed {
 		// color texture
 		glGenTextures(1, &item->Texture);
 		glBindTexture(GL_TEXTURE_2D, item->Texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, rtObj->Format, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glBindTexture(GL_TEXTURE_2D, 0);
 
 		// depth texture
 		glGenTextures(1, &rtObj->DepthStencilBuffer);
 		glBindTexture(GL_TEXTURE_2D, rtObj->DepthStencilBuffer);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, size.x, size.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		// color texture ms
+		// multisampled copies
 		glGenTextures(1, &rtObj->BufferMS);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, rtObj->BufferMS);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, rtObj->Format, size.x, size.y, true);
-
-		// depth texture ms
 		glGenTextures(1, &rtObj->DepthStencilBufferMS);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, rtObj->DepthStencilBufferMS);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, GL_DEPTH24_STENCIL8, size.x, size.y, true);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+
+		m_allocateRenderTexture(item->Texture, rtObj, size);
+
+		BumpTextureGeneration(item->Texture);
 
 		return true;
 	}
@@ -145,13 +254,10 @@ namespace ed {
 			return false;
 		}
 
-		stbi_set_flip_vertically_on_load(1);
-
+		// only the header is read here - the pixels are decoded on the asset loader's threads
 		std::string path = m_parser->GetProjectPath(file);
 		int width, height, nrChannels;
-		unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, STBI_rgb_alpha);
-		
-		if (data == nullptr) {
+		if (!stbi_info(path.c_str(), &width, &height, &nrChannels)) {
 			Logger::Get().Log("Failed to load a texture " + file + " from file", true);
 			return false;
 		}
@@ -163,6 +269,7 @@ namespace ed {
 		m_items.push_back(file);
 
 		item->IsTexture = true;
+		item->ImageSize = glm::ivec2(width, height);
 
 		// normal texture
 		glGenTextures(1, &item->Texture);
@@ -171,36 +278,61 @@ namespace ed {
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, item->Texture_MagFilter);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, item->Texture_WrapS);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, item->Texture_WrapT);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PlaceholderPixel);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
 		// flipped texture
-		unsigned char* flippedData = (unsigned char*)malloc(width * height * 4);
-
-		for (int x = 0; x < width; x++) {
-			for (int y = 0; y < height; y++) {
-				flippedData[(y * width + x) * 4 + 0] = data[((height - y - 1) * width + x) * 4 + 0];
-				flippedData[(y * width + x) * 4 + 1] = data[((height - y - 1) * width + x) * 4 + 1];
-				flippedData[(y * width + x) * 4 + 2] = data[((height - y - 1) * width + x) * 4 + 2];
-				flippedData[(y * width + x) * 4 + 3] = data[((height - y - 1) * width + x) * 4 + 3];
-			}
-		}
-
 		glGenTextures(1, &item->FlippedTexture);
 		glBindTexture(GL_TEXTURE_2D, item->FlippedTexture);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, item->Texture_MinFilter);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, item->Texture_MagFilter);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, item->Texture_WrapS);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, item->Texture_WrapT);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, flippedData);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PlaceholderPixel);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		item->ImageSize = glm::ivec2(width, height);
+		BumpTextureGeneration(item->Texture);
+		BumpTextureGeneration(item->FlippedTexture);
+
+		// the texture names stay the same so the binds made in the meantime remain valid
+		std::shared_ptr<LoadedImage> img = std::make_shared<LoadedImage>();
+		AssetLoader::Instance().Add(
+			item,
+			[img, path]() {
+				img->Pixels[0] = loadImageRGBA(path, img->Width[0], img->Height[0]);
+				if (img->Pixels[0] == nullptr)
+					return false;
 
-		free(flippedData);
-		stbi_image_free(data);
+				img->Flipped = flipImageRGBA(img->Pixels[0], img->Width[0], img->Height[0]);
+				return true;
+			},
+			[this, item, img, file](bool loaded) {
+				if (!loaded) {
+					Logger::Get().Log("Failed to decode a texture " + file, true);
+					return;
+				}
+
+				int width = img->Width[0], height = img->Height[0];
+
+				// Texture has the first row at the bottom (as if stbi_set_flip_vertically_on_load(1) was used),
+				// unless FlipTexture() swapped the two while this was still loading
+				unsigned char* texData = item->Texture_VFlipped ? img->Pixels[0] : img->Flipped;
+				unsigned char* flippedTexData = item->Texture_VFlipped ? img->Flipped : img->Pixels[0];
+
+				glBindTexture(GL_TEXTURE_2D, item->Texture);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texData);
+				glGenerateMipmap(GL_TEXTURE_2D);
+
+				glBindTexture(GL_TEXTURE_2D, item->FlippedTexture);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, flippedTexData);
+				glGenerateMipmap(GL_TEXTURE_2D);
+				glBindTexture(GL_TEXTURE_2D, 0);
+
+				BumpTextureGeneration(item->Texture);
+				BumpTextureGeneration(item->FlippedTexture);
+
+				item->ImageSize = glm::ivec2(width, height);
+			});
 
 		return true;
 	}
@@ -220,10 +352,10 @@ namespace ed {
 		m_items.push_back(name);
 
 		item->IsCube = true;
+		item->CubemapPaths = { left, top, front, bottom, right, back };
 
 		glGenTextures(1, &item->Texture);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, item->Texture);
-		int width, height;
 
 		// properties
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -232,33 +364,58 @@ namespace ed {
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-		// left face
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, m_parser->GetProjectPath(left), width, height);
-		item->CubemapPaths.push_back(left);
+		// same order as CubemapPaths
+		static const GLenum faces[6] = {
+			GL_TEXTURE_CUBE_MAP_NEGATIVE_X, // left
+			GL_TEXTURE_CUBE_MAP_POSITIVE_Y, // top
+			GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, // front
+			GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, // bottom
+			GL_TEXTURE_CUBE_MAP_POSITIVE_X, // right
+			GL_TEXTURE_CUBE_MAP_POSITIVE_Z	// back
+		};
 
-		// top
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, m_parser->GetProjectPath(top), width, height);
-		item->CubemapPaths.push_back(top);
+		std::vector<std::string> paths(6);
+		for (int i = 0; i < 6; i++) {
+			paths[i] = m_parser->GetProjectPath(item->CubemapPaths[i]);
+			glTexImage2D(faces[i], 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PlaceholderPixel);
+		}
 
-		// front
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, m_parser->GetProjectPath(front), width, height);
-		item->CubemapPaths.push_back(front);
+		// clean up
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
-		// bottom
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, m_parser->GetProjectPath(bottom), width, height);
-		item->CubemapPaths.push_back(bottom);
+		BumpTextureGeneration(item->Texture);
 
-		// right
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_POSITIVE_X, m_parser->GetProjectPath(right), width, height);
-		item->CubemapPaths.push_back(right);
+		int width = 0, height = 0, nrChannels = 0;
+		stbi_info(paths[5].c_str(), &width, &height, &nrChannels);
+		item->ImageSize = glm::ivec2(width, height);
 
-		// back
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, m_parser->GetProjectPath(back), width, height);
-		item->CubemapPaths.push_back(back);
+		std::shared_ptr<LoadedImage> img = std::make_shared<LoadedImage>();
+		AssetLoader::Instance().Add(
+			item,
+			[img, paths]() {
+				bool loaded = true;
+				for (int i = 0; i < 6; i++) {
+					img->Pixels[i] = loadImageRGBA(paths[i], img->Width[i], img->Height[i]);
+					loaded &= img->Pixels[i] != nullptr;
+				}
+				return loaded;
+			},
+			[this, item, img, name](bool loaded) {
+				if (!loaded)
+					Logger::Get().Log("Failed to decode some of the faces of the cubemap " + name, true);
+
+				glBindTexture(GL_TEXTURE_CUBE_MAP, item->Texture);
+				for (int i = 0; i < 6; i++) {
+					if (img->Pixels[i] == nullptr)
+						continue;
+
+					glTexImage2D(faces[i], 0, GL_RGBA, img->Width[i], img->Height[i], 0, GL_RGBA, GL_UNSIGNED_BYTE, img->Pixels[i]);
+					item->ImageSize = glm::ivec2(img->Width[i], img->Height[i]);
+				}
+				glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
-		// clean up
-		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-		item->ImageSize = glm::ivec2(width, height);
+				BumpTextureGeneration(item->Texture);
+			});
 
 		return true;
 	}
@@ -294,6 +451,8 @@ namespace ed {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, 512, 2, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
+		BumpTextureGeneration(item->Texture);
+
 		item->Sound = new sf::Sound();
 		item->Sound->setBuffer(*(item->SoundBuffer));
 		item->Sound->setLoop(true);
@@ -356,6 +515,8 @@ namespace ed {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
+		BumpTextureGeneration(iObj->Texture);
+
 		memset(iObj->DataPath, 0, sizeof(char) * SHADERED_MAX_PATH);
 		iObj->Size = size;
 		iObj->Format = GL_RGBA32F;
@@ -388,6 +549,8 @@ namespace ed {
 		glTexImage3D(GL_TEXTURE_3D, 0, iObj->Format, size.x, size.y, size.z, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_3D, 0);
 
+		BumpTextureGeneration(iObj->Texture);
+
 		return true;
 	}
 	bool ObjectManager::CreatePluginItem(const std::string& name, const std::string& objtype, void* data, GLuint id, IPlugin1* owner)
@@ -445,6 +608,8 @@ namespace ed {
 		glGenerateMipmap(GL_TEXTURE_2D);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
+		BumpTextureGeneration(item->Texture);
+
 		item->ImageSize = glm::ivec2(width, height);
 
 		return true;
@@ -522,6 +687,8 @@ namespace ed {
 		if (data != nullptr) {
 			m_parser->ModifyProject();
 
+			buf->Release();
+
 			if (convertToFloat) {
 				buf->Size = width * height * nrChannels * sizeof(float);
 				buf->Data = realloc(buf->Data, buf->Size);
@@ -547,70 +714,259 @@ namespace ed {
 			glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
 			glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // upload data
 			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			buf->Generation++;
 		}
 
 		return data != nullptr;
 	}
 	bool ObjectManager::LoadBufferFromModel(BufferObject* buf, const std::string& str)
 	{
-		ed::eng::Model mdl;
-		bool ret = mdl.LoadFromFile(str);
+		return LoadBufferFromModel(buf, str, { ShaderVariable::ValueType::Float4 });
+	}
+	bool ObjectManager::LoadBufferFromModel(BufferObject* buf, const std::string& str, const std::vector<ShaderVariable::ValueType>& fmt)
+	{
+		Logger::Get().Log("Loading a 3D model " + str + " into a buffer");
 
-		if (ret) {
-			int vertCount = 0;
-			for (auto mesh : mdl.Meshes)
-				vertCount += mesh.Vertices.size();
-			int bufSize = vertCount * 4 * sizeof(float);
+		// the vertices are written straight from assimp's arrays - no eng::Model (and no VAOs) is created
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(str, aiProcess_Triangulate | aiProcess_FlipUVs);
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+			Logger::Get().Log("Assimp has detected an error \"" + std::string(importer.GetErrorString()) + "\"", true);
+			return false;
+		}
 
-			buf->Size = bufSize;
-			buf->Data = realloc(buf->Data, bufSize);
-
-			int index = 0;
-			float* fData = (float*)buf->Data;
-			for (auto mesh : mdl.Meshes)
-				for (auto vert : mesh.Vertices) {
-					fData[index + 0] = vert.Position.x;
-					fData[index + 1] = vert.Position.y;
-					fData[index + 2] = vert.Position.z;
-					fData[index + 3] = 1.0f;
-					index += 4;
+		// same order as eng::Model::Meshes
+		std::vector<const aiMesh*> meshes;
+		std::vector<const aiNode*> nodes = { scene->mRootNode };
+		while (!nodes.empty()) {
+			const aiNode* node = nodes.back();
+			nodes.pop_back();
+
+			for (unsigned int i = 0; i < node->mNumMeshes; i++)
+				meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+			for (unsigned int i = node->mNumChildren; i > 0; i--)
+				nodes.push_back(node->mChildren[i - 1]);
+		}
+
+		size_t vertCount = 0;
+		for (const aiMesh* mesh : meshes)
+			vertCount += mesh->mNumVertices;
+
+		int stride = 0;
+		for (const auto& type : fmt)
+			stride += ShaderVariable::GetSize(type, true);
+
+		m_parser->ModifyProject();
+
+		buf->Release();
+		buf->Size = vertCount * stride;
+		buf->Data = calloc(1, buf->Size);
+
+		// vec4 positions (the buffer preview's "load model") - one contiguous 16 byte write per vertex
+		if (fmt.size() == 1 && fmt[0] == ShaderVariable::ValueType::Float4) {
+			glm::vec4* out = (glm::vec4*)buf->Data;
+			for (const aiMesh* mesh : meshes) {
+				const aiVector3D* pos = mesh->mVertices;
+				if (mesh->HasPositions())
+					for (unsigned int v = 0; v < mesh->mNumVertices; v++)
+						out[v] = glm::vec4(pos[v].x, pos[v].y, pos[v].z, 1.0f);
+				else
+					std::fill(out, out + mesh->mNumVertices, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+				out += mesh->mNumVertices;
+			}
+
+			m_uploadBuffer(buf->ID, buf->Data, buf->Size);
+			buf->Generation++;
+
+			return true;
+		}
+
+		// one column (attribute) at a time - each loop is a strided scalar copy
+		int offset = 0;
+		for (int attr = 0; attr < fmt.size(); attr++) {
+			ShaderVariable::ValueType type = fmt[attr];
+			bool isFloat = type >= ShaderVariable::ValueType::Float1 && type <= ShaderVariable::ValueType::Float4;
+			bool isInt = type >= ShaderVariable::ValueType::Integer1 && type <= ShaderVariable::ValueType::Integer4;
+			int comps = ShaderVariable::GetSize(type, true) / 4;
+
+			// booleans & matrices and entries past the color stay zero
+			if (attr <= 5 && (isFloat || isInt)) {
+				char* dst = (char*)buf->Data + offset;
+				for (const aiMesh* mesh : meshes) {
+					// source array & the number of floats per element in it
+					const float* src = nullptr;
+					int srcComps = 3;
+					if (attr == 0)
+						src = mesh->HasPositions() ? &mesh->mVertices[0].x : nullptr;
+					else if (attr == 1)
+						src = mesh->HasNormals() ? &mesh->mNormals[0].x : nullptr;
+					else if (attr == 2)
+						src = mesh->HasTextureCoords(0) ? &mesh->mTextureCoords[0][0].x : nullptr; // aiVector3D, z is ignored
+					else if (attr == 3)
+						src = mesh->HasTangentsAndBitangents() ? &mesh->mTangents[0].x : nullptr;
+					else if (attr == 4)
+						src = mesh->HasTangentsAndBitangents() ? &mesh->mBitangents[0].x : nullptr;
+					else if (attr == 5) {
+						src = mesh->HasVertexColors(0) ? &mesh->mColors[0][0].r : nullptr;
+						srcComps = 4;
+					}
+
+					int attrComps = std::min(comps, attr == 2 ? 2 : srcComps);
+					unsigned int count = mesh->mNumVertices;
+
+					// missing attributes - position.w and a missing color are 1, like in eng::Model
+					float fill[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+					if (attr == 0 && comps == 4)
+						fill[3] = 1.0f;
+					if (attr == 5 && src == nullptr)
+						fill[0] = fill[1] = fill[2] = fill[3] = 1.0f;
+
+					for (int c = 0; c < comps; c++) {
+						bool fromSrc = src != nullptr && c < attrComps;
+						char* col = dst + c * 4;
+
+						if (isFloat) {
+							if (fromSrc)
+								for (unsigned int v = 0; v < count; v++)
+									memcpy(col + v * stride, &src[v * srcComps + c], sizeof(float));
+							else if (fill[c] != 0.0f)
+								for (unsigned int v = 0; v < count; v++)
+									memcpy(col + v * stride, &fill[c], sizeof(float));
+						} else {
+							int iFill = (int)fill[c];
+							if (fromSrc)
+								for (unsigned int v = 0; v < count; v++) {
+									int val = (int)src[v * srcComps + c];
+									memcpy(col + v * stride, &val, sizeof(int));
+								}
+							else if (iFill != 0)
+								for (unsigned int v = 0; v < count; v++)
+									memcpy(col + v * stride, &iFill, sizeof(int));
+						}
+					}
+
+					dst += (size_t)count * stride;
 				}
+			}
 
-			glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
-			glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // upload data
-			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			offset += ShaderVariable::GetSize(type, true);
 		}
 
-		return ret;
+		m_uploadBuffer(buf->ID, buf->Data, buf->Size);
+		buf->Generation++;
+
+		return true;
 	}
 	bool ObjectManager::LoadBufferFromFile(BufferObject* buf, const std::string& str)
 	{
 		std::string bPath = m_parser->GetProjectPath(str);
+
+		// the mapping only lives while the file is being uploaded - each chunk is copied to the GPU & to Data straight from the
+		// page cache, Data never points to the file (it's written to by the preview and another process can change the file)
+		size_t bufSize = 0;
+		void* view = mapFile(bPath, bufSize);
+		if (view != nullptr) {
+			buf->Release();
+			buf->Size = bufSize;
+			buf->Data = malloc(bufSize);
+
+			m_uploadBuffer(buf->ID, view, buf->Size, buf->Data);
+			unmapFile(view, bufSize);
+			buf->Generation++;
+
+			return true;
+		}
+
+		// couldn't be mapped - read it straight into Data
 		std::ifstream bufRead(bPath, std::ios::binary | std::ios::ate);
-		size_t bufSize = bufRead.tellg();
+		if (!bufRead.is_open())
+			return false;
+
+		bufSize = bufRead.tellg();
 		bufRead.seekg(0, std::ios::beg);
 
-		bool ret = bufRead.is_open();
-		if (ret) {
-			buf->Size = bufSize;
-			buf->Data = realloc(buf->Data, bufSize);
-			char* data = (char*)calloc(1, bufSize);
-			bufRead.read(data, bufSize);
-			memcpy(buf->Data, data, bufSize);
-			free(data);
+		buf->Release();
+		buf->Size = bufSize;
+		buf->Data = malloc(bufSize);
+		bufRead.read((char*)buf->Data, bufSize);
+		bufRead.close();
 
-			glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
-			glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // upload data
+		m_uploadBuffer(buf->ID, buf->Data, buf->Size);
+		buf->Generation++;
+
+		return true;
+	}
+	void ObjectManager::m_uploadBuffer(GLuint buffer, const void* data, size_t size, void* copy)
+	{
+		if (size <= BUFFER_STAGING_CHUNK || !GLEW_ARB_buffer_storage) {
+			if (copy != nullptr) {
+				memcpy(copy, data, size);
+				data = copy;
+			}
+
+			glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+			glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STATIC_DRAW); // upload data
 			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			return;
 		}
 
-		bufRead.close();
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STATIC_DRAW);
 
-		return ret;
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLuint staging = 0;
+		glGenBuffers(1, &staging);
+		glBindBuffer(GL_COPY_READ_BUFFER, staging);
+		glBufferStorage(GL_COPY_READ_BUFFER, BUFFER_STAGING_CHUNK * BUFFER_STAGING_COUNT, nullptr, flags);
+		char* staged = (char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, BUFFER_STAGING_CHUNK * BUFFER_STAGING_COUNT, flags);
+
+		if (staged == nullptr) {
+			if (copy != nullptr) {
+				memcpy(copy, data, size);
+				data = copy;
+			}
+			glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, data);
+		} else {
+			// the memcpy() is where the file actually gets read - the GPU copies the previous chunks meanwhile
+			GLsync fences[BUFFER_STAGING_COUNT] = { nullptr };
+			for (size_t offset = 0, chunk = 0; offset < size; offset += BUFFER_STAGING_CHUNK, chunk++) {
+				int slot = chunk % BUFFER_STAGING_COUNT;
+				if (fences[slot] != nullptr) {
+					GLenum waitRes = glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+					while (waitRes == GL_TIMEOUT_EXPIRED)
+						waitRes = glClientWaitSync(fences[slot], 0, 1000000); // 1ms
+					glDeleteSync(fences[slot]);
+				}
+
+				size_t len = std::min<size_t>(BUFFER_STAGING_CHUNK, size - offset);
+				memcpy(staged + slot * BUFFER_STAGING_CHUNK, (const char*)data + offset, len);
+				if (copy != nullptr)
+					memcpy((char*)copy + offset, (const char*)data + offset, len); // the staging memory is write-only, the source chunk is still in the cache
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, slot * BUFFER_STAGING_CHUNK, offset, len);
+				fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+
+			// the staging buffer can't be deleted while it's being read
+			for (int i = 0; i < BUFFER_STAGING_COUNT; i++)
+				if (fences[i] != nullptr) {
+					GLenum waitRes = glClientWaitSync(fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+					while (waitRes == GL_TIMEOUT_EXPIRED)
+						waitRes = glClientWaitSync(fences[i], 0, 1000000); // 1ms
+					glDeleteSync(fences[i]);
+				}
+
+			glUnmapBuffer(GL_COPY_READ_BUFFER);
+		}
+
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glDeleteBuffers(1, &staging);
 	}
 
 	bool ObjectManager::ReloadTexture(ObjectManagerItem* item, const std::string& newPath)
 	{
+		AssetLoader::Instance().Cancel(item);
+
 		stbi_set_flip_vertically_on_load(1);
 
 		for (int i = 0; i < m_itemData.size(); i++) {
@@ -652,6 +1008,9 @@ namespace ed {
 
 				item->ImageSize = glm::ivec2(width, height);
 
+				BumpTextureGeneration(item->Texture);
+				BumpTextureGeneration(item->FlippedTexture);
+
 				free(flippedData);
 				stbi_image_free(data);
 				
@@ -884,6 +1243,8 @@ namespace ed {
 				glBindTexture(GL_TEXTURE_2D, it->Texture);
 				glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, 512, 2, 0, GL_RED, GL_FLOAT, m_audioTempTexData);
 				glBindTexture(GL_TEXTURE_2D, 0);
+
+				BumpTextureGeneration(it->Texture);
 			}
 			// update kb texture
 			else if (it->IsKeyboardTexture) {
@@ -891,6 +1252,8 @@ namespace ed {
 				glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, 256, 3, 0, GL_RED, GL_UNSIGNED_BYTE, m_kbTexture);
 				glBindTexture(GL_TEXTURE_2D, 0);
 				memset(&m_kbTexture[256], 0, sizeof(unsigned char) * 256);
+
+				BumpTextureGeneration(it->Texture);
 			}
 		}
 	}
@@ -930,6 +1293,11 @@ namespace ed {
 			pobj->Owner->Object_Remove(file.c_str(), pobj->Type, pobj->Data, pobj->ID);
 		}
 
+		if (m_itemData[index]->IsTexture || m_itemData[index]->IsCube)
+			AssetLoader::Instance().Cancel(m_itemData[index]);
+
+		m_forgetTextures(m_itemData[index]);
+
 		delete m_itemData[index];
 		m_itemData.erase(m_itemData.begin() + index);
 		m_items.erase(m_items.begin() + index);
@@ -1194,6 +1562,8 @@ namespace ed {
 
 			free(pixels);
 		}
+
+		BumpTextureGeneration(img->Texture);
 	}
 	void ObjectManager::SaveToFile(const std::string& itemName, ObjectManagerItem* item, const std::string& filepath)
 	{
@@ -1354,6 +1724,13 @@ namespace ed {
 				return m_items[i];
 		return "";
 	}
+	BufferObject* ObjectManager::GetBufferByID(GLuint id)
+	{
+		for (int i = 0; i < m_itemData.size(); i++)
+			if (m_itemData[i]->Buffer != nullptr && m_itemData[i]->Buffer->ID == id)
+				return m_itemData[i]->Buffer;
+		return nullptr;
+	}
 	std::string ObjectManager::GetImageNameByID(GLuint id)
 	{
 		for (int i = 0; i < m_itemData.size(); i++)
@@ -1446,22 +1823,80 @@ namespace ed {
 	{
 		RenderTextureObject* rtObj = GetRenderTexture(name);
 
-		if (rtObj->RatioSize.x == -1 && rtObj->RatioSize.y == -1)
+		if (rtObj->RatioSize.x == -1 && rtObj->RatioSize.y == -1 && rtObj->StorageSize != size)
 			m_parser->ModifyProject();
 
-		glBindTexture(GL_TEXTURE_2D, GetTexture(name));
-		glTexImage2D(GL_TEXTURE_2D, 0, rtObj->Format, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		// the FBOs keep pointing to the same texture names, only the storage is reallocated - and only if it has to be
+		GLuint tex = GetTexture(name);
+		if (m_allocateRenderTexture(tex, rtObj, size))
+			BumpTextureGeneration(tex);
+	}
+	void ObjectManager::GetRenderTextureMemory(size_t& allocated, size_t& unshared)
+	{
+		allocated = unshared = 0;
+
+		for (ObjectManagerItem* item : m_itemData) {
+			RenderTextureObject* rtObj = item->RT;
+			if (rtObj == nullptr)
+				continue;
+
+			size_t pixels = (size_t)rtObj->StorageSize.x * rtObj->StorageSize.y;
+			size_t colorBytes = rtObj->ColorBits / 8, depthBytes = 4;
+			size_t samples = rtObj->StorageSamples;
+
+			size_t colorPixels = rtObj->StorageColorShared ? 1 : pixels;
+			size_t depthPixels = rtObj->StorageDepthShared ? 1 : pixels;
+
+			// the multisampled copies are 1x1 with MSAA turned off
+			size_t msPixels = samples > 1 ? pixels : 1;
+			size_t msColorPixels = samples > 1 ? colorPixels : 1;
+			size_t msDepthPixels = samples > 1 ? depthPixels : 1;
+
+			unshared += pixels * (colorBytes + depthBytes) + msPixels * samples * (colorBytes + depthBytes);
+			allocated += colorPixels * colorBytes + depthPixels * depthBytes + samples * (msColorPixels * colorBytes + msDepthPixels * depthBytes);
+		}
+	}
+	bool ObjectManager::m_allocateRenderTexture(GLuint tex, RenderTextureObject* rtObj, glm::ivec2 size)
+	{
+		int samples = Settings::Instance().Preview.MSAA;
+		if (rtObj->StorageSize == size && rtObj->StorageFormat == rtObj->Format && rtObj->StorageSamples == samples && rtObj->StorageColorShared == rtObj->ColorShared && rtObj->StorageDepthShared == rtObj->DepthShared)
+			return false;
+
+		rtObj->StorageSize = size;
+		rtObj->StorageFormat = rtObj->Format;
+		rtObj->StorageSamples = samples;
+		rtObj->StorageColorShared = rtObj->ColorShared;
+		rtObj->StorageDepthShared = rtObj->DepthShared;
+
+		// shared textures are never rendered to, neither are the multisampled ones with MSAA turned off
+		glm::ivec2 colorSize = rtObj->ColorShared ? glm::ivec2(1, 1) : size;
+		glm::ivec2 depthSize = rtObj->DepthShared ? glm::ivec2(1, 1) : size;
+		glm::ivec2 colorSizeMS = samples > 1 ? colorSize : glm::ivec2(1, 1);
+		glm::ivec2 depthSizeMS = samples > 1 ? depthSize : glm::ivec2(1, 1);
+
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, rtObj->Format, colorSize.x, colorSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+		// for the memory report
+		GLint bits[4] = { 0 };
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_RED_SIZE, &bits[0]);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_GREEN_SIZE, &bits[1]);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_BLUE_SIZE, &bits[2]);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_ALPHA_SIZE, &bits[3]);
+		rtObj->ColorBits = std::max<int>(8, bits[0] + bits[1] + bits[2] + bits[3]);
 
 		glBindTexture(GL_TEXTURE_2D, rtObj->DepthStencilBuffer);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, size.x, size.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, depthSize.x, depthSize.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, rtObj->BufferMS);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, rtObj->Format, size.x, size.y, true);
+		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, rtObj->Format, colorSizeMS.x, colorSizeMS.y, true);
 
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, rtObj->DepthStencilBufferMS);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, GL_DEPTH24_STENCIL8, size.x, size.y, true);
+		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_DEPTH24_STENCIL8, depthSizeMS.x, depthSizeMS.y, true);
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+
+		return true;
 	}
 	void ObjectManager::ResizeImage(const std::string& name, glm::ivec2 size)
 	{
@@ -1474,6 +1909,8 @@ namespace ed {
 		glBindTexture(GL_TEXTURE_2D, iobj->Texture);
 		glTexImage2D(GL_TEXTURE_2D, 0, iobj->Format, iobj->Size.x, iobj->Size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
+
+		BumpTextureGeneration(iobj->Texture);
 	}
 	void ObjectManager::ResizeImage3D(const std::string& name, glm::ivec3 size)
 	{
@@ -1486,5 +1923,34 @@ namespace ed {
 		glBindTexture(GL_TEXTURE_3D, iobj->Texture);
 		glTexImage3D(GL_TEXTURE_3D, 0, iobj->Format, iobj->Size.x, iobj->Size.y, iobj->Size.z, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_3D, 0);
+
+		BumpTextureGeneration(iobj->Texture);
+	}
+	void ObjectManager::BumpWritableTextureGenerations()
+	{
+		for (ObjectManagerItem* item : m_itemData) {
+			if (item->RT != nullptr)
+				BumpTextureGeneration(item->Texture);
+			else if (item->Image != nullptr)
+				BumpTextureGeneration(item->Image->Texture);
+			else if (item->Image3D != nullptr)
+				BumpTextureGeneration(item->Image3D->Texture);
+		}
+	}
+	void ObjectManager::BumpBufferGenerations()
+	{
+		for (ObjectManagerItem* item : m_itemData)
+			if (item->Buffer != nullptr)
+				item->Buffer->Generation++;
+	}
+	void ObjectManager::m_forgetTextures(ObjectManagerItem* item)
+	{
+		// untracked from now on - lets the debugger drop its copies of these textures
+		m_texGeneration.erase(item->Texture);
+		m_texGeneration.erase(item->FlippedTexture);
+		if (item->Image != nullptr)
+			m_texGeneration.erase(item->Image->Texture);
+		if (item->Image3D != nullptr)
+			m_texGeneration.erase(item->Image3D->Texture);
 	}
 }
\ No newline at end of file
@@ -23,12 +23,30 @@ namespace ed {
 		bool Clear;
 		GLuint Format;
 
+		// RenderEngine renders to another render texture's color/depth textures instead - the own ones are only 1x1
+		bool ColorShared, DepthShared;
+
+		// what the textures are currently allocated with - resizing to the same size, format & sample count is a no-op
+		glm::ivec2 StorageSize;
+		GLuint StorageFormat;
+		int StorageSamples;
+		bool StorageColorShared, StorageDepthShared;
+		int ColorBits; // bits per pixel of the color texture
+
 		RenderTextureObject()
 				: FixedSize(-1, -1)
 				, RatioSize(1, 1)
 				, Clear(true)
 				, ClearColor(0, 0, 0, 1)
 				, Format(GL_RGBA)
+				, ColorShared(false)
+				, DepthShared(false)
+				, StorageSize(0, 0)
+				, StorageFormat(0)
+				, StorageSamples(0)
+				, StorageColorShared(false)
+				, StorageDepthShared(false)
+				, ColorBits(32)
 		{
 		}
 
@@ -50,6 +68,10 @@ namespace ed {
 		char ViewFormat[256]; // vec3;vec3;vec2
 		GLuint ID;
 		bool PreviewPaused;
+		unsigned int Generation; // bumped every time the contents are uploaded or written to by a shader
+
+		void Resize(int size); // keeps the contents & zeroes the rest
+		void Release();
 	};
 
 	struct ImageObject {
@@ -103,7 +125,7 @@ namespace ed {
 		{
 			if (Buffer != nullptr) {
 				glDeleteBuffers(1, &Buffer->ID);
-				free(Buffer->Data);
+				Buffer->Release();
 				delete Buffer;
 			}
 			if (Image != nullptr) {
@@ -198,11 +220,19 @@ namespace ed {
 		void SaveToFile(const std::string& itemName, ObjectManagerItem* item, const std::string& filepath);
 
 		void ResizeRenderTexture(const std::string& name, glm::ivec2 size);
+
+		// bytes that the render textures take up right now & would take up if none of them shared memory
+		void GetRenderTextureMemory(size_t& allocated, size_t& unshared);
 		void ResizeImage(const std::string& name, glm::ivec2 size);
 		void ResizeImage3D(const std::string& name, glm::ivec3 size);
 
 		bool LoadBufferFromTexture(BufferObject* buf, const std::string& str, bool convertToFloat = false);
+		// one vec4 (position, w = 1) per vertex
 		bool LoadBufferFromModel(BufferObject* buf, const std::string& str);
+
+		// one row per vertex in the given format - the entries are filled with position (w = 1), normal, texture
+		// coordinates, tangent, binormal and color, in that order
+		bool LoadBufferFromModel(BufferObject* buf, const std::string& str, const std::vector<ShaderVariable::ValueType>& fmt);
 		bool LoadBufferFromFile(BufferObject* buf, const std::string& str);
 
 		bool ReloadTexture(ObjectManagerItem* item, const std::string& newPath);
@@ -227,6 +257,7 @@ namespace ed {
 
 		PluginObject* GetPluginObject(GLuint id);
 		std::string GetBufferNameByID(int id);
+		BufferObject* GetBufferByID(GLuint id);
 		std::string GetImageNameByID(GLuint id);
 		std::string GetImage3DNameByID(GLuint id);
 
@@ -266,6 +297,20 @@ namespace ed {
 		const std::vector<std::string>& GetCubemapTextures(const std::string& name);
 		inline std::vector<ObjectManagerItem*>& GetItemDataList() { return m_itemData; }
 
+		// content generation of a texture - gets a new value every time the texture is written to (uploads, resizes, render passes, ...)
+		// 0 means that the texture isn't tracked and that its contents must always be read again
+		inline void BumpTextureGeneration(GLuint tex)
+		{
+			if (tex != 0) m_texGeneration[tex] = ++m_lastTexGeneration;
+		}
+		inline unsigned int GetTextureGeneration(GLuint tex)
+		{
+			auto it = m_texGeneration.find(tex);
+			return it == m_texGeneration.end() ? 0 : it->second;
+		}
+		void BumpWritableTextureGenerations(); // render textures & images - for writes to unknown targets (plugins)
+		void BumpBufferGenerations(); // same as above, but for buffers
+
 	private:
 		RenderEngine* m_renderer;
 		ProjectParser* m_parser;
@@ -284,5 +329,16 @@ namespace ed {
 
 		std::unordered_map<PipelineItem*, std::vector<GLuint>> m_binds;
 		std::unordered_map<PipelineItem*, std::vector<GLuint>> m_uniformBinds;
+
+		std::unordered_map<GLuint, unsigned int> m_texGeneration;
+		unsigned int m_lastTexGeneration;
+		void m_forgetTextures(ObjectManagerItem* item);
+
+		// returns false if the storage already matches
+		bool m_allocateRenderTexture(GLuint tex, RenderTextureObject* rtObj, glm::ivec2 size);
+
+		// big buffers go through a persistently mapped staging buffer in chunks instead of one glBufferData() call
+		// copy: optional, receives the data while it's being uploaded
+		void m_uploadBuffer(GLuint buffer, const void* data, size_t size, void* copy = nullptr);
 	};
 }
\ No newline at end of file
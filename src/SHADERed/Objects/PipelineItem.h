@@ -85,10 +85,14 @@ namespace ed {
 			{
 				Macros.clear();
 				memset(Path, 0, sizeof(char) * SHADERED_MAX_PATH);
+				SampleRate = 44100;
+				BlockSize = 1024;
+				Channels = 2;
 			}
 
 			ed::AudioShaderStream Stream;
 			char Path[SHADERED_MAX_PATH];
+			int SampleRate, BlockSize, Channels; // BlockSize = samples rendered per chunk
 			ShaderVariableContainer Variables;
 			std::vector<ShaderMacro> Macros;
 		};
@@ -183,11 +187,18 @@ namespace ed {
 				Topology = GL_TRIANGLES;
 				Buffer = 0;
 				VAO = 0;
+				PickBuffer = nullptr;
+				PickGeneration = 0;
 			}
 
 			void* Buffer;
 			GLuint VAO;
 
+			// built on the first pick, rebuilt when the buffer or its generation changes
+			eng::BVH PickBVH;
+			void* PickBuffer;
+			unsigned int PickGeneration;
+
 			unsigned int Topology;
 			glm::vec3 Position, Rotation, Scale;
 		};
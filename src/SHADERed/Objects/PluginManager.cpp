@@ -296,6 +296,7 @@ namespace ed {
 				};
 				plugin->BindShaderPassVariables = [](void* shaderpass, void* item) {
 					pipe::ShaderPass* data = (pipe::ShaderPass*)shaderpass;
+					data->Variables.BindUniformBlock();
 					data->Variables.Bind(item);
 				};
 				plugin->GetViewMatrix = [](float* out) {
@@ -475,6 +476,7 @@ namespace ed {
 					if (lwr == "checkupdates") return seti.General.CheckUpdates;
 					if (lwr == "recompileonfilechange") return seti.General.RecompileOnFileChange;
 					if (lwr == "autorecompile") return seti.General.AutoRecompile;
+					if (lwr == "cachespirv") return seti.General.CacheSPIRV;
 					if (lwr == "autouniforms") return seti.General.AutoUniforms;
 					if (lwr == "autouniformspin") return seti.General.AutoUniformsPin;
 					if (lwr == "autouniformsfunction") return seti.General.AutoUniformsFunction;
@@ -1024,6 +1026,10 @@ namespace ed {
 	}
 	void PluginManager::Destroy()
 	{
+		// nothing was loaded (headless render) - don't wipe the saved plugin settings
+		if (m_plugins.empty())
+			return;
+
 		std::string settingsFileLoc = "data/plugin_settings.ini";
 		if (!ed::Settings::Instance().LinuxHomeDirectory.empty())
 			settingsFileLoc = ed::Settings::Instance().LinuxHomeDirectory + "data/plugin_settings.ini";
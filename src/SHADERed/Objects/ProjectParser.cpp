@@ -1,3 +1,4 @@
+#include <SHADERed/Objects/AssetLoader.h>
 #include <SHADERed/Objects/CameraSnapshots.h>
 #include <SHADERed/Objects/DebugInformation.h>
 #include <SHADERed/Objects/DefaultState.h>
@@ -12,6 +13,7 @@
 #include <SHADERed/Objects/ProjectParser.h>
 #include <SHADERed/Objects/RenderEngine.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
+#include <SHADERed/Objects/ShaderFileCache.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
 
 #include <SHADERed/Engine/GLUtils.h>
@@ -107,6 +109,12 @@ namespace ed {
 
 				std::string msg = "The project you are trying to open requires plugin \"" + pname + "\".";
 
+				// no window to show the message box on when rendering headless
+				if (m_ui == nullptr) {
+					Logger::Get().Log(msg, true);
+					continue;
+				}
+
 				const SDL_MessageBoxButtonData buttons[] = {
 					{ SDL_MESSAGEBOX_BUTTON_RETURNKEY_DEFAULT, 0, "OK" },
 				};
@@ -133,6 +141,11 @@ namespace ed {
 
 						std::string msg = "The project you are trying to open requires plugin " + pname + " version " + std::to_string(pver) + " while you have version " + std::to_string(instPVer) + " installed.\n";
 
+						if (m_ui == nullptr) {
+							Logger::Get().Log(msg, true);
+							break;
+						}
+
 						const SDL_MessageBoxButtonData buttons[] = {
 							{ /* .flags, .buttonid, .text */ 0, 1, "NO" },
 							{ SDL_MESSAGEBOX_BUTTON_RETURNKEY_DEFAULT, 0, "YES" },
@@ -175,6 +188,7 @@ namespace ed {
 		m_debug->ClearBreakpointList();
 
 		for (auto& mdl : m_models) {
+			AssetLoader::Instance().Cancel(mdl.second);
 			delete mdl.second;
 			mdl.second = nullptr;
 		}
@@ -182,6 +196,7 @@ namespace ed {
 
 		m_pipe->Clear();
 		m_objects->Clear();
+		ShaderFileCache::Instance().Clear();
 
 		Settings::Instance().Project.FPCamera = false;
 		Settings::Instance().Project.ClearColor = glm::vec4(0, 0, 0, 0);
@@ -477,6 +492,12 @@ namespace ed {
 				ssNode.append_attribute("type").set_value("ss");
 				ssNode.append_attribute("path").set_value(relativePath.c_str());
 
+				// sample format
+				pugi::xml_node formatNode = passNode.append_child("format");
+				formatNode.append_attribute("rate").set_value(passData->SampleRate);
+				formatNode.append_attribute("block").set_value(passData->BlockSize);
+				formatNode.append_attribute("channels").set_value(passData->Channels);
+
 				// variables -> now global in pass element [V2]
 				m_exportShaderVariables(passNode, passData->Variables.GetVariables());
 
@@ -914,30 +935,98 @@ namespace ed {
 
 		return string;
 	}
-	eng::Model* ProjectParser::LoadModel(const std::string& file)
+	eng::Model* ProjectParser::LoadModel(const std::string& file, bool async)
 	{
 		// return already loaded model
 		for (auto& mdl : m_models)
-			if (mdl.first == file)
+			if (mdl.first == file) {
+				// caller needs the meshes right now
+				if (!async && !mdl.second->IsUploaded()) {
+					AssetLoader::Instance().Flush();
+					if (!mdl.second->IsUploaded())
+						return nullptr; // the background import failed
+				}
 				return mdl.second;
+			}
 
-		m_models.push_back(std::make_pair(file, new eng::Model()));
+		std::string path = GetProjectPath(file);
+		eng::Model* mdl = new eng::Model();
+		bool optimize = Settings::Instance().Preview.OptimizeModels;
+
+		if (async) {
+			if (!FileExists(file)) {
+				delete mdl;
+				return nullptr;
+			}
+
+			m_models.push_back(std::make_pair(file, mdl));
+
+			// assimp runs on a worker, the model draws nothing until the GL buffers are created
+			Logger::Get().Log("Loading a 3D model " + path + " in the background");
+			AssetLoader::Instance().Add(
+				mdl,
+				[mdl, path, optimize]() {
+					return mdl->Import(path, optimize);
+				},
+				[this, mdl, file](bool loaded) {
+					if (loaded)
+						mdl->Upload();
+					m_modelLoaded(mdl, loaded, file);
+				});
+
+			return mdl;
+		}
 
 		// load the model
-		std::string path = GetProjectPath(file);
-		bool loaded = m_models[m_models.size() - 1].second->LoadFromFile(path);
+		bool loaded = mdl->LoadFromFile(path, optimize);
 		if (!loaded) {
-			m_models.erase(m_models.begin() + (m_models.size() - 1));
+			delete mdl;
 			return nullptr;
 		}
 
-		return m_models[m_models.size() - 1].second;
+		m_models.push_back(std::make_pair(file, mdl));
+
+		return mdl;
+	}
+	void ProjectParser::m_modelLoaded(eng::Model* mdl, bool loaded, const std::string& file)
+	{
+		// Upload() created the default VAOs - set up the input layout and the instance buffer of every item that uses the model
+		bool used = false;
+		for (PipelineItem* passItem : m_pipe->GetList()) {
+			if (passItem->Type != PipelineItem::ItemType::ShaderPass)
+				continue;
+
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)passItem->Data;
+			for (PipelineItem* item : pass->Items) {
+				if (item->Type != PipelineItem::ItemType::Model || ((pipe::Model*)item->Data)->Data != mdl)
+					continue;
+
+				used = true;
+				if (!loaded) {
+					m_msgs->Add(ed::MessageStack::Type::Error, passItem->Name, "Failed to load .obj model " + std::string(item->Name));
+					continue;
+				}
+
+				BufferObject* bobj = (BufferObject*)((pipe::Model*)item->Data)->InstanceBuffer;
+				for (auto& mesh : mdl->Meshes) {
+					if (bobj == nullptr)
+						mesh.CreateVAO(pass->InputLayout);
+					else
+						mesh.CreateVAO(pass->InputLayout, bobj->ID, m_objects->ParseBufferFormat(bobj->ViewFormat));
+				}
+			}
+		}
+
+		if (!loaded && !used)
+			m_msgs->Add(ed::MessageStack::Type::Error, "", "Failed to load .obj model " + file);
 	}
 	void ProjectParser::SaveProjectFile(const std::string& file, const std::string& data)
 	{
 		std::ofstream out(GetProjectPath(file));
 		out << data;
 		out.close();
+
+		ShaderFileCache::Instance().Invalidate(GetProjectPath(file));
 	}
 	std::string ProjectParser::GetRelativePath(const std::string& to)
 	{
@@ -1564,7 +1653,7 @@ namespace ed {
 				pipe::Model* tData = reinterpret_cast<pipe::Model*>(itemData);
 
 				//std::string objMem = LoadProjectFile(tData->Filename);
-				eng::Model* ptrObject = LoadModel(tData->Filename);
+				eng::Model* ptrObject = LoadModel(tData->Filename, true);
 				bool loaded = ptrObject != nullptr;
 
 				if (loaded)
@@ -1611,7 +1700,7 @@ namespace ed {
 			// check if it should be collapsed
 			if (!passNode.attribute("collapsed").empty()) {
 				bool cs = passNode.attribute("collapsed").as_bool();
-				if (cs)
+				if (cs && m_ui != nullptr)
 					((PipelineUI*)m_ui->Get(ViewID::Pipeline))->Collapse(data);
 			}
 
@@ -1909,7 +1998,7 @@ namespace ed {
 					pipe::Model* tData = reinterpret_cast<pipe::Model*>(itemData);
 
 					//std::string objMem = LoadProjectFile(tData->Filename);
-					eng::Model* ptrObject = LoadModel(tData->Filename);
+					eng::Model* ptrObject = LoadModel(tData->Filename, true);
 					bool loaded = ptrObject != nullptr;
 
 					if (loaded)
@@ -2092,13 +2181,13 @@ namespace ed {
 		for (pugi::xml_node settingItem : projectNode.child("settings").children("entry")) {
 			if (!settingItem.attribute("type").empty()) {
 				std::string type = settingItem.attribute("type").as_string();
-				if (type == "property") {
+				if (type == "property" && m_ui != nullptr) {
 					PropertyUI* props = ((PropertyUI*)m_ui->Get(ViewID::Properties));
 					if (!settingItem.attribute("name").empty()) {
 						PipelineItem* item = m_pipe->Get(settingItem.attribute("name").as_string());
 						props->Open(item);
 					}
-				} else if (type == "file" && Settings::Instance().General.ReopenShaders) {
+				} else if (type == "file" && Settings::Instance().General.ReopenShaders && m_ui != nullptr) {
 					CodeEditorUI* editor = ((CodeEditorUI*)m_ui->Get(ViewID::Code));
 					if (!settingItem.attribute("name").empty()) {
 						PipelineItem* item = m_pipe->Get(settingItem.attribute("name").as_string());
@@ -2119,7 +2208,7 @@ namespace ed {
 						else if (strcmp(shaderType, "gs") == 0 && FileExists(path))
 							editor->Open(item, ShaderStage::Geometry);
 					}
-				} else if (type == "pinned") {
+				} else if (type == "pinned" && m_ui != nullptr) {
 					PinnedUI* pinned = ((PinnedUI*)m_ui->Get(ViewID::Pinned));
 					if (!settingItem.attribute("name").empty()) {
 						const pugi::char_t* item = settingItem.attribute("name").as_string();
@@ -2226,7 +2315,7 @@ namespace ed {
 				// check if it should be collapsed
 				if (!passNode.attribute("collapsed").empty()) {
 					bool cs = passNode.attribute("collapsed").as_bool();
-					if (cs)
+					if (cs && m_ui != nullptr)
 						((PipelineUI*)m_ui->Get(ViewID::Pipeline))->Collapse(data);
 				}
 
@@ -2611,6 +2700,15 @@ namespace ed {
 					data->Macros.push_back(newMacro);
 				}
 
+				// get sample format
+				pugi::xml_node formatNode = passNode.child("format");
+				if (!formatNode.attribute("rate").empty())
+					data->SampleRate = formatNode.attribute("rate").as_int();
+				if (!formatNode.attribute("block").empty())
+					data->BlockSize = formatNode.attribute("block").as_int();
+				if (!formatNode.attribute("channels").empty())
+					data->Channels = formatNode.attribute("channels").as_int();
+
 				// add the item
 				m_pipe->AddAudioPass(name, data);
 			} else if (type == PipelineItem::ItemType::PluginItem) {
@@ -2968,25 +3066,25 @@ namespace ed {
 				m_objects->CreateBuffer(objName);
 				ed::BufferObject* buf = m_objects->GetBuffer(objName);
 
-				if (!objectNode.attribute("size").empty()) {
-					buf->Size = objectNode.attribute("size").as_int();
-					buf->Data = realloc(buf->Data, buf->Size);
-				}
+				int bufSize = 0;
+				if (!objectNode.attribute("size").empty())
+					bufSize = objectNode.attribute("size").as_int();
 				if (!objectNode.attribute("format").empty())
 					strcpy(buf->ViewFormat, objectNode.attribute("format").as_string());
 
 				if (!objectNode.attribute("pausedpreview").empty())
 					buf->PreviewPaused = objectNode.attribute("pausedpreview").as_bool();
 
-				std::string bPath = GetProjectPath("buffers/" + std::string(objName) + ".buf");
-				std::ifstream bufRead(bPath, std::ios::binary);
-				if (bufRead.is_open())
-					bufRead.read((char*)buf->Data, buf->Size);
-				bufRead.close();
+				// the .buf file is mapped & uploaded as is - it only has to be copied if it doesn't match the stored size
+				bool loaded = m_objects->LoadBufferFromFile(buf, "buffers/" + std::string(objName) + ".buf");
+				if (!loaded || buf->Size != bufSize) {
+					buf->Resize(bufSize);
 
-				glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
-				glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // allocate 0 bytes of memory
-				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+					glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
+					glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW);
+					glBindBuffer(GL_UNIFORM_BUFFER, 0);
+					buf->Generation++;
+				}
 
 				for (pugi::xml_node bindNode : objectNode.children("bind")) {
 					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
@@ -3051,16 +3149,17 @@ namespace ed {
 			geo.first->InstanceBuffer = bojb;
 			gl::CreateVAO(geo.first->VAO, geo.first->VBO, geo.second.second->InputLayout, 0, bojb->ID, m_objects->ParseBufferFormat(bojb->ViewFormat));
 		}
+		// models that are still loading have no meshes yet - m_modelLoaded() sets their VAOs up after the upload
 		for (auto& mdl : modelUBOs) {
 			if (mdl.second.first.size() > 0) {
 				BufferObject* bobj = m_objects->GetBuffer(mdl.second.first);
 				mdl.first->InstanceBuffer = bobj;
 
 				for (auto& mesh : mdl.first->Data->Meshes)
-					gl::CreateVAO(mesh.VAO, mesh.VBO, mdl.second.second->InputLayout, mesh.EBO, bobj->ID, m_objects->ParseBufferFormat(bobj->ViewFormat));
+					mesh.CreateVAO(mdl.second.second->InputLayout, bobj->ID, m_objects->ParseBufferFormat(bobj->ViewFormat));
 			} else { // recreate vao anyway
 				for (auto& mesh : mdl.first->Data->Meshes)
-					gl::CreateVAO(mesh.VAO, mesh.VBO, mdl.second.second->InputLayout, mesh.EBO);
+					mesh.CreateVAO(mdl.second.second->InputLayout);
 			}
 		}
 		for (auto& vb : vbUBOs) {
@@ -3086,7 +3185,7 @@ namespace ed {
 		for (pugi::xml_node settingItem : projectNode.child("settings").children("entry")) {
 			if (!settingItem.attribute("type").empty()) {
 				std::string type = settingItem.attribute("type").as_string();
-				if (type == "property") {
+				if (type == "property" && m_ui != nullptr) {
 					PropertyUI* props = ((PropertyUI*)m_ui->Get(ViewID::Properties));
 					if (!settingItem.attribute("name").empty()) {
 						int type = 0; // pipeline item
@@ -3105,7 +3204,7 @@ namespace ed {
 						} else
 							props->Open(itemName, m_objects->GetObjectManagerItem(itemName));
 					}
-				} else if (type == "file" && Settings::Instance().General.ReopenShaders) {
+				} else if (type == "file" && Settings::Instance().General.ReopenShaders && m_ui != nullptr) {
 					CodeEditorUI* editor = ((CodeEditorUI*)m_ui->Get(ViewID::Code));
 					if (!settingItem.attribute("name").empty()) {
 						PipelineItem* item = m_pipe->Get(settingItem.attribute("name").as_string());
@@ -3135,7 +3234,7 @@ namespace ed {
 							editor->Open(item, ShaderStage::Pixel);
 						}
 					}
-				} else if (type == "pinned") {
+				} else if (type == "pinned" && m_ui != nullptr) {
 					PinnedUI* pinned = ((PinnedUI*)m_ui->Get(ViewID::Pinned));
 					if (!settingItem.attribute("name").empty()) {
 						const pugi::char_t* item = settingItem.attribute("name").as_string();
@@ -46,7 +46,7 @@ namespace ed {
 		std::string LoadProjectFile(const std::string& file);
 		std::string LoadFile(const std::string& file);
 		char* LoadProjectFile(const std::string& file, size_t& len);
-		eng::Model* LoadModel(const std::string& file);
+		eng::Model* LoadModel(const std::string& file, bool async = false); // async: returns an empty model that gets filled in later
 
 		void SaveProjectFile(const std::string& file, const std::string& data);
 
@@ -101,5 +101,6 @@ namespace ed {
 		void m_addPlugin(const std::string& name);
 
 		std::vector<std::pair<std::string, eng::Model*>> m_models;
+		void m_modelLoaded(eng::Model* mdl, bool loaded, const std::string& file); // main thread, after a background import
 	};
 }
\ No newline at end of file
@@ -9,9 +9,14 @@
 #include <SHADERed/Objects/RenderEngine.h>
 #include <SHADERed/Objects/Settings.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
+#include <SHADERed/Objects/ShaderFileCache.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
 
 #include <algorithm>
+#include <atomic>
+#include <regex>
+#include <string_view>
+#include <thread>
 #include <glm/gtx/intersect.hpp>
 
 static const GLenum fboBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4, GL_COLOR_ATTACHMENT5, GL_COLOR_ATTACHMENT6, GL_COLOR_ATTACHMENT7, GL_COLOR_ATTACHMENT8, GL_COLOR_ATTACHMENT9, GL_COLOR_ATTACHMENT10, GL_COLOR_ATTACHMENT11, GL_COLOR_ATTACHMENT12, GL_COLOR_ATTACHMENT13, GL_COLOR_ATTACHMENT14, GL_COLOR_ATTACHMENT15 };
@@ -26,6 +31,19 @@ void main()
 	outColor = _sed_dbg_pixel_color;
 }
 )";
+static const char* PickDebugShaderCode = R"(
+#version 330
+
+uniform uint _sed_dbg_vertex_base;
+uniform uint _sed_dbg_vertex_step;
+flat in int _sed_dbg_instance;
+out uvec4 outID;
+
+void main()
+{
+	outID = uvec4(_sed_dbg_vertex_base + uint(gl_PrimitiveID) * _sed_dbg_vertex_step, uint(_sed_dbg_instance), 0u, 1u);
+}
+)";
 
 
 namespace ed {
@@ -71,6 +89,30 @@ namespace ed {
 			iStart += iStep;
 		}
 	}
+	GLuint GetPrimitiveVertexStep(GLuint topology)
+	{
+		// first vertex of the Nth primitive is N * step
+		switch (topology) {
+		case GL_LINES: return 2;
+		case GL_TRIANGLES: return 3;
+		case GL_LINES_ADJACENCY: return 4;
+		case GL_TRIANGLES_ADJACENCY: return 6;
+		case GL_TRIANGLE_STRIP_ADJACENCY: return 2;
+		}
+		return 1; // points, strips, loops & fans
+	}
+	bool InjectPickOutput(std::string& vs)
+	{
+		// gl_InstanceID only exists in the VS - pass it down to the pick shader
+		std::smatch match;
+		if (!std::regex_search(vs, match, std::regex("void\\s+main\\s*\\(\\s*(void)?\\s*\\)\\s*\\{")))
+			return false;
+
+		size_t mainLoc = match.position(0);
+		vs.insert(mainLoc + match.length(0), "\n\t_sed_dbg_instance = gl_InstanceID;\n");
+		vs.insert(mainLoc, "flat out int _sed_dbg_instance;\n");
+		return true;
+	}
 	uint8_t* GetRawPixel(GLuint rt, uint8_t* data, int x, int y, int width)
 	{
 		glBindTexture(GL_TEXTURE_2D, rt);
@@ -95,11 +137,16 @@ namespace ed {
 			, m_pickAwaiting(false)
 			, m_rtColor(0)
 			, m_rtDepth(0)
-			, m_fbosNeedUpdate(false)
 			, m_computeSupported(true)
 			, m_wasMultiPick(false)
+			, m_uniformCallCount(0)
+			, m_pickFBO(0)
+			, m_pickColor(0)
+			, m_pickDepth(0)
+			, m_pickSize(0, 0)
 	{
 		m_paused = false;
+		m_recompileExit = false;
 
 		glGenTextures(1, &m_rtColor);
 		glGenTextures(1, &m_rtDepth);
@@ -111,6 +158,10 @@ namespace ed {
 		bool isDebugShaderCompiled = gl::CheckShaderCompilationStatus(m_generalDebugShader, msg);
 		if (!isDebugShaderCompiled)
 			Logger::Get().Log("Failed to compile the debug pixel shader.", true);
+
+		m_pickPixelShader = gl::CompileShader(GL_FRAGMENT_SHADER, PickDebugShaderCode);
+		if (!gl::CheckShaderCompilationStatus(m_pickPixelShader, msg))
+			Logger::Get().Log("Failed to compile the pick pixel shader.", true);
 	}
 	RenderEngine::~RenderEngine()
 	{
@@ -119,12 +170,27 @@ namespace ed {
 		glDeleteTextures(1, &m_rtColorMS);
 		glDeleteTextures(1, &m_rtDepthMS);
 		glDeleteShader(m_generalDebugShader);
+		glDeleteShader(m_pickPixelShader);
+		if (m_pickFBO != 0)
+			gl::FreeSimpleFramebuffer(m_pickFBO, m_pickColor, m_pickDepth);
 		FlushCache();
+
+		if (m_recompileThread.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(m_recompileMutex);
+				m_recompileExit = true;
+			}
+			m_recompileWork.notify_one();
+			m_recompileThread.join();
+		}
 	}
 	void RenderEngine::Render(int width, int height, bool isDebug, PipelineItem* breakItem)
 	{
 		bool isMSAA = (Settings::Instance().Preview.MSAA != 1) && !isDebug;
 
+		if (!isDebug)
+			ShaderVariableContainer::UniformCallCount = 0;
+
 		if (isMSAA)
 			glEnable(GL_MULTISAMPLE);
 
@@ -144,19 +210,24 @@ namespace ed {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 			glBindTexture(GL_TEXTURE_2D, 0);
 
+			// nothing is rendered to the multisampled textures with MSAA turned off
+			glm::ivec2 sizeMS = Settings::Instance().Preview.MSAA > 1 ? glm::ivec2(width, height) : glm::ivec2(1, 1);
+
 			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_rtColorMS);
-			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, Settings::Instance().Project.UseAlphaChannel ? GL_RGBA : GL_RGB, width, height, true);
+			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, Settings::Instance().Project.UseAlphaChannel ? GL_RGBA : GL_RGB, sizeMS.x, sizeMS.y, true);
 
 			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_rtDepthMS);
-			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, GL_DEPTH24_STENCIL8, width, height, true);
+			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, GL_DEPTH24_STENCIL8, sizeMS.x, sizeMS.y, true);
 			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
 
-			// update
+			m_objects->BumpTextureGeneration(m_rtColor);
+
+			// update - fixed size render textures too, the MSAA setting might have changed (they are only reallocated if needed)
 			std::vector<std::string> objs = m_objects->GetObjects();
 			for (int i = 0; i < objs.size(); i++) {
 				if (m_objects->IsRenderTexture(objs[i])) {
 					ed::RenderTextureObject* rtObj = m_objects->GetRenderTexture(m_objects->GetTexture(objs[i]));
-					if (rtObj != nullptr && rtObj->FixedSize.x == -1)
+					if (rtObj != nullptr)
 						m_objects->ResizeRenderTexture(objs[i], rtObj->CalculateSize(width, height));
 				}
 			}
@@ -164,8 +235,11 @@ namespace ed {
 
 		// cache elements
 		m_cache();
+		m_updateRTSharing();
 
 		auto& systemVM = SystemVariableManager::Instance();
+		systemVM.UpdateSnapshot();
+		systemVM.UpdateUniformBuffer();
 
 		auto& itemVarValues = GetItemVariableValues();
 		GLuint previousTexture[MAX_RENDER_TEXTURES] = { 0 }; // dont clear the render target if we use it two times in a row
@@ -239,8 +313,10 @@ namespace ed {
 						clearedWindow = true;
 					}
 				}
-				for (int i = 0; i < data->RTCount; i++)
+				for (int i = 0; i < data->RTCount; i++) {
 					previousTexture[i] = data->RenderTextures[i];
+					m_objects->BumpTextureGeneration(data->RenderTextures[i]); // for the debugger's texture cache
+				}
 
 				// update viewport value
 				systemVM.SetViewportSize(rtSize.x, rtSize.y);
@@ -248,11 +324,15 @@ namespace ed {
 
 				// bind shaders
 				if (isDebug) {
-					data->Variables.UpdateUniformInfo(m_debugShaders[i]);
+					data->Variables.SelectProgram(m_debugShaders[i]);
 					glUseProgram(m_debugShaders[i]);
 				} else
 					glUseProgram(m_shaders[i]);
 
+				// bind uniform blocks - the viewport size might have changed
+				systemVM.UpdateUniformBuffer();
+				data->Variables.BindUniformBlock();
+
 				// bind shader resource views
 				for (int j = 0; j < srvs.size(); j++) {
 					glActiveTexture(GL_TEXTURE0 + j);
@@ -264,16 +344,22 @@ namespace ed {
 						PluginObject* pobj = m_objects->GetPluginObject(srvs[j]);
 						pobj->Owner->Object_Bind(pobj->Type, pobj->Data, pobj->ID);
 					} else
-						glBindTexture(GL_TEXTURE_2D, srvs[j]);
+						glBindTexture(GL_TEXTURE_2D, m_getColorOwner(srvs[j]));
 
 					
 					if (ShaderCompiler::GetShaderLanguageFromExtension(data->PSPath) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
 						data->Variables.UpdateTexture(m_shaders[i], j);
 				}
 
-				for (int j = 0; j < ubos.size(); j++)
+				for (int j = 0; j < ubos.size(); j++) {
 					glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j, ubos[j]);
 
+					// the pass can write to it - invalidates the cached picking BVH
+					BufferObject* bobj = m_objects->GetBufferByID(ubos[j]);
+					if (bobj != nullptr)
+						bobj->Generation++;
+				}
+
 				// clear messages
 				//if (m_msgs->GetGroupWarningMsgCount(it->Name) > 0)
 				//	m_msgs->ClearGroup(it->Name, (int)ed::MessageStack::Type::Warning);
@@ -299,7 +385,8 @@ namespace ed {
 							float g = ((debugID & 0x0000FF00) >> 8) / 255.0f;
 							float b = ((debugID & 0x00FF0000) >> 16) / 255.0f;
 							float a = 0.0f; // Maybe pack additional data here?
-							glUniform4f(glGetUniformLocation(m_debugShaders[i], "_sed_dbg_pixel_color"), r, g, b, a);
+							glUniform4f(data->Variables.GetDebugPixelColorLocation(), r, g, b, a);
+							ShaderVariableContainer::UniformCallCount++;
 							debugID++;
 						}
 					}
@@ -429,7 +516,7 @@ namespace ed {
 				}
 
 				if (isDebug)
-					data->Variables.UpdateUniformInfo(m_shaders[i]); // return old variable data
+					data->Variables.SelectProgram(m_shaders[i]); // return old variable data
 
 				if (isMSAA) {
 					glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fboMS[data]);
@@ -456,6 +543,7 @@ namespace ed {
 
 				// bind shaders
 				glUseProgram(m_shaders[i]);
+				data->Variables.BindUniformBlock();
 
 				// bind shader resource views
 				for (int j = 0; j < srvs.size(); j++) {
@@ -496,6 +584,16 @@ namespace ed {
 				// call compute shader
 				glDispatchCompute(data->WorkX, data->WorkY, data->WorkZ);
 
+				for (int j = 0; j < ubos.size(); j++) {
+					if (m_objects->IsImage(ubos[j]) || m_objects->IsImage3D(ubos[j]))
+						m_objects->BumpTextureGeneration(ubos[j]);
+					else {
+						BufferObject* bobj = m_objects->GetBufferByID(ubos[j]);
+						if (bobj != nullptr)
+							bobj->Generation++;
+					}
+				}
+
 				// wait until it finishes
 				glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 				// or maybe until i implement these as options glMemoryBarrier(GL_ALL_BARRIER_BITS);
@@ -503,35 +601,7 @@ namespace ed {
 			else if (it->Type == PipelineItem::ItemType::AudioPass && !isDebug) {
 				pipe::AudioPass* data = (pipe::AudioPass*)it->Data;
 
-				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_items[i]);
-				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_items[i]);
-
-				// bind shader resource views
-				for (int j = 0; j < srvs.size(); j++) {
-					glActiveTexture(GL_TEXTURE0 + j);
-					if (m_objects->IsCubeMap(srvs[j]))
-						glBindTexture(GL_TEXTURE_CUBE_MAP, srvs[j]);
-					else if (m_objects->IsImage3D(srvs[j]))
-						glBindTexture(GL_TEXTURE_3D, srvs[j]);
-					else if (m_objects->IsPluginObject(srvs[j])) {
-						PluginObject* pobj = m_objects->GetPluginObject(srvs[j]);
-						pobj->Owner->Object_Bind(pobj->Type, pobj->Data, pobj->ID);
-					} else
-						glBindTexture(GL_TEXTURE_2D, srvs[j]);
-
-					if (ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
-						data->Variables.UpdateTexture(m_shaders[i], j);
-				}
-
-				// bind buffers
-				for (int j = 0; j < ubos.size(); j++) {
-					if (m_objects->IsBuffer(m_objects->GetBufferNameByID(ubos[j])))
-						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j, ubos[j]);
-				}
-
-				// bind variables
-				data->Variables.Bind();
-
+				m_bindAudioPass(i);
 				data->Stream.renderAudio();
 			}
 			else if (it->Type == PipelineItem::ItemType::PluginItem) {
@@ -541,6 +611,11 @@ namespace ed {
 					pldata->Owner->PipelineItem_Execute(pldata->Type, pldata->PluginData, pldata->Items.data(), pldata->Items.size());
 				else if (pldata->Owner->PipelineItem_IsDebuggable(pldata->Type, pldata->PluginData))
 					pldata->Owner->PipelineItem_DebugExecute(pldata->Type, pldata->PluginData, pldata->Items.data(), pldata->Items.size(), &debugID);
+
+				// no way to know what the plugin has drawn to
+				m_objects->BumpWritableTextureGenerations();
+				m_objects->BumpBufferGenerations();
+				m_objects->BumpTextureGeneration(m_rtColor);
 			}
 
 			if (it == breakItem && breakItem != nullptr)
@@ -549,6 +624,9 @@ namespace ed {
 
 		m_plugins->EndRender();
 
+		if (!isDebug)
+			m_uniformCallCount = ShaderVariableContainer::UniformCallCount;
+
 		// update frame index
 		if (!m_paused) {
 			systemVM.CopyState();
@@ -579,11 +657,11 @@ namespace ed {
 				if (m_items[i] == vertexData)
 					vertexPassID = i;
 
-			// _sed_dbg_pixel_color
-			GLuint sedVarLoc = glGetUniformLocation(m_debugShaders[vertexPassID], "_sed_dbg_pixel_color");
-
 			// update info
-			vertexPass->Variables.UpdateUniformInfo(m_debugShaders[vertexPassID]);
+			vertexPass->Variables.SelectProgram(m_debugShaders[vertexPassID]);
+
+			// _sed_dbg_pixel_color
+			GLuint sedVarLoc = vertexPass->Variables.GetDebugPixelColorLocation();
 
 			// get resources
 			const std::vector<GLuint>& srvs = m_objects->GetBindList(vertexData);
@@ -616,6 +694,7 @@ namespace ed {
 				}
 
 				glClearBufferfv(GL_COLOR, i, glm::value_ptr(glm::vec4(0.0f)));
+				m_objects->BumpTextureGeneration(rt);
 			}
 
 			// update viewport value
@@ -623,6 +702,7 @@ namespace ed {
 
 			// bind shaders
 			glUseProgram(m_debugShaders[vertexPassID]);
+			vertexPass->Variables.BindUniformBlock();
 
 			// bind shader resource views
 			for (int j = 0; j < srvs.size(); j++) {
@@ -782,7 +862,7 @@ namespace ed {
 			int vertexGroup = 0x00ffffff & GetPixelID(vertexPass->RenderTextures[0], mainPixelData, x, y, rtSize.x);
 
 			// return old info
-			vertexPass->Variables.UpdateUniformInfo(m_shaders[vertexPassID]);
+			vertexPass->Variables.SelectProgram(m_shaders[vertexPassID]);
 			delete[] mainPixelData;
 
 			return vertexGroup;
@@ -818,11 +898,11 @@ namespace ed {
 				if (m_items[i] == vertexData)
 					vertexPassID = i;
 
-			// _sed_dbg_pixel_color
-			GLuint sedVarLoc = glGetUniformLocation(m_debugShaders[vertexPassID], "_sed_dbg_pixel_color");
-
 			// update info
-			vertexPass->Variables.UpdateUniformInfo(m_debugShaders[vertexPassID]);
+			vertexPass->Variables.SelectProgram(m_debugShaders[vertexPassID]);
+
+			// _sed_dbg_pixel_color
+			GLuint sedVarLoc = vertexPass->Variables.GetDebugPixelColorLocation();
 
 			// get resources
 			const std::vector<GLuint>& srvs = m_objects->GetBindList(vertexData);
@@ -855,6 +935,7 @@ namespace ed {
 				}
 
 				glClearBufferfv(GL_COLOR, i, glm::value_ptr(glm::vec4(0.0f)));
+				m_objects->BumpTextureGeneration(rt);
 			}
 
 			// update viewport value
@@ -862,6 +943,7 @@ namespace ed {
 
 			// bind shaders
 			glUseProgram(m_debugShaders[vertexPassID]);
+			vertexPass->Variables.BindUniformBlock();
 
 			// bind shader resource views
 			for (int j = 0; j < srvs.size(); j++) {
@@ -980,7 +1062,7 @@ namespace ed {
 			int vertexGroup = 0x00ffffff & GetPixelID(vertexPass->RenderTextures[0], mainPixelData, x, y, rtSize.x);
 
 			// return old info
-			vertexPass->Variables.UpdateUniformInfo(m_shaders[vertexPassID]);
+			vertexPass->Variables.SelectProgram(m_shaders[vertexPassID]);
 			delete[] mainPixelData;
 
 			return vertexGroup;
@@ -995,6 +1077,281 @@ namespace ed {
 
 		return 0;
 	}
+	bool RenderEngine::DebugPick(PipelineItem* vertexData, PipelineItem* vertexItem, glm::vec2 r, int& vertexID, int& instanceID)
+	{
+		if (vertexData->Type != PipelineItem::ItemType::ShaderPass)
+			return false;
+		if (vertexItem->Type != PipelineItem::ItemType::Geometry && vertexItem->Type != PipelineItem::ItemType::Model && vertexItem->Type != PipelineItem::ItemType::VertexBuffer)
+			return false;
+
+		pipe::ShaderPass* vertexPass = (pipe::ShaderPass*)vertexData->Data;
+
+		int vertexPassID = 0;
+		for (int i = 0; i < m_items.size(); i++)
+			if (m_items[i] == vertexData)
+				vertexPassID = i;
+
+		GLuint pickProgram = m_getPickProgram(vertexPassID);
+		if (pickProgram == 0)
+			return false;
+
+		// update info
+		vertexPass->Variables.SelectProgram(pickProgram);
+
+		GLint baseLoc = glGetUniformLocation(pickProgram, "_sed_dbg_vertex_base");
+		GLint stepLoc = glGetUniformLocation(pickProgram, "_sed_dbg_vertex_step");
+
+		// get resources
+		const std::vector<GLuint>& srvs = m_objects->GetBindList(vertexData);
+		const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(vertexData);
+
+		// item variable values
+		auto& itemVarValues = GetItemVariableValues();
+
+		// the IDs go to a separate integer target so that the pass' RTs stay intact
+		glm::vec2 rtSize(m_lastSize.x, m_lastSize.y);
+		if (vertexPass->RenderTextures[0] != 0 && vertexPass->RenderTextures[0] != m_rtColor)
+			rtSize = m_objects->GetRenderTexture(vertexPass->RenderTextures[0])->CalculateSize(m_lastSize.x, m_lastSize.y);
+
+		m_updatePickTarget(glm::ivec2(rtSize.x, rtSize.y));
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_pickFBO);
+		glDrawBuffers(1, fboBuffers);
+
+		GLuint clearID[4] = { 0, 0, 0, 0 };
+		glStencilMask(0xFFFFFFFF);
+		glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+		glClearBufferuiv(GL_COLOR, 0, clearID);
+
+		// update viewport value
+		glViewport(0, 0, rtSize.x, rtSize.y);
+
+		// bind shaders
+		glUseProgram(pickProgram);
+		vertexPass->Variables.BindUniformBlock();
+
+		// bind shader resource views
+		for (int j = 0; j < srvs.size(); j++) {
+			glActiveTexture(GL_TEXTURE0 + j);
+			if (m_objects->IsCubeMap(srvs[j]))
+				glBindTexture(GL_TEXTURE_CUBE_MAP, srvs[j]);
+			else if (m_objects->IsImage3D(srvs[j]))
+				glBindTexture(GL_TEXTURE_3D, srvs[j]);
+			else if (m_objects->IsPluginObject(srvs[j])) {
+				PluginObject* pobj = m_objects->GetPluginObject(srvs[j]);
+				pobj->Owner->Object_Bind(pobj->Type, pobj->Data, pobj->ID);
+			} else
+				glBindTexture(GL_TEXTURE_2D, srvs[j]);
+
+			if (ShaderCompiler::GetShaderLanguageFromExtension(vertexPass->PSPath) == ShaderLanguage::GLSL)
+				vertexPass->Variables.UpdateTexture(pickProgram, j);
+		}
+		for (int j = 0; j < ubos.size(); j++)
+			glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j]);
+
+		// bind default states for each shader pass
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+
+		// render pipeline items
+		DefaultState::Bind();
+		for (int j = 0; j < vertexPass->Items.size(); j++) {
+			PipelineItem* item = vertexPass->Items[j];
+
+			// update the value for this element and check if we picked it
+			if (item->Type == PipelineItem::ItemType::Geometry || item->Type == PipelineItem::ItemType::Model || item->Type == PipelineItem::ItemType::VertexBuffer || item->Type == PipelineItem::ItemType::PluginItem) {
+				if (item != vertexItem)
+					continue;
+				for (int k = 0; k < itemVarValues.size(); k++)
+					if (itemVarValues[k].Item == item)
+						itemVarValues[k].Variable->Data = itemVarValues[k].NewValue->Data;
+			}
+
+			if (item->Type == PipelineItem::ItemType::Geometry) {
+				pipe::GeometryItem* geoData = reinterpret_cast<pipe::GeometryItem*>(item->Data);
+
+				if (geoData->Type == pipe::GeometryItem::Rectangle) {
+					glm::vec3 scaleRect(geoData->Scale.x * rtSize.x, geoData->Scale.y * rtSize.y, 1.0f);
+					glm::vec3 posRect((geoData->Position.x + 0.5f) * rtSize.x, (geoData->Position.y + 0.5f) * rtSize.y, -1000.0f);
+					systemVM.SetGeometryTransform(item, scaleRect, geoData->Rotation, posRect);
+				} else
+					systemVM.SetGeometryTransform(item, geoData->Scale, geoData->Rotation, geoData->Position);
+
+				systemVM.SetPicked(std::count(m_pick.begin(), m_pick.end(), item));
+
+				// bind variables
+				vertexPass->Variables.Bind(item);
+
+				glUniform1ui(baseLoc, 0);
+				glUniform1ui(stepLoc, GetPrimitiveVertexStep(geoData->Topology));
+
+				glBindVertexArray(geoData->VAO);
+				if (geoData->Instanced)
+					glDrawArraysInstanced(geoData->Topology, 0, eng::GeometryFactory::VertexCount[geoData->Type], geoData->InstanceCount);
+				else
+					glDrawArrays(geoData->Topology, 0, eng::GeometryFactory::VertexCount[geoData->Type]);
+			} else if (item->Type == PipelineItem::ItemType::Model) {
+				pipe::Model* objData = reinterpret_cast<pipe::Model*>(item->Data);
+
+				systemVM.SetPicked(std::count(m_pick.begin(), m_pick.end(), item));
+				systemVM.SetGeometryTransform(item, objData->Scale, objData->Rotation, objData->Position);
+
+				// bind variables
+				vertexPass->Variables.Bind(item);
+
+				glUniform1ui(stepLoc, 3);
+
+				int vbase = 0;
+				for (const auto& mesh : objData->Data->Meshes) {
+					glUniform1ui(baseLoc, vbase);
+
+					glBindVertexArray(mesh.VAO);
+					if (objData->Instanced)
+						glDrawElementsInstanced(GL_TRIANGLES, mesh.Indices.size(), GL_UNSIGNED_INT, 0, objData->InstanceCount);
+					else
+						glDrawElements(GL_TRIANGLES, mesh.Indices.size(), GL_UNSIGNED_INT, 0);
+
+					vbase += mesh.Indices.size();
+				}
+			} else if (item->Type == PipelineItem::ItemType::VertexBuffer) {
+				pipe::VertexBuffer* vbData = reinterpret_cast<pipe::VertexBuffer*>(item->Data);
+				ed::BufferObject* bobj = (ed::BufferObject*)vbData->Buffer;
+
+				auto bobjFmt = m_objects->ParseBufferFormat(bobj->ViewFormat);
+				int stride = 0;
+				for (const auto& f : bobjFmt)
+					stride += ShaderVariable::GetSize(f, true);
+
+				if (stride != 0) {
+					systemVM.SetGeometryTransform(item, vbData->Scale, vbData->Rotation, vbData->Position);
+					systemVM.SetPicked(std::count(m_pick.begin(), m_pick.end(), item));
+
+					// bind variables
+					vertexPass->Variables.Bind(item);
+
+					glUniform1ui(baseLoc, 0);
+					glUniform1ui(stepLoc, GetPrimitiveVertexStep(vbData->Topology));
+
+					glBindVertexArray(vbData->VAO);
+					glDrawArrays(vbData->Topology, 0, bobj->Size / stride);
+				}
+			} else if (item->Type == PipelineItem::ItemType::RenderState) {
+				pipe::RenderState* state = reinterpret_cast<pipe::RenderState*>(item->Data);
+
+				// depth clamp
+				if (state->DepthClamp)
+					glEnable(GL_DEPTH_CLAMP);
+				else
+					glDisable(GL_DEPTH_CLAMP);
+
+				// fill mode
+				glPolygonMode(GL_FRONT_AND_BACK, state->PolygonMode);
+
+				// culling and front face
+				if (state->CullFace)
+					glEnable(GL_CULL_FACE);
+				else
+					glDisable(GL_CULL_FACE);
+				glCullFace(state->CullFaceType);
+				glFrontFace(state->FrontFace);
+			}
+
+			// set the old value back
+			if (item->Type == PipelineItem::ItemType::Geometry || item->Type == PipelineItem::ItemType::Model || item->Type == PipelineItem::ItemType::VertexBuffer || item->Type == PipelineItem::ItemType::PluginItem)
+				for (int k = 0; k < itemVarValues.size(); k++)
+					if (itemVarValues[k].Item == item)
+						itemVarValues[k].Variable->Data = itemVarValues[k].OldValue;
+		}
+
+		// a single texel: vertex ID, instance ID, unused, coverage
+		GLuint pixelID[4] = { 0, 0, 0, 0 };
+		int x = std::min<int>(r.x * rtSize.x, rtSize.x - 1);
+		int y = std::min<int>(r.y * rtSize.y, rtSize.y - 1);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glReadPixels(x, y, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_INT, pixelID);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		vertexID = pixelID[0];
+		instanceID = pixelID[1];
+
+		// return old info
+		vertexPass->Variables.SelectProgram(m_shaders[vertexPassID]);
+
+		return true;
+	}
+	void RenderEngine::m_resetPickProgram(int passID)
+	{
+		ShaderPack& pack = m_shaderSources[passID];
+		if (pack.PickProgram != 0)
+			glDeleteProgram(pack.PickProgram);
+		pack.PickProgram = 0;
+		pack.PickVS.clear();
+
+		PipelineItem* item = m_items[passID];
+		if (item->Type != PipelineItem::ItemType::ShaderPass || m_shaders[passID] == 0)
+			return;
+
+		// gl_PrimitiveID would come from the GS
+		std::string vsCode = pack.VSCode;
+		if (!((pipe::ShaderPass*)item->Data)->GSUsed && InjectPickOutput(vsCode))
+			pack.PickVS = vsCode;
+	}
+	GLuint RenderEngine::m_getPickProgram(int passID)
+	{
+		ShaderPack& pack = m_shaderSources[passID];
+		if (pack.PickProgram != 0 || pack.PickVS.empty())
+			return pack.PickProgram;
+
+		GLchar msg[1024];
+		GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, pack.PickVS.c_str());
+		if (gl::CheckShaderCompilationStatus(vs, msg)) {
+			pack.PickProgram = glCreateProgram();
+			glAttachShader(pack.PickProgram, vs);
+			glAttachShader(pack.PickProgram, m_pickPixelShader);
+			glLinkProgram(pack.PickProgram);
+
+			if (!gl::CheckShaderLinkStatus(pack.PickProgram, msg)) {
+				glDeleteProgram(pack.PickProgram);
+				pack.PickProgram = 0;
+			}
+		}
+		glDeleteShader(vs);
+
+		if (pack.PickProgram == 0) {
+			Logger::Get().Log("Failed to create the pick shader - falling back to the slower vertex pick", true);
+			Logger::Get().Log(msg, true);
+		}
+
+		pack.PickVS.clear(); // don't try again until the pass is recompiled
+		return pack.PickProgram;
+	}
+	void RenderEngine::m_updatePickTarget(const glm::ivec2& size)
+	{
+		if (m_pickFBO != 0 && m_pickSize == size)
+			return;
+
+		if (m_pickFBO == 0) {
+			glGenTextures(1, &m_pickColor);
+			glGenTextures(1, &m_pickDepth);
+			glGenFramebuffers(1, &m_pickFBO);
+		}
+		m_pickSize = size;
+
+		glBindTexture(GL_TEXTURE_2D, m_pickColor);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, size.x, size.y, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glBindTexture(GL_TEXTURE_2D, m_pickDepth);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, size.x, size.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_pickFBO);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pickColor, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_pickDepth, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
 	void RenderEngine::Pause(bool pause)
 	{
 		m_paused = pause;
@@ -1017,6 +1374,58 @@ namespace ed {
 		}
 
 		m_debug->ClearPixelList();
+
+		// render the paused frame again so that every render texture holds its own contents (for the previews & the debugger)
+		if (m_paused && IsSharingRTMemory())
+			Render();
+	}
+	void RenderEngine::m_bindAudioPass(int index)
+	{
+		pipe::AudioPass* data = (pipe::AudioPass*)m_items[index]->Data;
+
+		const std::vector<GLuint>& srvs = m_objects->GetBindList(m_items[index]);
+		const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_items[index]);
+
+		// uniforms are set on the bound program
+		glUseProgram(data->Stream.getShader());
+
+		// bind shader resource views
+		for (int j = 0; j < srvs.size(); j++) {
+			glActiveTexture(GL_TEXTURE0 + j);
+			if (m_objects->IsCubeMap(srvs[j]))
+				glBindTexture(GL_TEXTURE_CUBE_MAP, srvs[j]);
+			else if (m_objects->IsImage3D(srvs[j]))
+				glBindTexture(GL_TEXTURE_3D, srvs[j]);
+			else if (m_objects->IsPluginObject(srvs[j])) {
+				PluginObject* pobj = m_objects->GetPluginObject(srvs[j]);
+				pobj->Owner->Object_Bind(pobj->Type, pobj->Data, pobj->ID);
+			} else
+				glBindTexture(GL_TEXTURE_2D, srvs[j]);
+
+			if (ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
+				data->Variables.UpdateTexture(m_shaders[index], j);
+		}
+
+		// bind buffers
+		for (int j = 0; j < ubos.size(); j++) {
+			if (m_objects->IsBuffer(m_objects->GetBufferNameByID(ubos[j])))
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j, ubos[j]);
+		}
+
+		// bind variables
+		data->Variables.BindUniformBlock();
+		data->Variables.Bind();
+	}
+	bool RenderEngine::BounceAudio(PipelineItem* item, const std::string& path, float length)
+	{
+		int index = std::distance(m_items.begin(), std::find(m_items.begin(), m_items.end(), item));
+		if (index >= m_items.size() || item->Type != PipelineItem::ItemType::AudioPass)
+			return false;
+
+		pipe::AudioPass* data = (pipe::AudioPass*)item->Data;
+
+		m_bindAudioPass(index);
+		return data->Stream.bounce(path, length);
 	}
 	void RenderEngine::Recompile(const char* name)
 	{
@@ -1031,6 +1440,8 @@ namespace ed {
 		for (int i = 0; i < m_items.size(); i++) {
 			PipelineItem* item = m_items[i];
 			if (strcmp(item->Name, name) == 0) {
+				m_supersedeRecompiles(item);
+
 				if (item->Type == PipelineItem::ItemType::ShaderPass) {
 					pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
 
@@ -1159,6 +1570,8 @@ namespace ed {
 					m_shaderSources[i].VS = vs;
 					m_shaderSources[i].PS = ps;
 					m_shaderSources[i].GS = gs;
+					m_shaderSources[i].VSCode = vsContent;
+					m_resetPickProgram(i);
 				} else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 					pipe::ComputePass* shader = (pipe::ComputePass*)item->Data;
 
@@ -1238,6 +1651,38 @@ namespace ed {
 
 		Render();
 	}
+	void RenderEngine::Recompile(const std::vector<PipelineItem*>& items)
+	{
+		std::vector<PipelineItem*> pending;
+		for (PipelineItem* item : items) {
+			int i = std::distance(m_items.begin(), std::find(m_items.begin(), m_items.end(), item));
+			if (i >= m_items.size())
+				continue;
+
+			if (item->Type == PipelineItem::ItemType::ShaderPass || (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported)) {
+				Logger::Get().Log("Recompiling " + std::string(item->Name));
+
+				m_msgs->BuildOccured = true;
+				m_plugins->HandleApplicationEvent(plugin::ApplicationEvent::PipelineItemCompiled, (void*)item->Name, nullptr);
+				m_msgs->ClearGroup(item->Name);
+
+				SPIRVQueue.push_back(item);
+
+				glDeleteShader(m_shaderSources[i].VS);
+				glDeleteShader(m_shaderSources[i].PS);
+				glDeleteShader(m_shaderSources[i].GS);
+				m_shaderSources[i].VS = m_shaderSources[i].PS = m_shaderSources[i].GS = 0;
+
+				pending.push_back(item);
+			} else
+				Recompile(item->Name);
+		}
+
+		if (!pending.empty()) {
+			m_compileItems(pending);
+			Render();
+		}
+	}
 	void RenderEngine::RecompileFile(const char* fname)
 	{
 		for (int i = 0; i < m_items.size(); i++) {
@@ -1269,6 +1714,8 @@ namespace ed {
 		for (int i = 0; i < m_items.size(); i++) {
 			PipelineItem* item = m_items[i];
 			if (strcmp(item->Name, name) == 0) {
+				m_supersedeRecompiles(item);
+
 				if (item->Type == PipelineItem::ItemType::ShaderPass) {
 					pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
 					m_msgs->ClearGroup(name);
@@ -1335,6 +1782,7 @@ namespace ed {
 
 						glDeleteShader(m_shaderSources[i].VS);
 						m_shaderSources[i].VS = vs;
+						m_shaderSources[i].VSCode = vsContent;
 					}
 
 					// geometry shader
@@ -1387,6 +1835,8 @@ namespace ed {
 
 					if (m_shaders[i] != 0)
 						shader->Variables.UpdateUniformInfo(m_shaders[i]);
+
+					m_resetPickProgram(i);
 				} else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 					pipe::ComputePass* shader = (pipe::ComputePass*)item->Data;
 					m_msgs->ClearGroup(name);
@@ -1457,83 +1907,368 @@ namespace ed {
 
 		Render();
 	}
-	void RenderEngine::Pick(float sx, float sy, bool multiPick, std::function<void(PipelineItem*)> func)
+	void RenderEngine::RecompileFromSourceAsync(const char* name, const std::string& vssrc, const std::string& pssrc, const std::string& gssrc)
 	{
-		m_pickAwaiting = true;
-		m_pickDist = std::numeric_limits<float>::infinity();
-		m_pickHandle = func;
-		m_wasMultiPick = multiPick;
-
-		float mouseX = sx / (m_lastSize.x * 0.5f) - 1.0f;
-		float mouseY = sy / (m_lastSize.y * 0.5f) - 1.0f;
+		PipelineItem* item = nullptr;
+		for (PipelineItem* it : m_items)
+			if (strcmp(it->Name, name) == 0) {
+				item = it;
+				break;
+			}
+		if (item == nullptr)
+			return;
 
-		glm::mat4 proj = SystemVariableManager::Instance().GetProjectionMatrix();
-		glm::mat4 view = SystemVariableManager::Instance().GetCamera()->GetMatrix();
+		if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
 
-		glm::mat4 invVP = glm::inverse(proj * view);
-		glm::vec4 screenPos(mouseX, mouseY, 1.0f, 1.0f);
-		glm::vec4 worldPos = invVP * screenPos;
+			// plugins might not be thread safe
+			if ((vssrc.size() > 0 && ShaderCompiler::GetShaderLanguageFromExtension(shader->VSPath) == ShaderLanguage::Plugin) || (pssrc.size() > 0 && ShaderCompiler::GetShaderLanguageFromExtension(shader->PSPath) == ShaderLanguage::Plugin) || (gssrc.size() > 0 && ShaderCompiler::GetShaderLanguageFromExtension(shader->GSPath) == ShaderLanguage::Plugin)) {
+				RecompileFromSource(name, vssrc, pssrc, gssrc);
+				return;
+			}
 
-		m_pickDir = glm::normalize(glm::vec3(worldPos));
-		m_pickOrigin = SystemVariableManager::Instance().GetCamera()->GetPosition();
+			if (vssrc.size() > 0)
+				m_startRecompile(item, ShaderStage::Vertex, shader->VSPath, shader->VSEntry, vssrc, shader->Macros, shader->GSUsed);
+			if (pssrc.size() > 0)
+				m_startRecompile(item, ShaderStage::Pixel, shader->PSPath, shader->PSEntry, pssrc, shader->Macros, shader->GSUsed);
+			if (gssrc.size() > 0)
+				m_startRecompile(item, ShaderStage::Geometry, shader->GSPath, shader->GSEntry, gssrc, shader->Macros, shader->GSUsed);
+		} else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported && ShaderCompiler::GetShaderLanguageFromExtension(((pipe::ComputePass*)item->Data)->Path) != ShaderLanguage::Plugin) {
+			pipe::ComputePass* shader = (pipe::ComputePass*)item->Data;
+
+			if (vssrc.size() > 0)
+				m_startRecompile(item, ShaderStage::Compute, shader->Path, shader->Entry, vssrc, shader->Macros, false);
+		} else
+			RecompileFromSource(name, vssrc, pssrc, gssrc); // audio passes wrap the source themselves
 	}
-	void RenderEngine::Pick(PipelineItem* item, bool add)
+	void RenderEngine::UpdateRecompiles()
 	{
-		// check if it already exists
-		bool skipAdd = false;
-		for (int i = 0; i < m_pick.size(); i++)
-			if (m_pick[i] == item) {
-				if (!add) {
-					m_pick.clear();
-					m_pick.push_back(item);
-				}
-				skipAdd = true;
-				break;
-			}
+		// all stages of an item are applied together - wait until every valid job of the item is done
+		std::unordered_map<PipelineItem*, bool> pending;
+		std::unordered_map<PipelineItem*, std::vector<AsyncRecompile*>> batches;
+		for (AsyncRecompile* rc : m_recompiles) {
+			PipelineItem* item = rc->Job.Item;
+			if (rc->Cancelled || rc->Generation != m_recompileGeneration[item])
+				continue;
 
-		if (!skipAdd) {
-			if (item == nullptr)
-				m_pick.clear();
-			else if (add)
-				m_pick.push_back(item);
-			else {
-				m_pick.clear();
-				m_pick.push_back(item);
-			}
+			if (rc->Done)
+				batches[item].push_back(rc);
+			else
+				pending[item] = true;
+		}
+
+		bool applied = false;
+		for (auto& batch : batches)
+			if (!pending[batch.first])
+				applied |= m_applyRecompile(batch.second);
+
+		// drop the applied, cancelled & outdated jobs - the ones that are still running are kept
+		for (int r = 0; r < m_recompiles.size(); r++) {
+			AsyncRecompile* rc = m_recompiles[r];
+			if (!rc->Done || pending[rc->Job.Item])
+				continue;
+
+			delete rc;
+			m_recompiles.erase(m_recompiles.begin() + r);
+			r--;
 		}
+
+		if (applied)
+			Render();
 	}
-	void RenderEngine::m_pickItem(PipelineItem* item, bool multiPick)
+	void RenderEngine::m_startRecompile(PipelineItem* item, ShaderStage stage, const std::string& path, const std::string& entry, const std::string& source, std::vector<ShaderMacro>& macros, bool gsUsed)
 	{
-		glm::mat4 world(1);
-		if (item->Type == PipelineItem::ItemType::Geometry) {
-			pipe::GeometryItem* geo = (pipe::GeometryItem*)item->Data;
-			if (geo->Type == pipe::GeometryItem::GeometryType::Rectangle || geo->Type == pipe::GeometryItem::GeometryType::ScreenQuadNDC)
-				return;
-
-			world = glm::translate(glm::mat4(1), geo->Position) * glm::yawPitchRoll(geo->Rotation.y, geo->Rotation.x, geo->Rotation.z);
-		} else if (item->Type == PipelineItem::ItemType::Model) {
-			pipe::Model* obj = (pipe::Model*)item->Data;
+		// the older text is out of date - its results get dropped (and it isn't compiled at all if it's still queued)
+		for (AsyncRecompile* rc : m_recompiles)
+			if (rc->Job.Item == item && rc->Job.Stage == stage)
+				rc->Cancelled = true;
 
-			world = glm::translate(glm::mat4(1), obj->Position) * glm::scale(glm::mat4(1.0f), obj->Scale) * glm::yawPitchRoll(obj->Rotation.y, obj->Rotation.x, obj->Rotation.z);
-		} else if (item->Type == PipelineItem::ItemType::PluginItem) {
-			pipe::PluginItemData* pldata = (pipe::PluginItemData*)item->Data;
+		AsyncRecompile* rc = new AsyncRecompile(item, stage, path, entry, source, macros, gsUsed, m_recompileGeneration[item]);
+		m_recompiles.push_back(rc);
 
-			float plMat[16];
-			pldata->Owner->PipelineItem_GetWorldMatrix(pldata->Type, pldata->PluginData, plMat);
-			world = glm::make_mat4(plMat);
-		} else if (item->Type == PipelineItem::ItemType::VertexBuffer) {
-			pipe::VertexBuffer* obj = (pipe::VertexBuffer*)item->Data;
+		{
+			std::lock_guard<std::mutex> lock(m_recompileMutex);
+			m_recompileQueue.push_back(rc);
 
-			world = glm::translate(glm::mat4(1), obj->Position) * glm::scale(glm::mat4(1.0f), obj->Scale) * glm::yawPitchRoll(obj->Rotation.y, obj->Rotation.x, obj->Rotation.z);
+			if (!m_recompileThread.joinable()) {
+				m_recompileExit = false;
+				m_recompileThread = std::thread(&RenderEngine::m_recompileWorker, this);
+			}
 		}
+		m_recompileWork.notify_one();
+	}
+	void RenderEngine::m_recompileWorker()
+	{
+		while (true) {
+			AsyncRecompile* rc = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(m_recompileMutex);
+				m_recompileWork.wait(lock, [&] { return !m_recompileQueue.empty() || m_recompileExit; });
+				if (m_recompileExit)
+					break;
 
-		glm::mat4 invWorld = glm::inverse(world);
+				rc = m_recompileQueue.front();
+				m_recompileQueue.pop_front();
+			}
 
-		glm::vec4 rayOrigin = invWorld * glm::vec4(m_pickOrigin, 1);
-		glm::vec4 rayDir = invWorld * glm::vec4(m_pickDir, 0.0f);
+			if (!rc->Cancelled)
+				m_compileJob(rc->Job, &rc->Cancelled);
 
-		glm::vec3 vec3Origin = glm::vec3(rayOrigin);
-		glm::vec3 vec3Dir = glm::vec3(rayDir);
+			{
+				std::lock_guard<std::mutex> lock(m_recompileMutex);
+				rc->Done = true;
+			}
+			m_recompileDone.notify_all();
+		}
+	}
+	void RenderEngine::m_supersedeRecompiles(PipelineItem* item)
+	{
+		m_recompileGeneration[item]++;
+
+		for (AsyncRecompile* rc : m_recompiles)
+			if (rc->Job.Item == item)
+				rc->Cancelled = true;
+	}
+	void RenderEngine::m_forgetRecompiles(PipelineItem* item)
+	{
+		for (AsyncRecompile* rc : m_recompiles)
+			if (rc->Job.Item == item)
+				rc->Cancelled = true;
+
+		m_recompileGeneration.erase(item);
+	}
+	bool RenderEngine::m_applyRecompile(const std::vector<AsyncRecompile*>& batch)
+	{
+		PipelineItem* item = batch[0]->Job.Item;
+
+		int i = std::distance(m_items.begin(), std::find(m_items.begin(), m_items.end(), item));
+		if (i >= m_items.size())
+			return false; // removed in the meantime
+
+		m_msgs->BuildOccured = true;
+		m_msgs->CurrentItem = item->Name;
+
+		m_plugins->HandleApplicationEvent(plugin::ApplicationEvent::PipelineItemCompiled, (void*)item->Name, nullptr);
+
+		m_msgs->ClearGroup(item->Name);
+		for (AsyncRecompile* rc : batch)
+			m_msgs->Add(rc->Job.Messages.GetMessages());
+
+		SPIRVQueue.push_back(item);
+
+		bool compiled = true;
+		for (AsyncRecompile* rc : batch) {
+			CompileJob& job = rc->Job;
+			compiled &= job.Compiled;
+
+			// GLSL is passed to the driver directly
+			if (job.Language == ShaderLanguage::GLSL) {
+				int lineBias = 0;
+				job.GLSL = job.Source;
+				m_includeCheck(job.GLSL, std::vector<std::string>(), lineBias);
+				if (item->Type == PipelineItem::ItemType::ShaderPass)
+					m_applyMacros(job.GLSL, (pipe::ShaderPass*)item->Data);
+				else
+					m_applyMacros(job.GLSL, (pipe::ComputePass*)item->Data);
+			}
+		}
+
+		if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
+			bool gsUsed = shader->GSUsed && strlen(shader->GSPath) > 0 && strlen(shader->GSEntry) > 0;
+
+			bool stageApplied[3] = { false, false, false };
+			for (AsyncRecompile* rc : batch) {
+				CompileJob& job = rc->Job;
+
+				GLenum glType = GL_VERTEX_SHADER;
+				GLuint* glShader = &m_shaderSources[i].VS;
+				std::vector<unsigned int>* spv = &shader->VSSPV;
+				int stageIndex = 0;
+				if (job.Stage == ShaderStage::Pixel) {
+					glType = GL_FRAGMENT_SHADER;
+					glShader = &m_shaderSources[i].PS;
+					spv = &shader->PSSPV;
+					stageIndex = 1;
+					shader->Variables.UpdateTextureList(job.GLSL);
+				} else if (job.Stage == ShaderStage::Geometry) {
+					glType = GL_GEOMETRY_SHADER;
+					glShader = &m_shaderSources[i].GS;
+					spv = &shader->GSSPV;
+					stageIndex = 2;
+				}
+				spv->swap(rc->SPV);
+				stageApplied[stageIndex] = true;
+
+				GLuint glID = 0;
+				if (job.Stage != ShaderStage::Geometry || gsUsed) {
+					glID = gl::CompileShader(glType, job.GLSL.c_str());
+					compiled &= gl::CheckShaderCompilationStatus(glID);
+				}
+
+				glDeleteShader(*glShader);
+				*glShader = glID;
+				if (job.Stage == ShaderStage::Vertex)
+					m_shaderSources[i].VSCode = job.GLSL;
+			}
+
+			// the stages that weren't edited keep their shaders - the program can't be linked if one of them is broken
+			if (!stageApplied[0])
+				compiled &= m_shaderSources[i].VS != 0 && gl::CheckShaderCompilationStatus(m_shaderSources[i].VS);
+			if (!stageApplied[1])
+				compiled &= m_shaderSources[i].PS != 0 && gl::CheckShaderCompilationStatus(m_shaderSources[i].PS);
+			if (!stageApplied[2] && gsUsed)
+				compiled &= m_shaderSources[i].GS != 0 && gl::CheckShaderCompilationStatus(m_shaderSources[i].GS);
+
+			if (m_shaders[i] != 0)
+				glDeleteProgram(m_shaders[i]);
+
+			if (!compiled) {
+				m_msgs->Add(MessageStack::Type::Error, item->Name, "Failed to compile the shader(s)");
+				m_shaders[i] = 0;
+			} else {
+				m_msgs->Add(MessageStack::Type::Message, item->Name, "Compiled the shaders.");
+
+				m_shaders[i] = glCreateProgram();
+				glAttachShader(m_shaders[i], m_shaderSources[i].VS);
+				glAttachShader(m_shaders[i], m_shaderSources[i].PS);
+				if (shader->GSUsed) glAttachShader(m_shaders[i], m_shaderSources[i].GS);
+				glLinkProgram(m_shaders[i]);
+			}
+
+			if (m_shaders[i] != 0)
+				shader->Variables.UpdateUniformInfo(m_shaders[i]);
+
+			m_resetPickProgram(i);
+		} else {
+			// a newer job cancels the older ones, so there's only one compute shader in the batch
+			AsyncRecompile* rc = batch.back();
+			pipe::ComputePass* shader = (pipe::ComputePass*)item->Data;
+			shader->SPV.swap(rc->SPV);
+
+			GLuint cs = gl::CompileShader(GL_COMPUTE_SHADER, rc->Job.GLSL.c_str());
+			compiled &= gl::CheckShaderCompilationStatus(cs);
+
+			if (m_shaders[i] != 0)
+				glDeleteProgram(m_shaders[i]);
+
+			if (!compiled) {
+				m_msgs->Add(MessageStack::Type::Error, item->Name, "Failed to compile the compute shader");
+				m_shaders[i] = 0;
+			} else {
+				m_msgs->Add(MessageStack::Type::Message, item->Name, "Compiled the compute shader.");
+
+				m_shaders[i] = glCreateProgram();
+				glAttachShader(m_shaders[i], cs);
+				glLinkProgram(m_shaders[i]);
+			}
+
+			if (m_shaders[i] != 0)
+				shader->Variables.UpdateUniformInfo(m_shaders[i]);
+
+			glDeleteShader(cs);
+		}
+
+		return true;
+	}
+	void RenderEngine::m_cancelRecompiles()
+	{
+		for (AsyncRecompile* rc : m_recompiles)
+			rc->Cancelled = true;
+
+		// the worker skips the queued jobs - wait for the one it's running
+		{
+			std::unique_lock<std::mutex> lock(m_recompileMutex);
+			m_recompileDone.wait(lock, [&] {
+				for (AsyncRecompile* rc : m_recompiles)
+					if (!rc->Done)
+						return false;
+				return true;
+			});
+		}
+
+		for (AsyncRecompile* rc : m_recompiles)
+			delete rc;
+		m_recompiles.clear();
+		m_recompileGeneration.clear();
+	}
+	void RenderEngine::Pick(float sx, float sy, bool multiPick, std::function<void(PipelineItem*)> func)
+	{
+		m_pickAwaiting = true;
+		m_pickDist = std::numeric_limits<float>::infinity();
+		m_pickHandle = func;
+		m_wasMultiPick = multiPick;
+
+		float mouseX = sx / (m_lastSize.x * 0.5f) - 1.0f;
+		float mouseY = sy / (m_lastSize.y * 0.5f) - 1.0f;
+
+		glm::mat4 proj = SystemVariableManager::Instance().GetProjectionMatrix();
+		glm::mat4 view = SystemVariableManager::Instance().GetCamera()->GetMatrix();
+
+		glm::mat4 invVP = glm::inverse(proj * view);
+		glm::vec4 screenPos(mouseX, mouseY, 1.0f, 1.0f);
+		glm::vec4 worldPos = invVP * screenPos;
+
+		m_pickDir = glm::normalize(glm::vec3(worldPos));
+		m_pickOrigin = SystemVariableManager::Instance().GetCamera()->GetPosition();
+	}
+	void RenderEngine::Pick(PipelineItem* item, bool add)
+	{
+		// check if it already exists
+		bool skipAdd = false;
+		for (int i = 0; i < m_pick.size(); i++)
+			if (m_pick[i] == item) {
+				if (!add) {
+					m_pick.clear();
+					m_pick.push_back(item);
+				}
+				skipAdd = true;
+				break;
+			}
+
+		if (!skipAdd) {
+			if (item == nullptr)
+				m_pick.clear();
+			else if (add)
+				m_pick.push_back(item);
+			else {
+				m_pick.clear();
+				m_pick.push_back(item);
+			}
+		}
+	}
+	void RenderEngine::m_pickItem(PipelineItem* item, bool multiPick)
+	{
+		glm::mat4 world(1);
+		if (item->Type == PipelineItem::ItemType::Geometry) {
+			pipe::GeometryItem* geo = (pipe::GeometryItem*)item->Data;
+			if (geo->Type == pipe::GeometryItem::GeometryType::Rectangle || geo->Type == pipe::GeometryItem::GeometryType::ScreenQuadNDC)
+				return;
+
+			world = glm::translate(glm::mat4(1), geo->Position) * glm::yawPitchRoll(geo->Rotation.y, geo->Rotation.x, geo->Rotation.z);
+		} else if (item->Type == PipelineItem::ItemType::Model) {
+			pipe::Model* obj = (pipe::Model*)item->Data;
+
+			world = glm::translate(glm::mat4(1), obj->Position) * glm::scale(glm::mat4(1.0f), obj->Scale) * glm::yawPitchRoll(obj->Rotation.y, obj->Rotation.x, obj->Rotation.z);
+		} else if (item->Type == PipelineItem::ItemType::PluginItem) {
+			pipe::PluginItemData* pldata = (pipe::PluginItemData*)item->Data;
+
+			float plMat[16];
+			pldata->Owner->PipelineItem_GetWorldMatrix(pldata->Type, pldata->PluginData, plMat);
+			world = glm::make_mat4(plMat);
+		} else if (item->Type == PipelineItem::ItemType::VertexBuffer) {
+			pipe::VertexBuffer* obj = (pipe::VertexBuffer*)item->Data;
+
+			world = glm::translate(glm::mat4(1), obj->Position) * glm::scale(glm::mat4(1.0f), obj->Scale) * glm::yawPitchRoll(obj->Rotation.y, obj->Rotation.x, obj->Rotation.z);
+		}
+
+		glm::mat4 invWorld = glm::inverse(world);
+
+		glm::vec4 rayOrigin = invWorld * glm::vec4(m_pickOrigin, 1);
+		glm::vec4 rayDir = invWorld * glm::vec4(m_pickDir, 0.0f);
+
+		glm::vec3 vec3Origin = glm::vec3(rayOrigin);
+		glm::vec3 vec3Dir = glm::vec3(rayDir);
 
 		float myDist = std::numeric_limits<float>::infinity();
 		if (item->Type == PipelineItem::ItemType::Geometry) {
@@ -1578,45 +2313,41 @@ namespace ed {
 		} else if (item->Type == PipelineItem::ItemType::Model) {
 			pipe::Model* obj = (pipe::Model*)item->Data;
 
-			glm::vec3 minb = obj->Data->GetMinBound();
-			glm::vec3 maxb = obj->Data->GetMaxBound();
-
-			float triDist = std::numeric_limits<float>::infinity();
-			if (ray::IntersectBox(vec3Origin, vec3Dir, minb, maxb, triDist)) {
-				bool donetris = false;
-				for (auto& mesh : obj->Data->Meshes) {
-					for (int i = 0; i + 2 < mesh.Vertices.size(); i += 3) {
-						glm::vec3 v0 = mesh.Vertices[i + 0].Position;
-						glm::vec3 v1 = mesh.Vertices[i + 1].Position;
-						glm::vec3 v2 = mesh.Vertices[i + 2].Position;
-
-						if (ray::IntersectTriangle(vec3Origin, vec3Dir, v0, v1, v2, triDist))
-							if (triDist < myDist) {
-								myDist = triDist;
-
-								if (triDist < m_pickDist) {
-									donetris = true;
-									break;
-								}
-							}
-					}
-
-					if (donetris)
-						break;
-				}
-			}
+			// only hits closer than the currently picked item matter
+			float triDist;
+			if (obj->Data->Intersect(vec3Origin, vec3Dir, triDist, m_pickDist))
+				myDist = triDist;
 		} else if (item->Type == PipelineItem::ItemType::VertexBuffer) {
 			pipe::VertexBuffer* obj = (pipe::VertexBuffer*)item->Data;
 
-			glm::vec3 b1(0.0f);
-			glm::vec3 b2(0.0f);
-			gl::GetVertexBufferBounds(m_objects, obj, b1, b2);
+			BufferObject* bobj = (BufferObject*)obj->Buffer;
 
-			// TODO: use ray-triangle intersection for more precision
+			// buffers can be edited or written to by shaders - only read back & rebuild when the generation changed
+			bool hasBVH = obj->PickBVH.IsBuilt() && obj->PickBuffer == bobj && obj->PickGeneration == bobj->Generation;
+			if (!hasBVH && obj->Topology == GL_TRIANGLES) {
+				std::vector<glm::vec3> positions;
+				if (gl::GetVertexBufferPositions(m_objects, obj, positions))
+					obj->PickBVH.Build(positions, std::vector<unsigned int>());
+				else
+					obj->PickBVH.Clear();
+				obj->PickBuffer = bobj;
+				obj->PickGeneration = bobj != nullptr ? bobj->Generation : 0;
+				hasBVH = obj->PickBVH.IsBuilt();
+			}
 
-			float distHit;
-			if (ray::IntersectBox(vec3Origin, vec3Dir, b1, b2, distHit))
-				myDist = distHit;
+			if (hasBVH && obj->Topology == GL_TRIANGLES) {
+				float triDist;
+				if (obj->PickBVH.Intersect(vec3Origin, vec3Dir, triDist, m_pickDist))
+					myDist = triDist;
+			} else {
+				glm::vec3 b1(0.0f);
+				glm::vec3 b2(0.0f);
+				gl::GetVertexBufferBounds(m_objects, obj, b1, b2);
+
+				float distHit;
+				if (ray::IntersectBox(vec3Origin, vec3Dir, b1, b2, distHit))
+					myDist = distHit;
+			}
 		} else if (item->Type == PipelineItem::ItemType::PluginItem) {
 			pipe::PluginItemData* obj = (pipe::PluginItemData*)item->Data;
 
@@ -1702,15 +2433,17 @@ namespace ed {
 			glDeleteShader(m_shaderSources[i].PS);
 			glDeleteShader(m_shaderSources[i].GS);
 			glDeleteProgram(m_shaders[i]);
+			glDeleteProgram(m_shaderSources[i].PickProgram);
 		}
 
-		m_fbos.clear();
-		m_fboCount.clear();
+		m_cancelRecompiles();
+
+		m_fbos.clear(); // FBOs are kept, but all of their attachments get refreshed
+		m_rtSharingState.clear();
 		m_items.clear();
 		m_shaders.clear();
 		m_shaderSources.clear();
 		m_uboMax.clear();
-		m_fbosNeedUpdate = true;
 
 		// clear textures
 		glBindTexture(GL_TEXTURE_2D, m_rtColor);
@@ -1734,6 +2467,9 @@ namespace ed {
 				return;
 		}
 
+		// shader & compute passes that need to be compiled
+		std::vector<PipelineItem*> pendingItems;
+
 		// check if some item was added
 		for (int i = 0; i < items.size(); i++) {
 			bool found = false;
@@ -1746,6 +2482,8 @@ namespace ed {
 			if (!found) {
 				Logger::Get().Log("Caching a new shader pass " + std::string(items[i]->Name));
 
+				m_recompileGeneration.erase(items[i]); // the address might have belonged to a deleted item
+
 				if (items[i]->Type == PipelineItem::ItemType::ShaderPass) {
 					pipe::ShaderPass* data = reinterpret_cast<ed::pipe::ShaderPass*>(items[i]->Data);
 
@@ -1761,135 +2499,10 @@ namespace ed {
 						continue;
 					}
 
-					glDeleteShader(m_shaderSources[i].VS);
-					glDeleteShader(m_shaderSources[i].PS);
-					glDeleteShader(m_shaderSources[i].GS);
+					m_fbos[data] = FBOState();
 
-					/*
-						ITEM CACHING
-					*/
-
-					m_fbos[data].resize(MAX_RENDER_TEXTURES);
-
-					GLuint ps = 0, vs = 0, gs = 0;
-
-					m_msgs->CurrentItem = items[i]->Name;
-
-					int lineBias = 0;
-					std::string psContent = "", vsContent = "",
-								vsEntry = data->VSEntry,
-								psEntry = data->PSEntry;
-					ShaderLanguage vsLang = ShaderCompiler::GetShaderLanguageFromExtension(data->VSPath);
-					ShaderLanguage psLang = ShaderCompiler::GetShaderLanguageFromExtension(data->PSPath);
-
-					// vertex shader
-					bool vsCompiled = false;
-
-					if (vsLang == ShaderLanguage::Plugin)
-						vsCompiled = m_pluginCompileToSpirv(data->VSSPV, data->VSPath, vsEntry, plugin::ShaderStage::Vertex, data->Macros.data(), data->Macros.size());
-					else
-						vsCompiled = ShaderCompiler::CompileToSPIRV(data->VSSPV, vsLang, data->VSPath, ShaderStage::Vertex, vsEntry, data->Macros, m_msgs, m_project);
-					
-					// generate glsl
-					if (vsLang == ShaderLanguage::GLSL) { // GLSL
-						vsContent = m_project->LoadProjectFile(data->VSPath);
-						m_includeCheck(vsContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(vsContent, data);
-					} else if (vsCompiled) {
-						vsContent = ShaderCompiler::ConvertToGLSL(data->VSSPV, vsLang, ShaderStage::Vertex, data->GSUsed, m_msgs);
-						vsEntry = "main";
-
-						if (vsLang == ShaderLanguage::Plugin)
-							vsContent = std::string(m_pluginProcessGLSL(data->VSPath, vsContent.c_str()));
-					}
-
-					vs = gl::CompileShader(GL_VERTEX_SHADER, vsContent.c_str());
-					vsCompiled &= gl::CheckShaderCompilationStatus(vs);
-					
-					// pixel shader
-					lineBias = 0;
-					bool psCompiled = false;
-
-					if (psLang == ShaderLanguage::Plugin)
-						psCompiled = m_pluginCompileToSpirv(data->PSSPV, data->PSPath, psEntry, plugin::ShaderStage::Pixel, data->Macros.data(), data->Macros.size());
-					else
-						psCompiled = ShaderCompiler::CompileToSPIRV(data->PSSPV, psLang, data->PSPath, ShaderStage::Pixel, psEntry, data->Macros, m_msgs, m_project);
-					
-					if (psLang == ShaderLanguage::GLSL) { // GLSL
-						psContent = m_project->LoadProjectFile(data->PSPath);
-						m_includeCheck(psContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(psContent, data);
-					} else if (psCompiled) { // HLSL / VK
-						psContent = ShaderCompiler::ConvertToGLSL(data->PSSPV, psLang, ShaderStage::Pixel, data->GSUsed, m_msgs);
-						psEntry = "main";
-
-						if (psLang == ShaderLanguage::Plugin)
-							psContent = m_pluginProcessGLSL(data->PSPath, psContent.c_str());
-					}
-
-					data->Variables.UpdateTextureList(psContent);
-					ps = gl::CompileShader(GL_FRAGMENT_SHADER, psContent.c_str());
-					psCompiled &= gl::CheckShaderCompilationStatus(ps);
-					
-					// geometry shader
-					lineBias = 0;
-					bool gsCompiled = true;
-					if (data->GSUsed && strlen(data->GSEntry) > 0 && strlen(data->GSPath) > 0) {
-						std::string gsContent = "", gsEntry = data->GSEntry;
-						ShaderLanguage gsLang = ShaderCompiler::GetShaderLanguageFromExtension(data->PSPath);
-						
-						if (gsLang == ShaderLanguage::Plugin)
-							gsCompiled = m_pluginCompileToSpirv(data->GSSPV, data->GSPath, gsEntry, plugin::ShaderStage::Geometry, data->Macros.data(), data->Macros.size());
-						else
-							gsCompiled = ShaderCompiler::CompileToSPIRV(data->GSSPV, gsLang, data->GSPath, ShaderStage::Geometry, gsEntry, data->Macros, m_msgs, m_project);
-						
-						if (gsLang == ShaderLanguage::GLSL) { // GLSL
-							gsContent = m_project->LoadProjectFile(data->GSPath);
-							m_includeCheck(gsContent, std::vector<std::string>(), lineBias);
-							m_applyMacros(gsContent, data);
-						} else if (gsCompiled) { // HLSL
-							gsContent = ShaderCompiler::ConvertToGLSL(data->GSSPV, gsLang, ShaderStage::Geometry, data->GSUsed, m_msgs);
-							gsEntry = "main";
-
-							if (gsLang == ShaderLanguage::Plugin)
-								gsContent = m_pluginProcessGLSL(data->GSPath, gsContent.c_str());
-						}
-
-						gs = gl::CompileShader(GL_GEOMETRY_SHADER, gsContent.c_str());
-						gsCompiled &= gl::CheckShaderCompilationStatus(gs);
-					}
-
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
-
-					if (m_debugShaders[i] != 0)
-						glDeleteProgram(m_debugShaders[i]);
-
-					if (!vsCompiled || !psCompiled || !gsCompiled) {
-						m_msgs->Add(MessageStack::Type::Error, items[i]->Name, "Failed to compile the shader");
-						m_shaders[i] = 0;
-					} else {
-						m_msgs->ClearGroup(items[i]->Name);
-
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], vs);
-						glAttachShader(m_shaders[i], ps);
-						if (data->GSUsed) glAttachShader(m_shaders[i], gs);
-						glLinkProgram(m_shaders[i]);
-
-						m_debugShaders[i] = glCreateProgram();
-						glAttachShader(m_debugShaders[i], m_generalDebugShader);
-						glAttachShader(m_debugShaders[i], vs);
-						if (data->GSUsed) glAttachShader(m_debugShaders[i], gs);
-						glLinkProgram(m_debugShaders[i]);
-					}
-
-					if (m_shaders[i] != 0)
-						data->Variables.UpdateUniformInfo(m_shaders[i]);
-
-					m_shaderSources[i].VS = vs;
-					m_shaderSources[i].PS = ps;
-					m_shaderSources[i].GS = gs;
+					// compiled later, all at once
+					pendingItems.push_back(items[i]);
 				}
 				else if (items[i]->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 					pipe::ComputePass* data = reinterpret_cast<ed::pipe::ComputePass*>(items[i]->Data);
@@ -1906,61 +2519,8 @@ namespace ed {
 						continue;
 					}
 
-					/*
-						ITEM CACHING
-					*/
-
-					GLuint cs = 0;
-
-					m_msgs->CurrentItem = items[i]->Name;
-
-					std::string content = "", entry = data->Entry;
-					int lineBias = 0;
-					ShaderLanguage lang = ShaderCompiler::GetShaderLanguageFromExtension(data->Path);
-
-					// compute shader
-					bool compiled = false;
-
-					if (lang == ShaderLanguage::Plugin)
-						compiled = m_pluginCompileToSpirv(data->SPV, data->Path, entry, plugin::ShaderStage::Compute, data->Macros.data(), data->Macros.size());
-					else
-						compiled = ShaderCompiler::CompileToSPIRV(data->SPV, lang, data->Path, ShaderStage::Compute, entry, data->Macros, m_msgs, m_project);
-					
-					if (lang == ShaderLanguage::GLSL) { // GLSL
-						content = m_project->LoadProjectFile(data->Path);
-						m_includeCheck(content, std::vector<std::string>(), lineBias);
-						m_applyMacros(content, data);
-					} else if (compiled) { // HLSL / VK
-						content = ShaderCompiler::ConvertToGLSL(data->SPV, lang, ShaderStage::Compute, false, m_msgs);
-						entry = "main";
-
-						if (lang == ShaderLanguage::Plugin)
-							content = m_pluginProcessGLSL(data->Path, content.c_str());
-					}
-
-					cs = gl::CompileShader(GL_COMPUTE_SHADER, content.c_str());
-					compiled &= gl::CheckShaderCompilationStatus(cs);
-
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
-
-					if (!compiled) {
-						m_msgs->Add(MessageStack::Type::Error, items[i]->Name, "Failed to compile the compute shader");
-						m_shaders[i] = 0;
-					} else {
-						m_msgs->ClearGroup(items[i]->Name);
-
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], cs);
-						glLinkProgram(m_shaders[i]);
-					}
-
-					if (m_shaders[i] != 0)
-						data->Variables.UpdateUniformInfo(m_shaders[i]);
-
-					m_shaderSources[i].VS = 0;
-					m_shaderSources[i].PS = 0;
-					m_shaderSources[i].GS = 0;
+					// compiled later, all at once
+					pendingItems.push_back(items[i]);
 				} 
 				else if (items[i]->Type == PipelineItem::ItemType::AudioPass) {
 					pipe::AudioPass* data = reinterpret_cast<ed::pipe::AudioPass*>(items[i]->Data);
@@ -1980,6 +2540,7 @@ namespace ed {
 					// vertex shader
 					if (ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::GLSL)
 						m_applyMacros(content, data);
+					data->Stream.setFormat(data->SampleRate, data->BlockSize, data->Channels);
 					data->Stream.compileFromShaderSource(m_project, m_msgs, content, data->Macros, ShaderCompiler::GetShaderLanguageFromExtension(data->Path) == ShaderLanguage::HLSL);
 
 					data->Variables.UpdateUniformInfo(data->Stream.getShader());
@@ -2007,11 +2568,22 @@ namespace ed {
 			if (!found) {
 				glDeleteProgram(m_shaders[i]);
 				glDeleteProgram(m_debugShaders[i]);
+				glDeleteProgram(m_shaderSources[i].PickProgram);
 
 				Logger::Get().Log("Removing an item from cache");
 
-				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass)
-					m_fbos.erase((pipe::ShaderPass*)m_items[i]->Data);
+				m_forgetRecompiles(m_items[i]);
+
+				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
+					pipe::ShaderPass* data = (pipe::ShaderPass*)m_items[i]->Data;
+					m_fbos.erase(data);
+
+					auto fboMS = m_fboMS.find(data);
+					if (fboMS != m_fboMS.end()) {
+						glDeleteFramebuffers(1, &fboMS->second);
+						m_fboMS.erase(fboMS);
+					}
+				}
 
 				m_items.erase(m_items.begin() + i);
 				m_shaders.erase(m_shaders.begin() + i);
@@ -2050,6 +2622,228 @@ namespace ed {
 				}
 			}
 		}
+
+		// compile newly added items
+		if (!pendingItems.empty())
+			m_compileItems(pendingItems);
+	}
+	void RenderEngine::m_compileJob(CompileJob& job, const std::atomic<bool>* cancelled)
+	{
+		eng::Timer timer;
+
+		if (job.Source.empty())
+			job.Compiled = ShaderCompiler::CompileToSPIRV(*job.SPV, job.Language, job.Path, job.Stage, job.Entry, *job.Macros, &job.Messages, m_project);
+		else
+			job.Compiled = ShaderCompiler::CompileSourceToSPIRV(*job.SPV, job.Language, job.Path, job.Source, job.Stage, job.Entry, *job.Macros, &job.Messages, m_project);
+
+		// glslang can't be interrupted, but the conversion can be skipped
+		if (cancelled != nullptr && cancelled->load())
+			return;
+
+		if (job.Language != ShaderLanguage::GLSL && job.Compiled)
+			job.GLSL = ShaderCompiler::ConvertToGLSL(*job.SPV, job.Language, job.Stage, job.GSUsed, &job.Messages);
+
+		job.Time = timer.GetElapsedTime() * 1000.0f;
+	}
+	void RenderEngine::m_runCompileJobs(std::vector<CompileJob>& jobs)
+	{
+		// plugins might not be thread safe - compile their shaders on this thread
+		for (auto& job : jobs) {
+			if (job.Language != ShaderLanguage::Plugin)
+				continue;
+
+			eng::Timer timer;
+
+			job.Compiled = m_pluginCompileToSpirv(*job.SPV, job.Path, job.Entry, (plugin::ShaderStage)job.Stage, job.Macros->data(), job.Macros->size(), job.Source);
+			if (job.Compiled) {
+				job.GLSL = ShaderCompiler::ConvertToGLSL(*job.SPV, job.Language, job.Stage, job.GSUsed, &job.Messages);
+				job.GLSL = m_pluginProcessGLSL(job.Path.c_str(), job.GLSL.c_str());
+			}
+
+			job.Time = timer.GetElapsedTime() * 1000.0f;
+		}
+
+		// glslang & SPIRV-Cross only touch the CPU - run them on all cores
+		std::atomic<size_t> nextJob(0);
+		auto worker = [&]() {
+			size_t id = 0;
+			while ((id = nextJob++) < jobs.size()) {
+				CompileJob& job = jobs[id];
+				if (job.Language != ShaderLanguage::Plugin)
+					m_compileJob(job);
+			}
+		};
+
+		int threadCount = std::min<int>(std::max<int>(std::thread::hardware_concurrency(), 1), jobs.size());
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; i++)
+			threads.push_back(std::thread(worker));
+		worker();
+		for (auto& thread : threads)
+			thread.join();
+	}
+	void RenderEngine::m_compileItems(const std::vector<PipelineItem*>& pending)
+	{
+		eng::Timer totalTimer;
+
+		// create a job for each shader stage
+		std::vector<CompileJob> jobs;
+		std::vector<std::pair<PipelineItem*, int>> firstJob; // item -> index of the first job
+		for (PipelineItem* item : pending) {
+			firstJob.push_back(std::make_pair(item, (int)jobs.size()));
+			m_supersedeRecompiles(item);
+
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)item->Data;
+
+				jobs.push_back(CompileJob(item, ShaderStage::Vertex, data->VSPath, data->VSEntry, &data->Macros, &data->VSSPV, data->GSUsed));
+				jobs.push_back(CompileJob(item, ShaderStage::Pixel, data->PSPath, data->PSEntry, &data->Macros, &data->PSSPV, data->GSUsed));
+				if (data->GSUsed && strlen(data->GSEntry) > 0 && strlen(data->GSPath) > 0)
+					jobs.push_back(CompileJob(item, ShaderStage::Geometry, data->GSPath, data->GSEntry, &data->Macros, &data->GSSPV, data->GSUsed));
+			} else if (item->Type == PipelineItem::ItemType::ComputePass) {
+				pipe::ComputePass* data = (pipe::ComputePass*)item->Data;
+
+				jobs.push_back(CompileJob(item, ShaderStage::Compute, data->Path, data->Entry, &data->Macros, &data->SPV, false));
+			}
+		}
+
+		m_runCompileJobs(jobs);
+
+		float cpuTime = 0.0f;
+		for (const auto& job : jobs)
+			cpuTime += job.Time;
+
+		// create GL shaders & link the programs on the main thread
+		for (int p = 0; p < firstJob.size(); p++) {
+			PipelineItem* item = firstJob[p].first;
+			int jobStart = firstJob[p].second;
+			int jobEnd = (p + 1 < firstJob.size()) ? firstJob[p + 1].second : jobs.size();
+
+			int i = std::distance(m_items.begin(), std::find(m_items.begin(), m_items.end(), item));
+			if (i >= m_items.size())
+				continue; // removed in the meantime
+
+			m_msgs->CurrentItem = item->Name;
+
+			bool compiled = true;
+			std::string timings = "";
+			GLuint shaders[3] = { 0, 0, 0 }; // VS/PS/GS or CS
+			std::string vsCode;
+
+			for (int j = jobStart; j < jobEnd; j++) {
+				CompileJob& job = jobs[j];
+
+				m_msgs->Add(job.Messages.GetMessages());
+
+				eng::Timer glTimer;
+
+				// GLSL is passed to the driver directly
+				if (job.Language == ShaderLanguage::GLSL) {
+					int lineBias = 0;
+					job.GLSL = ShaderFileCache::Instance().Load(m_project->GetProjectPath(job.Path));
+					m_includeCheck(job.GLSL, std::vector<std::string>(), lineBias);
+					if (item->Type == PipelineItem::ItemType::ShaderPass)
+						m_applyMacros(job.GLSL, (pipe::ShaderPass*)item->Data);
+					else
+						m_applyMacros(job.GLSL, (pipe::ComputePass*)item->Data);
+				}
+
+				GLenum glType = GL_VERTEX_SHADER;
+				int slot = 0;
+				if (job.Stage == ShaderStage::Pixel) {
+					glType = GL_FRAGMENT_SHADER;
+					slot = 1;
+					((pipe::ShaderPass*)item->Data)->Variables.UpdateTextureList(job.GLSL);
+				} else if (job.Stage == ShaderStage::Geometry) {
+					glType = GL_GEOMETRY_SHADER;
+					slot = 2;
+				} else if (job.Stage == ShaderStage::Compute)
+					glType = GL_COMPUTE_SHADER;
+
+				if (job.Stage == ShaderStage::Vertex)
+					vsCode = job.GLSL;
+
+				shaders[slot] = gl::CompileShader(glType, job.GLSL.c_str());
+				job.Compiled &= gl::CheckShaderCompilationStatus(shaders[slot]);
+				compiled &= job.Compiled;
+
+				job.Time += glTimer.GetElapsedTime() * 1000.0f;
+
+				static const char* stageNames[] = { "VS", "PS", "GS", "CS" };
+				char timeStr[64];
+				snprintf(timeStr, 64, "%s%s %.2fms", timings.empty() ? "" : ", ", stageNames[(int)job.Stage], job.Time);
+				timings += timeStr;
+			}
+
+			if (m_shaders[i] != 0)
+				glDeleteProgram(m_shaders[i]);
+			if (m_debugShaders[i] != 0)
+				glDeleteProgram(m_debugShaders[i]);
+			m_shaders[i] = m_debugShaders[i] = 0;
+
+			eng::Timer linkTimer;
+
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)item->Data;
+
+				if (!compiled) {
+					m_msgs->Add(MessageStack::Type::Error, item->Name, "Failed to compile the shader");
+				} else {
+					m_msgs->ClearGroup(item->Name);
+
+					m_shaders[i] = glCreateProgram();
+					glAttachShader(m_shaders[i], shaders[0]);
+					glAttachShader(m_shaders[i], shaders[1]);
+					if (data->GSUsed) glAttachShader(m_shaders[i], shaders[2]);
+					glLinkProgram(m_shaders[i]);
+
+					m_debugShaders[i] = glCreateProgram();
+					glAttachShader(m_debugShaders[i], m_generalDebugShader);
+					glAttachShader(m_debugShaders[i], shaders[0]);
+					if (data->GSUsed) glAttachShader(m_debugShaders[i], shaders[2]);
+					glLinkProgram(m_debugShaders[i]);
+				}
+
+				m_shaderSources[i].VSCode = vsCode;
+				m_resetPickProgram(i);
+
+				if (m_shaders[i] != 0)
+					data->Variables.UpdateUniformInfo(m_shaders[i]);
+
+				m_shaderSources[i].VS = shaders[0];
+				m_shaderSources[i].PS = shaders[1];
+				m_shaderSources[i].GS = shaders[2];
+			} else {
+				pipe::ComputePass* data = (pipe::ComputePass*)item->Data;
+
+				if (!compiled) {
+					m_msgs->Add(MessageStack::Type::Error, item->Name, "Failed to compile the compute shader");
+				} else {
+					m_msgs->ClearGroup(item->Name);
+
+					m_shaders[i] = glCreateProgram();
+					glAttachShader(m_shaders[i], shaders[0]);
+					glLinkProgram(m_shaders[i]);
+				}
+
+				if (m_shaders[i] != 0)
+					data->Variables.UpdateUniformInfo(m_shaders[i]);
+
+				glDeleteShader(shaders[0]);
+
+				m_shaderSources[i].VS = 0;
+				m_shaderSources[i].PS = 0;
+				m_shaderSources[i].GS = 0;
+			}
+
+			if (compiled) {
+				char linkStr[32];
+				snprintf(linkStr, 32, ", link %.2fms", linkTimer.GetElapsedTime() * 1000.0f);
+				m_msgs->Add(MessageStack::Type::Message, item->Name, "Compile times: " + timings + linkStr);
+			}
+		}
+
+		Logger::Get().Log("Compiled " + std::to_string(jobs.size()) + " shader stages in " + std::to_string(totalTimer.GetElapsedTime() * 1000.0f) + "ms (" + std::to_string(cpuTime) + "ms of total compile time)");
 	}
 	void RenderEngine::m_applyMacros(std::string& src, pipe::ShaderPass* pass)
 	{
@@ -2192,7 +2986,7 @@ namespace ed {
 				if (m_project->FileExists(ipath) && std::count(includeStack.begin(), includeStack.end(), ipath) == 0) {
 					includeStack.push_back(ipath);
 
-					std::string incFileSrc = m_project->LoadProjectFile(ipath);
+					std::string incFileSrc = ShaderFileCache::Instance().Load(m_project->GetProjectPath(ipath));
 					lineBias = std::count(incFileSrc.begin(), incFileSrc.end(), '\n');
 
 					m_includeCheck(incFileSrc, includeStack, lineBias);
@@ -2208,68 +3002,259 @@ namespace ed {
 	}
 	void RenderEngine::m_updatePassFBO(ed::pipe::ShaderPass* pass)
 	{
-		bool changed = false;
+		GLuint lastID = pass->RenderTextures[pass->RTCount - 1];
+		GLuint depthID = m_rtDepth, depthMSID = m_rtDepthMS;
+		if (lastID != m_rtColor) {
+			// the logical depth texture decides when the depth gets cleared, the owner's one is attached
+			pass->DepthTexture = m_objects->GetRenderTexture(lastID)->DepthStencilBuffer;
+
+			auto owner = m_rtDepthOwner.find(lastID);
+			RenderTextureObject* depthObj = m_objects->GetRenderTexture(owner == m_rtDepthOwner.end() ? lastID : owner->second);
+			depthID = depthObj->DepthStencilBuffer;
+			depthMSID = depthObj->DepthStencilBufferMS;
+		} else
+			pass->DepthTexture = m_rtDepth;
 
+		GLuint colorIDs[MAX_RENDER_TEXTURES] = { 0 };
 		for (int i = 0; i < pass->RTCount; i++)
-			if (pass->RenderTextures[i] != m_fbos[pass][i]) {
-				changed = true;
-				break;
-			}
-		for (int i = 0; i < pass->RTCount; i++)
-			m_fbos[pass][i] = pass->RenderTextures[i];
-
-		changed = changed || m_fboCount[pass] != pass->RTCount;
-		m_fboCount[pass] = pass->RTCount;
+			colorIDs[i] = m_getColorOwner(pass->RenderTextures[i]);
 
-		if (!changed && !m_fbosNeedUpdate)
+		// render textures are resized in place so the FBOs only have to change when the pass' attachments do
+		FBOState& state = m_fbos[pass];
+		if (pass->FBO != 0 && state.Count == pass->RTCount && state.Depth == depthID && memcmp(state.Color, colorIDs, sizeof(colorIDs)) == 0)
 			return;
 
-		GLuint lastID = pass->RenderTextures[pass->RTCount - 1];
-		GLuint depthID = lastID == m_rtColor ? m_rtDepth : m_objects->GetRenderTexture(lastID)->DepthStencilBuffer;
-		GLuint depthMSID = lastID == m_rtColor ? m_rtDepthMS : m_objects->GetRenderTexture(lastID)->DepthStencilBufferMS;
-
-		pass->DepthTexture = depthID;
+		GLuint& fboMS = m_fboMS[pass];
+		if (pass->FBO == 0)
+			glGenFramebuffers(1, &pass->FBO);
+		if (fboMS == 0)
+			glGenFramebuffers(1, &fboMS);
 
-		if (pass->FBO != 0) {
-			glDeleteFramebuffers(1, &pass->FBO);
-			glDeleteFramebuffers(1, &m_fboMS[pass]);
-		}
+		// Count == -1 -> we don't know what's attached, touch every slot
+		bool unknown = state.Count == -1;
 
 		// normal FBO
-		glGenFramebuffers(1, &pass->FBO);
-		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)pass->FBO);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthID, 0);
-		for (int i = 0; i < pass->RTCount; i++) {
-			GLuint texID = pass->RenderTextures[i];
-
-			if (texID == 0) continue;
-
-			// attach
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, texID, 0);
-		}
-		GLenum retval = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, pass->FBO);
+		if (unknown || state.Depth != depthID)
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthID, 0);
+		for (int i = 0; i < MAX_RENDER_TEXTURES; i++)
+			if (unknown || state.Color[i] != colorIDs[i])
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorIDs[i], 0);
 
 		// MSAA fbo
-		glGenFramebuffers(1, &m_fboMS[pass]);
-		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_fboMS[pass]);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D_MULTISAMPLE, depthMSID, 0);
-		for (int i = 0; i < pass->RTCount; i++) {
-			GLuint texID = pass->RenderTextures[i];
-
-			if (texID == 0) continue;
+		glBindFramebuffer(GL_FRAMEBUFFER, fboMS);
+		if (unknown || state.Depth != depthID)
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D_MULTISAMPLE, depthMSID, 0);
+		for (int i = 0; i < MAX_RENDER_TEXTURES; i++) {
+			GLuint texID = colorIDs[i];
+			if (!unknown && state.Color[i] == texID)
+				continue;
 
 			if (texID == m_rtColor)
 				texID = m_rtColorMS;
-			else
+			else if (texID != 0)
 				texID = m_objects->GetRenderTexture(texID)->BufferMS;
 
-			// attach
 			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D_MULTISAMPLE, texID, 0);
 		}
-		retval = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-		m_fbosNeedUpdate = false;
+		memcpy(state.Color, colorIDs, sizeof(colorIDs));
+		state.Depth = depthID;
+		state.Count = pass->RTCount;
+	}
+	void RenderEngine::FlushVisibleRTs()
+	{
+		m_rtVisible.swap(m_rtVisibleNext);
+		m_rtVisibleNext.clear();
+
+		std::sort(m_rtVisible.begin(), m_rtVisible.end());
+		m_rtVisible.erase(std::unique(m_rtVisible.begin(), m_rtVisible.end()), m_rtVisible.end());
+	}
+	void RenderEngine::m_updateRTSharing()
+	{
+		const std::vector<ObjectManagerItem*>& objs = m_objects->GetItemDataList();
+
+		// the debugger & the plugins read the render textures directly - they need their own contents (previews are handled through m_rtVisible)
+		bool enabled = Settings::Instance().Preview.ShareRTMemory && !m_paused && !m_debug->IsDebugging() && m_plugins->Plugins().empty();
+
+		std::vector<GLuint> state;
+		if (enabled) {
+			for (int i = 0; i < m_items.size(); i++) {
+				PipelineItem* it = m_items[i];
+				state.push_back((GLuint)it->Type);
+				state.push_back(m_shaders[i]);
+
+				if (it->Type == PipelineItem::ItemType::ShaderPass) {
+					pipe::ShaderPass* data = (pipe::ShaderPass*)it->Data;
+					state.push_back(data->Active && data->Items.size() > 0);
+					state.insert(state.end(), data->RenderTextures, data->RenderTextures + data->RTCount);
+				} else if (it->Type == PipelineItem::ItemType::PluginItem)
+					enabled = false;
+
+				const std::vector<GLuint>& srvs = m_objects->GetBindList(it);
+				state.push_back(srvs.size());
+				state.insert(state.end(), srvs.begin(), srvs.end());
+			}
+			for (ObjectManagerItem* obj : objs) {
+				if (obj->RT == nullptr)
+					continue;
+
+				glm::ivec2 size = obj->RT->CalculateSize(m_lastSize.x, m_lastSize.y);
+				state.push_back(obj->Texture);
+				state.push_back(obj->RT->Format);
+				state.push_back(obj->RT->Clear);
+				state.push_back(size.x);
+				state.push_back(size.y);
+			}
+			state.push_back(m_rtVisible.size());
+			state.insert(state.end(), m_rtVisible.begin(), m_rtVisible.end());
+		}
+		state.push_back(enabled);
+		state.push_back(Settings::Instance().Preview.MSAA);
+
+		if (state == m_rtSharingState)
+			return;
+		m_rtSharingState = state;
+
+		m_rtColorOwner.clear();
+		m_rtDepthOwner.clear();
+
+		std::unordered_map<GLuint, bool> depthShared;
+		if (enabled) {
+			// lifetime of each render texture's contents: [first pass that writes to it, last pass that uses it]
+			struct Lifetime {
+				Lifetime() { First = Last = -1; Pinned = false; }
+				int First, Last;
+				bool Pinned; // read before it's written to (previous frame's contents) or used by a non-shader pass
+			};
+			std::unordered_map<GLuint, Lifetime> life;
+			std::vector<GLuint> depthUsers;
+
+			for (int i = 0; i < m_items.size(); i++) {
+				PipelineItem* it = m_items[i];
+				const std::vector<GLuint>& srvs = m_objects->GetBindList(it);
+
+				if (it->Type == PipelineItem::ItemType::ShaderPass) {
+					pipe::ShaderPass* data = (pipe::ShaderPass*)it->Data;
+					if (!data->Active || data->Items.size() <= 0 || data->RTCount == 0 || m_shaders[i] == 0)
+						continue;
+
+					for (GLuint srv : srvs) {
+						if (m_objects->GetRenderTexture(srv) == nullptr)
+							continue;
+
+						Lifetime& l = life[srv];
+						if (l.First == -1)
+							l.Pinned = true;
+						l.Last = i;
+					}
+					for (int j = 0; j < data->RTCount; j++) {
+						GLuint rt = data->RenderTextures[j];
+						if (rt == m_rtColor)
+							continue;
+
+						Lifetime& l = life[rt];
+						if (l.First == -1)
+							l.First = i;
+						l.Last = i;
+					}
+
+					GLuint lastRT = data->RenderTextures[data->RTCount - 1];
+					if (lastRT != m_rtColor && std::count(depthUsers.begin(), depthUsers.end(), lastRT) == 0)
+						depthUsers.push_back(lastRT);
+				} else {
+					for (GLuint srv : srvs)
+						if (m_objects->GetRenderTexture(srv) != nullptr)
+							life[srv].Pinned = true;
+				}
+			}
+
+			// textures shown in the UI would only show garbage while their memory is shared
+			for (GLuint rt : m_rtVisible) {
+				auto l = life.find(rt);
+				if (l != life.end())
+					l->second.Pinned = true;
+			}
+
+			// candidates are handed out to the first compatible texture that isn't in use anymore, in the order they are written to
+			std::vector<std::pair<int, GLuint>> candidates;
+			for (const auto& l : life) {
+				RenderTextureObject* rtObj = m_objects->GetRenderTexture(l.first);
+				if (!l.second.Pinned && l.second.First != -1 && rtObj->Clear)
+					candidates.push_back(std::make_pair(l.second.First, l.first));
+			}
+			std::sort(candidates.begin(), candidates.end());
+
+			struct Slot {
+				GLuint Owner;
+				glm::ivec2 Size;
+				GLuint Format;
+				int Last;
+			};
+			std::vector<Slot> slots;
+			for (const auto& cand : candidates) {
+				RenderTextureObject* rtObj = m_objects->GetRenderTexture(cand.second);
+				const Lifetime& l = life[cand.second];
+				glm::ivec2 size = rtObj->CalculateSize(m_lastSize.x, m_lastSize.y);
+
+				Slot* slot = nullptr;
+				for (Slot& s : slots)
+					if (s.Size == size && s.Format == rtObj->Format && s.Last < l.First) {
+						slot = &s;
+						break;
+					}
+
+				if (slot == nullptr) {
+					Slot newSlot;
+					newSlot.Owner = cand.second;
+					newSlot.Size = size;
+					newSlot.Format = rtObj->Format;
+					newSlot.Last = l.Last;
+					slots.push_back(newSlot);
+				} else {
+					m_rtColorOwner[cand.second] = slot->Owner;
+					slot->Last = l.Last;
+				}
+			}
+
+			// depth never outlives a pass (or a run of passes that render to the same texture) so every
+			// render texture of the same size can use one depth texture - and the ones that aren't rendered to with depth don't need one
+			for (ObjectManagerItem* obj : objs)
+				if (obj->RT != nullptr)
+					depthShared[obj->Texture] = true;
+			std::vector<GLuint> depthOwners;
+			for (GLuint rt : depthUsers) {
+				glm::ivec2 size = m_objects->GetRenderTexture(rt)->CalculateSize(m_lastSize.x, m_lastSize.y);
+
+				GLuint owner = 0;
+				for (GLuint o : depthOwners)
+					if (m_objects->GetRenderTexture(o)->CalculateSize(m_lastSize.x, m_lastSize.y) == size) {
+						owner = o;
+						break;
+					}
+
+				if (owner == 0) {
+					depthOwners.push_back(rt);
+					depthShared[rt] = false;
+				} else
+					m_rtDepthOwner[rt] = owner;
+			}
+		}
+
+		for (ObjectManagerItem* obj : objs) {
+			if (obj->RT == nullptr)
+				continue;
+
+			obj->RT->ColorShared = m_rtColorOwner.count(obj->Texture) > 0;
+			obj->RT->DepthShared = depthShared[obj->Texture];
+			m_objects->ResizeRenderTexture(obj->RT->Name, obj->RT->CalculateSize(m_lastSize.x, m_lastSize.y));
+		}
+
+		if (enabled) {
+			size_t allocated = 0, unshared = 0;
+			m_objects->GetRenderTextureMemory(allocated, unshared);
+			Logger::Get().Log("Render textures share memory - " + std::to_string(allocated / (1024 * 1024)) + " MB instead of " + std::to_string(unshared / (1024 * 1024)) + " MB");
+		}
 	}
 }
\ No newline at end of file
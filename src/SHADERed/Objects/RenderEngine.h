@@ -5,8 +5,14 @@
 #include <SHADERed/Objects/PipelineManager.h>
 #include <SHADERed/Objects/PluginManager.h>
 #include <SHADERed/Objects/ProjectParser.h>
+#include <SHADERed/Objects/ShaderCompiler.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include <glm/glm.hpp>
@@ -31,11 +37,22 @@ namespace ed {
 		int DebugVertexPick(PipelineItem* pass, PipelineItem* item, glm::vec2 r, int group);
 		int DebugInstancePick(PipelineItem* pass, PipelineItem* item, glm::vec2 r, int group);
 
+		// vertex & instance ID in one render + one readback, returns false if the pass can't do it (plugins, geometry shaders)
+		bool DebugPick(PipelineItem* pass, PipelineItem* item, glm::vec2 r, int& vertexID, int& instanceID);
+
 		void Render(int width, int height, bool isDebug = false, PipelineItem* breakItem = nullptr);
 		inline void Render(bool isDebug = false, PipelineItem* breakItem = nullptr) { Render(m_lastSize.x, m_lastSize.y, isDebug, breakItem); }
 		void Recompile(const char* name);
 		void RecompileFile(const char* fname);
+		void Recompile(const std::vector<PipelineItem*>& items); // shader & compute passes are compiled in parallel
 		void RecompileFromSource(const char* name, const std::string& vs = "", const std::string& ps = "", const std::string& gs = "");
+
+		// same as RecompileFromSource() but glslang & SPIRV-Cross run on a background thread (with a copy of the source) - a newer
+		// request for the same shader stage or a synchronous recompile of the item supersedes the pending ones
+		// UpdateRecompiles() creates the GL shaders once they're done
+		void RecompileFromSourceAsync(const char* name, const std::string& vs = "", const std::string& ps = "", const std::string& gs = "");
+		void UpdateRecompiles();
+		inline bool IsRecompiling() { return !m_recompiles.empty(); }
 		void Pick(float sx, float sy, bool multiPick, std::function<void(PipelineItem*)> func = nullptr);
 		void Pick(PipelineItem* item, bool add = false);
 		inline bool IsPicked(PipelineItem* item) { return std::count(m_pick.begin(), m_pick.end(), item); }
@@ -52,9 +69,21 @@ namespace ed {
 		inline GLuint GetDepthTexture() { return m_rtDepth; }
 		inline glm::ivec2 GetLastRenderSize() { return m_lastSize; }
 
+		// glUniform* calls issued by the last (non-debug) frame
+		inline unsigned int GetUniformCallCount() { return m_uniformCallCount; }
+
 		inline bool IsPaused() { return m_paused; }
+		inline bool IsSharingRTMemory() { return !m_rtColorOwner.empty() || !m_rtDepthOwner.empty(); }
+
+		// the UI marks the render textures it shows (previews, thumbnails) every frame - those keep their own contents when
+		// sharing RT memory. FlushVisibleRTs() is called once per UI frame & makes the last frame's marks the visible set
+		inline void MarkRTVisible(GLuint rt) { m_rtVisibleNext.push_back(rt); }
+		void FlushVisibleRTs();
 		void Pause(bool pause);
 
+		// render [0, length] seconds of an audio pass to a file, offline & faster than real time
+		bool BounceAudio(PipelineItem* item, const std::string& path, float length);
+
 		// list of items waiting to be parsed
 		std::vector<PipelineItem*> SPIRVQueue;
 
@@ -110,7 +139,6 @@ namespace ed {
 		/* 'window' FBO */
 		glm::ivec2 m_lastSize;
 		GLuint m_rtColor, m_rtDepth, m_rtColorMS, m_rtDepthMS;
-		bool m_fbosNeedUpdate;
 
 		// check for the #include's & change the source code accordingly (includeStack == prevent recursion)
 		void m_includeCheck(std::string& src, std::vector<std::string> includeStack, int& lineBias);
@@ -120,6 +148,9 @@ namespace ed {
 		void m_applyMacros(std::string& source, pipe::ComputePass* pass);
 		void m_applyMacros(std::string& source, pipe::AudioPass* pass); // TODO: merge this function with the ones above
 
+		// bind the textures, buffers & variables of the audio pass at m_items[index]
+		void m_bindAudioPass(int index);
+
 		// compile to spirv - plugin edition
 		bool m_pluginCompileToSpirv(std::vector<GLuint>& spv, const std::string& path, const std::string& entry, plugin::ShaderStage stage, ed::ShaderMacro* macros, size_t macroCount, const std::string& actualSrc = "");
 		const char* m_pluginProcessGLSL(const char* path, const char* src);
@@ -132,29 +163,132 @@ namespace ed {
 		glm::vec3 m_pickDir;
 		std::vector<PipelineItem*> m_pick;
 		bool m_wasMultiPick;
+		unsigned int m_uniformCallCount;
 		void m_pickItem(PipelineItem* item, bool multiPick);
 
 		// cache
 		std::vector<PipelineItem*> m_items;
 		std::vector<GLuint> m_shaders;
 		std::vector<GLuint> m_debugShaders;
-		std::unordered_map<pipe::ShaderPass*, std::vector<GLuint>> m_fbos;
+		struct FBOState {
+			FBOState() { memset(Color, 0, sizeof(Color)); Depth = 0; Count = -1; }
+			GLuint Color[MAX_RENDER_TEXTURES]; // what is attached to the pass' FBOs right now
+			GLuint Depth;
+			int Count; // -1 if unknown
+		};
+		std::unordered_map<pipe::ShaderPass*, FBOState> m_fbos;
 		std::unordered_map<pipe::ShaderPass*, GLuint> m_fboMS; // multisampled fbo's
-		std::unordered_map<pipe::ShaderPass*, GLuint> m_fboCount;
 		std::unordered_map<pipe::ComputePass*, int> m_uboMax;
 		struct ShaderPack {
-			ShaderPack() { VS = GS = PS = 0; }
+			ShaderPack() { VS = GS = PS = PickProgram = 0; }
 			GLuint VS, PS, GS;
+
+			std::string VSCode; // GLSL of VS
+			std::string PickVS;	// VS that also outputs gl_InstanceID, linked on the first DebugPick
+			GLuint PickProgram;
 		};
 		std::vector<ShaderPack> m_shaderSources;
 
 		GLuint m_generalDebugShader;
 
+		// DebugPick
+		GLuint m_pickPixelShader;
+		GLuint m_pickFBO, m_pickColor, m_pickDepth;
+		glm::ivec2 m_pickSize;
+		GLuint m_getPickProgram(int passID);
+		void m_resetPickProgram(int passID); // has to be called by every path that relinks a shader pass
+		void m_updatePickTarget(const glm::ivec2& size);
+
 		void m_updatePassFBO(ed::pipe::ShaderPass* pass);
 
+		// render textures whose contents don't have to live at the same time use one texture for rendering (Preview.ShareRTMemory)
+		// the others get shrunk to 1x1 - the maps go from the render texture to the texture that actually holds its contents
+		void m_updateRTSharing();
+		std::vector<GLuint> m_rtSharingState; // pipeline usage from the last update, the lifetimes are only recomputed when it changes
+		std::vector<GLuint> m_rtVisible, m_rtVisibleNext;
+		std::unordered_map<GLuint, GLuint> m_rtColorOwner, m_rtDepthOwner;
+		inline GLuint m_getColorOwner(GLuint rt)
+		{
+			auto it = m_rtColorOwner.find(rt);
+			return it == m_rtColorOwner.end() ? rt : it->second;
+		}
+
 		std::vector<ItemVariableValue> m_itemValues; // list of all values to apply once we start rendering
 
 		eng::Timer m_cacheTimer;
 		void m_cache();
+
+		// a single shader stage that needs to be compiled - the CPU heavy part (glslang + SPIRV-Cross) runs on worker threads
+		struct CompileJob {
+			CompileJob(PipelineItem* item, ShaderStage stage, const std::string& path, const std::string& entry, std::vector<ShaderMacro>* macros, std::vector<unsigned int>* spv, bool gsUsed)
+					: Item(item)
+					, Stage(stage)
+					, Path(path)
+					, Entry(entry)
+					, Macros(macros)
+					, SPV(spv)
+					, GSUsed(gsUsed)
+					, Compiled(false)
+					, Time(0.0f)
+			{
+				Language = ShaderCompiler::GetShaderLanguageFromExtension(path);
+				Messages.CurrentItem = item->Name;
+			}
+
+			PipelineItem* Item;
+			ShaderStage Stage;
+			ShaderLanguage Language;
+			std::string Path, Entry;
+			std::vector<ShaderMacro>* Macros;
+			std::vector<unsigned int>* SPV;
+			bool GSUsed;
+			std::string Source; // compile this instead of the file's contents if it isn't empty
+
+			bool Compiled;
+			std::string GLSL;
+			MessageStack Messages; // merged with m_msgs on the main thread
+			float Time;			   // in milliseconds
+		};
+		void m_compileJob(CompileJob& job, const std::atomic<bool>* cancelled = nullptr); // thread safe, except for plugin languages
+		void m_runCompileJobs(std::vector<CompileJob>& jobs);
+
+		// RecompileFromSourceAsync() - one per shader stage, the job points to the copies of the macros & to its own SPIR-V
+		struct AsyncRecompile {
+			AsyncRecompile(PipelineItem* item, ShaderStage stage, const std::string& path, const std::string& entry, const std::string& source, const std::vector<ShaderMacro>& macros, bool gsUsed, unsigned int generation)
+					: Macros(macros)
+					, Job(item, stage, path, entry, &Macros, &SPV, gsUsed)
+					, Generation(generation)
+					, Cancelled(false)
+					, Done(false)
+			{
+				Job.Source = source;
+			}
+
+			std::vector<ShaderMacro> Macros;
+			std::vector<unsigned int> SPV;
+			CompileJob Job;
+			unsigned int Generation; // m_recompileGeneration of the item when the job was created
+			std::atomic<bool> Cancelled, Done;
+		};
+		std::vector<AsyncRecompile*> m_recompiles; // main thread - queued, running & finished jobs
+
+		// a single worker compiles the queued jobs in order, cancelled ones are skipped
+		std::thread m_recompileThread;
+		std::deque<AsyncRecompile*> m_recompileQueue;
+		std::mutex m_recompileMutex;
+		std::condition_variable m_recompileWork, m_recompileDone;
+		bool m_recompileExit;
+		void m_recompileWorker();
+
+		// bumped by every synchronous compile of the item - older async results are dropped
+		// entries are erased when the item is removed from the cache, so a reused address starts from scratch
+		std::unordered_map<PipelineItem*, unsigned int> m_recompileGeneration;
+		void m_supersedeRecompiles(PipelineItem* item);
+		void m_forgetRecompiles(PipelineItem* item);
+
+		void m_startRecompile(PipelineItem* item, ShaderStage stage, const std::string& path, const std::string& entry, const std::string& source, std::vector<ShaderMacro>& macros, bool gsUsed);
+		bool m_applyRecompile(const std::vector<AsyncRecompile*>& batch); // main thread, every finished stage of one item - false if the item is gone
+		void m_cancelRecompiles();
+		void m_compileItems(const std::vector<PipelineItem*>& items);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include <SHADERed/Objects/Logger.h>
+#include <SHADERed/Objects/SPIRVCache.h>
+#include <SHADERed/Objects/Settings.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define SPIRV_CACHE_FORMAT_VERSION 2
+#define SPIRV_CACHE_MAX_SIZE (64 * 1024 * 1024) // bytes - pruned down to 3/4 of this once it's exceeded
+#define SPIRV_CACHE_PRUNE_INTERVAL 32			 // check the size on the first Store() & then every N stores
+#define SPIRV_MAGIC_NUMBER 0x07230203
+
+namespace ed {
+	// 64bit FNV-1a
+	static inline void hashData(uint64_t& hash, const void* data, size_t len)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < len; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+	static inline void hashString(uint64_t& hash, const std::string& str)
+	{
+		uint64_t len = str.size();
+		hashData(hash, &len, sizeof(len)); // so that "ab"+"c" != "a"+"bc"
+		hashData(hash, str.data(), str.size());
+	}
+
+	SPIRVCache::SPIRVCache()
+	{
+		m_hits = 0;
+		m_misses = 0;
+		m_storeCount = 0;
+	}
+	uint64_t SPIRVCache::Hash(const std::string& src, ShaderLanguage lang, ShaderStage stage, const std::string& entry, const std::vector<ShaderMacro>& macros, const std::string& options)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+
+		int header[4] = { SPIRV_CACHE_FORMAT_VERSION, SHADERED_VERSION, (int)lang, (int)stage };
+		hashData(hash, header, sizeof(header));
+
+		hashString(hash, entry);
+		hashString(hash, options);
+
+		for (const auto& macro : macros) {
+			if (!macro.Active)
+				continue;
+			hashString(hash, macro.Name);
+			hashString(hash, macro.Value);
+		}
+
+		hashString(hash, src);
+
+		return hash;
+	}
+	std::string SPIRVCache::GetDirectory()
+	{
+		std::string dir = "cache/spirv/";
+		if (!Settings::Instance().LinuxHomeDirectory.empty())
+			dir = Settings::Instance().LinuxHomeDirectory + dir;
+		return dir;
+	}
+	std::string SPIRVCache::m_getPath(uint64_t key)
+	{
+		char name[32] = { 0 };
+		snprintf(name, 32, "%016llx.spv", (unsigned long long)key);
+		return GetDirectory() + name;
+	}
+	bool SPIRVCache::Load(uint64_t key, std::vector<unsigned int>& spvOut)
+	{
+		std::string path = m_getPath(key);
+
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			m_misses++;
+			return false;
+		}
+
+		size_t len = file.tellg();
+		file.seekg(0, std::ios::beg);
+
+		// corrupted or truncated entry
+		if (len == 0 || len % sizeof(unsigned int) != 0) {
+			file.close();
+			m_misses++;
+			return false;
+		}
+
+		spvOut.resize(len / sizeof(unsigned int));
+		file.read((char*)spvOut.data(), len);
+		bool valid = !file.fail() && spvOut[0] == SPIRV_MAGIC_NUMBER;
+		file.close();
+
+		if (!valid) {
+			spvOut.clear();
+			m_misses++;
+			return false;
+		}
+
+		// entries that are used get a new timestamp - pruning removes the least recently used ones
+		std::error_code ec;
+		std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+		m_hits++;
+		return true;
+	}
+	void SPIRVCache::Store(uint64_t key, const std::vector<unsigned int>& spv)
+	{
+		if (spv.empty())
+			return;
+
+		std::string path = m_getPath(key);
+
+		// write to a temporary file first and then rename it so that other instances
+		// (or other threads) never see a half-written entry - the name is unique per process & thread
+		std::string tempPath = path + "." + std::to_string(getpid()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+		std::error_code ec;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			std::filesystem::create_directories(GetDirectory(), ec);
+		}
+		if (ec) {
+			Logger::Get().Log("Failed to create the SPIR-V cache directory", true);
+			return;
+		}
+
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return;
+		file.write((const char*)spv.data(), spv.size() * sizeof(unsigned int));
+		bool written = !file.fail();
+		file.close();
+
+		if (written)
+			std::filesystem::rename(tempPath, path, ec);
+
+		if (!written || ec)
+			std::filesystem::remove(tempPath, ec);
+
+		if (m_storeCount++ % SPIRV_CACHE_PRUNE_INTERVAL == 0)
+			m_prune();
+	}
+	void SPIRVCache::m_prune()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		struct Entry {
+			std::filesystem::path Path;
+			std::filesystem::file_time_type Time;
+			uintmax_t Size;
+		};
+		std::vector<Entry> entries;
+		uintmax_t total = 0;
+
+		auto now = std::filesystem::file_time_type::clock::now();
+
+		std::error_code ec;
+		for (const auto& file : std::filesystem::directory_iterator(GetDirectory(), ec)) {
+			std::error_code fileEc;
+			if (!file.is_regular_file(fileEc))
+				continue;
+
+			Entry entry;
+			entry.Path = file.path();
+			entry.Time = file.last_write_time(fileEc);
+			entry.Size = file.file_size(fileEc);
+			if (fileEc)
+				continue;
+
+			// left behind by an instance that crashed while writing
+			if (entry.Path.extension() == ".tmp") {
+				if (now - entry.Time > std::chrono::hours(1))
+					std::filesystem::remove(entry.Path, fileEc);
+				continue;
+			}
+
+			total += entry.Size;
+			entries.push_back(entry);
+		}
+
+		if (total <= SPIRV_CACHE_MAX_SIZE)
+			return;
+
+		// oldest first
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.Time < b.Time; });
+
+		size_t removed = 0;
+		for (const Entry& entry : entries) {
+			if (total <= SPIRV_CACHE_MAX_SIZE / 4 * 3)
+				break;
+
+			std::error_code fileEc;
+			if (std::filesystem::remove(entry.Path, fileEc)) {
+				total -= entry.Size;
+				removed++;
+			}
+		}
+
+		Logger::Get().Log("Removed " + std::to_string(removed) + " old entries from the SPIR-V cache");
+	}
+	void SPIRVCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::error_code ec;
+		std::filesystem::remove_all(GetDirectory(), ec);
+
+		ResetCounters();
+
+		Logger::Get().Log("Cleared the SPIR-V cache");
+	}
+}
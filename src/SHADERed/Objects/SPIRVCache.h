@@ -0,0 +1,46 @@
+#pragma once
+#include <SHADERed/Objects/ShaderLanguage.h>
+#include <SHADERed/Objects/ShaderMacro.h>
+#include <SHADERed/Objects/ShaderStage.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ed {
+	// on-disk cache of compiled SPIR-V binaries - key is a hash of the preprocessed source, macros, stage, language,
+	// entry & compiler options so it can be shared between projects. The least recently used entries are
+	// removed once the directory grows over SPIRV_CACHE_MAX_SIZE
+	class SPIRVCache {
+	public:
+		SPIRVCache();
+
+		static inline SPIRVCache& Instance()
+		{
+			static SPIRVCache ret;
+			return ret;
+		}
+
+		// options = glslang version & every setting that changes the generated SPIR-V
+		static uint64_t Hash(const std::string& processedSource, ShaderLanguage lang, ShaderStage stage, const std::string& entry, const std::vector<ShaderMacro>& macros, const std::string& options);
+
+		bool Load(uint64_t key, std::vector<unsigned int>& spvOut);
+		void Store(uint64_t key, const std::vector<unsigned int>& spv);
+		void Clear();
+
+		std::string GetDirectory();
+
+		inline unsigned int GetHitCount() { return m_hits; }
+		inline unsigned int GetMissCount() { return m_misses; }
+		inline void ResetCounters() { m_hits = m_misses = 0; }
+
+	private:
+		std::string m_getPath(uint64_t key);
+		void m_prune();
+
+		std::mutex m_mutex;
+		std::atomic<unsigned int> m_hits, m_misses;
+		std::atomic<unsigned int> m_storeCount;
+	};
+}
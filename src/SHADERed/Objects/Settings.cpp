@@ -20,6 +20,7 @@ namespace ed {
 		General.CheckPluginUpdates = true;
 		General.RecompileOnFileChange = false;
 		General.AutoRecompile = false;
+		General.CacheSPIRV = true;
 		General.AutoUniforms = true;
 		General.AutoUniformsPin = true;
 		General.AutoUniformsFunction = true;
@@ -80,6 +81,9 @@ namespace ed {
 		Preview.ApplyFPSLimitToApp = false;
 		Preview.LostFocusLimitFPS = false;
 		Preview.MSAA = 1;
+		Preview.ShareRTMemory = false;
+		Preview.OptimizeModels = false;
+		Preview.PackVertices = false;
 	}
 	void Settings::Load()
 	{
@@ -112,6 +116,7 @@ namespace ed {
 		General.SelectItemOnDblClk = ini.GetBoolean("general", "selectitemdblclk", true);
 		General.RecompileOnFileChange = ini.GetBoolean("general", "trackfilechange", false);
 		General.AutoRecompile = ini.GetBoolean("general", "autorecompile", false);
+		General.CacheSPIRV = ini.GetBoolean("general", "spirvcache", true);
 		General.AutoUniforms = ini.GetBoolean("general", "autouniforms", true);
 		General.AutoUniformsPin = ini.GetBoolean("general", "autouniformspin", true);
 		General.AutoUniformsFunction = ini.GetBoolean("general", "autouniformsfunction", true);
@@ -165,6 +170,9 @@ namespace ed {
 		Preview.ApplyFPSLimitToApp = ini.GetBoolean("preview", "fpslimitwholeapp", false);
 		Preview.LostFocusLimitFPS = ini.GetBoolean("preview", "fpslimitlostfocus", false);
 		Preview.MSAA = ini.GetInteger("preview", "msaa", 1);
+		Preview.ShareRTMemory = ini.GetBoolean("preview", "sharertmemory", false);
+		Preview.OptimizeModels = ini.GetBoolean("preview", "optimizemodels", false);
+		Preview.PackVertices = ini.GetBoolean("preview", "packvertices", false);
 
 		m_parseExt(ini.Get("plugins", "notloaded", ""), Plugins.NotLoaded);
 
@@ -202,6 +210,7 @@ namespace ed {
 		ini << "selectitemdblclk=" << General.SelectItemOnDblClk << std::endl;
 		ini << "trackfilechange=" << General.RecompileOnFileChange << std::endl;
 		ini << "autorecompile=" << General.AutoRecompile << std::endl;
+		ini << "spirvcache=" << General.CacheSPIRV << std::endl;
 		ini << "autouniforms=" << General.AutoUniforms << std::endl;
 		ini << "autouniformspin=" << General.AutoUniformsPin << std::endl;
 		ini << "autouniformsfunction=" << General.AutoUniformsFunction << std::endl;
@@ -257,6 +266,9 @@ namespace ed {
 		ini << "fpslimitwholeapp=" << Preview.ApplyFPSLimitToApp << std::endl;
 		ini << "fpslimitlostfocus=" << Preview.LostFocusLimitFPS << std::endl;
 		ini << "msaa=" << Preview.MSAA << std::endl;
+		ini << "sharertmemory=" << Preview.ShareRTMemory << std::endl;
+		ini << "optimizemodels=" << Preview.OptimizeModels << std::endl;
+		ini << "packvertices=" << Preview.PackVertices << std::endl;
 
 		ini << "[editor]" << std::endl;
 		ini << "smartpred=" << Editor.SmartPredictions << std::endl;
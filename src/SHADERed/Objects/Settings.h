@@ -26,6 +26,7 @@ namespace ed {
 			bool CheckPluginUpdates;
 			bool RecompileOnFileChange;
 			bool AutoRecompile;
+			bool CacheSPIRV;
 			bool AutoUniforms;
 			bool AutoUniformsPin;
 			bool AutoUniformsFunction;
@@ -91,6 +92,9 @@ namespace ed {
 			bool ApplyFPSLimitToApp; // apply FPSLimit to whole app, not only preview
 			bool LostFocusLimitFPS;	 // limit to 30FPS when app loses focus
 			int MSAA;				 // 1 (off), 2, 4, 8
+			bool ShareRTMemory;		 // render textures that only live within a frame share their textures
+			bool OptimizeModels;	 // merge identical vertices & optimize the triangle order when loading 3D models
+			bool PackVertices;		 // 3D models: half float texcoords, 10 bit normals/tangents/binormals, 8 bit colors
 		} Preview;
 
 		struct strProject {
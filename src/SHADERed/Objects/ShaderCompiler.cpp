@@ -7,8 +7,10 @@
 #include <SHADERed/Engine/GLUtils.h>
 #include <SHADERed/Objects/HLSLFileIncluder.h>
 #include <SHADERed/Objects/Logger.h>
+#include <SHADERed/Objects/SPIRVCache.h>
 #include <SHADERed/Objects/Settings.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
+#include <SHADERed/Objects/ShaderFileCache.h>
 #include <glslang/SPIRV/GlslangToSpv.h>
 #include <glslang/StandAlone/DirStackFileIncluder.h>
 #include <glslang/glslang/Public/ShaderLang.h>
@@ -192,7 +194,7 @@ namespace ed {
 		}
 
 		// WARNING: lots of hacks in the following code
-		// remove all the UBOs when transcompiling from HLSL
+		// remove all the UBOs when transcompiling from HLSL (except for the SystemVariables & PassVariables blocks)
 		if (inLang == ShaderLanguage::HLSL) {
 			std::stringstream ss(source);
 			std::string line;
@@ -200,10 +202,11 @@ namespace ed {
 			bool inUBO = false;
 			std::vector<std::string> uboNames;
 			while (std::getline(ss, line)) {
+				bool isEngineBlock = line.find("uniform type_" SYSTEM_UNIFORM_BLOCK_NAME) != std::string::npos || line.find("uniform type_" PASS_UNIFORM_BLOCK_NAME) != std::string::npos;
 
 				// i know, ewww, but idk if there's a function to do this (this = converting UBO
 				// to separate uniforms)...
-				if (line.find("layout(binding") != std::string::npos && line.find("uniform") != std::string::npos && line.find("sampler") == std::string::npos && line.find("image") == std::string::npos && line.find(" buffer ") == std::string::npos) {
+				if (!isEngineBlock && line.find("layout(binding") != std::string::npos && line.find("uniform") != std::string::npos && line.find("sampler") == std::string::npos && line.find("image") == std::string::npos && line.find(" buffer ") == std::string::npos) {
 					inUBO = true;
 					continue;
 				} else if (inUBO) {
@@ -318,7 +321,7 @@ namespace ed {
 		std::string source;
 
 		if (project != nullptr)
-			source = project->LoadProjectFile(filename);
+			source = ShaderFileCache::Instance().Load(project->GetProjectPath(filename));
 		else {
 			//Load source into a string
 			std::ifstream file(filename);
@@ -409,6 +412,30 @@ namespace ed {
 			return false;
 		}
 
+		spv::SpvBuildLogger logger;
+		glslang::SpvOptions spvOptions;
+
+		spvOptions.optimizeSize = false;
+		spvOptions.disableOptimizer = true;
+		spvOptions.generateDebugInfo = true;
+		spvOptions.validate = true;
+
+		// check if we have already compiled this exact shader
+		bool useCache = Settings::Instance().General.CacheSPIRV;
+		uint64_t cacheKey = 0;
+		if (useCache) {
+			// a newer glslang or different options produce different SPIR-V from the same source
+			std::string options = std::string(glslang::GetGlslVersionString()) + ";" + std::to_string(glslang::GetSpirvGeneratorVersion())
+				+ ";" + std::to_string(sVersion) + ";" + std::to_string((int)targetClientVersion) + ";" + std::to_string((int)targetLanguageVersion) + ";" + std::to_string((int)messages)
+				+ ";" + std::to_string(spvOptions.generateDebugInfo) + std::to_string(spvOptions.disableOptimizer) + std::to_string(spvOptions.optimizeSize) + std::to_string(spvOptions.validate);
+
+			cacheKey = SPIRVCache::Hash(processedShader, inLang, sType, entry, macros, options);
+			if (SPIRVCache::Instance().Load(cacheKey, spvOut)) {
+				ed::Logger::Get().Log("Loaded SPIR-V for " + filename + " from cache");
+				return true;
+			}
+		}
+
 		// update strings
 		const char* processedStr = processedShader.c_str();
 		shader.setStrings(&processedStr, 1);
@@ -434,15 +461,10 @@ namespace ed {
 		}
 
 		// convert to spirv
-		spv::SpvBuildLogger logger;
-		glslang::SpvOptions spvOptions;
-
-		spvOptions.optimizeSize = false;
-		spvOptions.disableOptimizer = true;
-		spvOptions.generateDebugInfo = true;
-		spvOptions.validate = true;
-
 		glslang::GlslangToSpv(*prog.getIntermediate(shaderType), spvOut, &logger, &spvOptions);
+
+		if (useCache)
+			SPIRVCache::Instance().Store(cacheKey, spvOut);
 	
 		return true;
 	}
@@ -0,0 +1,156 @@
+#include <SHADERed/Objects/ShaderFileCache.h>
+
+#include <algorithm>
+#include <fstream>
+
+#define SHADER_FILE_CACHE_TRUST_TIME 2 // seconds - FAT has a 2 second mtime granularity
+
+namespace ed {
+	// 64bit FNV-1a
+	static inline uint64_t hashString(const std::string& str)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < str.size(); i++) {
+			hash ^= (uint8_t)str[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+	static inline std::string normalizePath(const std::string& path)
+	{
+		return std::filesystem::path(path).lexically_normal().string();
+	}
+
+	std::string ShaderFileCache::Load(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_update(normalizePath(path)).Content;
+	}
+	std::vector<std::string> ShaderFileCache::GetDependencies(const std::string& path, const std::vector<std::string>& includeDirs)
+	{
+		std::string dirs = "";
+		for (const auto& dir : includeDirs)
+			dirs += dir + "\n";
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::vector<std::string> ret;
+		std::vector<std::string> stack = { normalizePath(path) };
+		while (!stack.empty()) {
+			std::string cur = stack.back();
+			stack.pop_back();
+
+			File& file = m_update(cur);
+			if (!file.Valid)
+				continue;
+
+			// #include lines - only when the contents changed
+			if (file.IncludeHash != file.Hash) {
+				file.Includes.clear();
+
+				// the directive can be indented & there can be whitespace between # and include
+				const std::string& src = file.Content;
+				size_t lineStart = 0;
+				while (lineStart < src.size()) {
+					size_t lineEnd = src.find('\n', lineStart);
+					if (lineEnd == std::string::npos)
+						lineEnd = src.size();
+
+					size_t pos = src.find_first_not_of(" \t", lineStart);
+					if (pos < lineEnd && src[pos] == '#') {
+						pos = src.find_first_not_of(" \t", pos + 1);
+						if (pos < lineEnd && src.compare(pos, 7, "include") == 0) {
+							size_t quotePos = src.find_first_of("\"<", pos + 7);
+							size_t quoteEnd = quotePos == std::string::npos ? std::string::npos : src.find_first_of("\">", quotePos + 1);
+							if (quotePos < lineEnd && quoteEnd < lineEnd)
+								file.Includes.push_back(src.substr(quotePos + 1, quoteEnd - quotePos - 1));
+						}
+					}
+
+					lineStart = lineEnd + 1;
+				}
+
+				file.IncludeHash = file.Hash;
+				file.ResolvedWith = "\n"; // resolve again
+			}
+
+			if (file.ResolvedWith != dirs) {
+				file.Resolved.clear();
+				for (const auto& name : file.Includes) {
+					std::string inc = m_resolve(cur, name, includeDirs);
+					if (!inc.empty())
+						file.Resolved.push_back(inc);
+				}
+				file.ResolvedWith = dirs;
+			}
+
+			for (const auto& inc : file.Resolved)
+				if (std::count(ret.begin(), ret.end(), inc) == 0 && inc != normalizePath(path)) {
+					ret.push_back(inc);
+					stack.push_back(inc);
+				}
+		}
+
+		return ret;
+	}
+	void ShaderFileCache::Invalidate(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_files.erase(normalizePath(path));
+	}
+	void ShaderFileCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_files.clear();
+	}
+	ShaderFileCache::File& ShaderFileCache::m_update(const std::string& path)
+	{
+		File& file = m_files[path];
+
+		std::error_code ec;
+		std::filesystem::file_time_type time = std::filesystem::last_write_time(path, ec);
+		uintmax_t size = ec ? 0 : std::filesystem::file_size(path, ec);
+		if (ec) {
+			file.Valid = false;
+			file.Content.clear();
+			return file;
+		}
+
+		// a file that was read right after it was modified can change again without a new timestamp (the
+		// filesystem's time granularity) - it's only trusted once it was read some time after its last modification
+		if (file.Valid && file.Time == time && file.Size == size && file.ReadTime - time > std::chrono::seconds(SHADER_FILE_CACHE_TRUST_TIME))
+			return file;
+
+		std::ifstream in(path, std::ios::binary);
+		if (!in.is_open()) {
+			file.Valid = false;
+			file.Content.clear();
+			return file;
+		}
+
+		file.Content.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		file.ReadTime = std::filesystem::file_time_type::clock::now();
+		file.Time = time;
+		file.Size = size;
+		file.Hash = hashString(file.Content);
+		file.Valid = true;
+
+		return file;
+	}
+	std::string ShaderFileCache::m_resolve(const std::string& from, const std::string& name, const std::vector<std::string>& includeDirs)
+	{
+		std::error_code ec;
+
+		std::filesystem::path local = std::filesystem::path(from).parent_path() / name;
+		if (std::filesystem::is_regular_file(local, ec))
+			return normalizePath(local.string());
+
+		for (const auto& dir : includeDirs) {
+			std::filesystem::path inc = std::filesystem::path(dir) / name;
+			if (std::filesystem::is_regular_file(inc, ec))
+				return normalizePath(inc.string());
+		}
+
+		return "";
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ed {
+	// contents of the shader files & the #include graph between them, shared by the compiler & the file tracker
+	// a file is only read again when its modification time or size changes (or it's saved through SHADERed) and its
+	// #include lines are only parsed & resolved again when its content hash (or the list of include directories) changes
+	class ShaderFileCache {
+	public:
+		static inline ShaderFileCache& Instance()
+		{
+			static ShaderFileCache ret;
+			return ret;
+		}
+
+		// thread safe - returns "" if the file can't be opened
+		std::string Load(const std::string& path);
+
+		// every file that the given file includes, directly or through other headers
+		// #include "x" is looked up next to the including file first, then in includeDirs
+		std::vector<std::string> GetDependencies(const std::string& path, const std::vector<std::string>& includeDirs);
+
+		void Invalidate(const std::string& path); // the file was written to - read it again on the next use
+		void Clear();
+
+	private:
+		struct File {
+			File()
+					: Size(0)
+					, Hash(0)
+					, Valid(false)
+					, IncludeHash(1)
+			{
+			}
+
+			std::filesystem::file_time_type Time;
+			std::filesystem::file_time_type ReadTime; // when Content was read
+			uintmax_t Size;
+			uint64_t Hash;
+			bool Valid;
+			std::string Content;
+
+			uint64_t IncludeHash;				  // Hash of the content that Includes & Resolved belong to
+			std::vector<std::string> Includes;	  // names as written in the #include lines
+			std::string ResolvedWith;			  // include directories used for Resolved
+			std::vector<std::string> Resolved;	  // paths of the included files
+		};
+
+		File& m_update(const std::string& path); // m_mutex must be locked
+		std::string m_resolve(const std::string& from, const std::string& name, const std::vector<std::string>& includeDirs);
+
+		std::unordered_map<std::string, File> m_files;
+		std::mutex m_mutex;
+	};
+}
@@ -103,6 +103,7 @@ namespace ed {
 			memcpy(Name, name, strlen(name));
 			Function = FunctionShaderVariable::None;
 			Flags = 0;
+			LocationSlot = -1;
 		}
 
 		static inline int GetSize(ValueType type, bool isBuffer = false)
@@ -138,6 +139,7 @@ namespace ed {
 		char Flags;
 		PluginSystemVariableData PluginSystemVarData;
 		PluginFunctionData PluginFuncData;
+		int LocationSlot;				 // index into the owner ShaderVariableContainer's uniform location tables
 
 		inline int AsInteger(int index = 0) { return *AsIntegerPtr(index); }
 		inline bool AsBoolean(int index = 0) { return *AsBooleanPtr(index); }
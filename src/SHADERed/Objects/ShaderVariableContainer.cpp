@@ -1,13 +1,27 @@
 #include <SHADERed/Objects/FunctionVariableManager.h>
 #include <SHADERed/Objects/ShaderVariableContainer.h>
 #include <SHADERed/Objects/SystemVariableManager.h>
+#include <algorithm>
 #include <iostream>
 #include <regex>
 
 namespace ed {
-	ShaderVariableContainer::ShaderVariableContainer() { }
+	unsigned int ShaderVariableContainer::UniformCallCount = 0;
+
+	ShaderVariableContainer::ShaderVariableContainer()
+	{
+		m_curLocs = nullptr;
+		m_curProgram = 0;
+		m_slotCount = 0;
+		m_ubo = 0;
+		m_uboProgram = 0;
+		m_dirtyBegin = m_dirtyEnd = 0;
+	}
 	ShaderVariableContainer::~ShaderVariableContainer()
 	{
+		if (m_ubo != 0)
+			glDeleteBuffers(1, &m_ubo);
+
 		for (int i = 0; i < m_vars.size(); i++) {
 			free(m_vars[i]->Data);
 			if (m_vars[i]->Arguments != nullptr)
@@ -16,10 +30,16 @@ namespace ed {
 			delete m_vars[i];
 		}
 	}
+	void ShaderVariableContainer::Add(ShaderVariable* var)
+	{
+		// slots are never reused so the location tables only need to grow
+		var->LocationSlot = m_slotCount++;
+		m_vars.push_back(var);
+	}
 	ShaderVariable* ShaderVariableContainer::AddCopy(ShaderVariable var)
 	{
 		ShaderVariable* n = new ShaderVariable(var);
-		m_vars.push_back(n);
+		Add(n);
 		return n;
 	}
 	void ShaderVariableContainer::Remove(const char* name)
@@ -36,18 +56,79 @@ namespace ed {
 			}
 	}
 	void ShaderVariableContainer::UpdateUniformInfo(GLuint pass)
+	{
+		// program IDs can be recycled after relinking - drop every table
+		InvalidateLocations();
+
+		SelectProgram(pass);
+	}
+	void ShaderVariableContainer::SelectProgram(GLuint pass)
+	{
+		m_curProgram = pass;
+		m_curLocs = m_getLocations(pass);
+	}
+	void ShaderVariableContainer::InvalidateLocations()
+	{
+		m_locs.clear();
+		m_curLocs = nullptr;
+	}
+	ShaderVariableContainer::ProgramLocations* ShaderVariableContainer::m_getLocations(GLuint pass)
 	{
 		if (pass == 0)
-			return;
+			return nullptr;
 
-		GLint count;
+		auto it = m_locs.find(pass);
+		if (it == m_locs.end()) {
+			ProgramLocations& locs = m_locs[pass];
+			m_resolveLocations(pass, locs);
+			return &locs;
+		}
+
+		// variables were added since the table was built
+		if (it->second.Variables.size() < m_slotCount || it->second.Samplers.size() != m_samplers.size())
+			m_resolveLocations(pass, it->second);
+
+		return &it->second;
+	}
+	void ShaderVariableContainer::m_updateLocations()
+	{
+		// tables were invalidated or variables were added
+		if (m_curProgram != 0 && (m_curLocs == nullptr || m_curLocs->Variables.size() < m_slotCount))
+			m_curLocs = m_getLocations(m_curProgram);
+	}
+	static GLuint getUniformBlockIndex(GLuint pass, const std::string& name)
+	{
+		GLuint index = glGetUniformBlockIndex(pass, name.c_str());
+
+		// SPIRV-Cross names HLSL cbuffers type_<name>
+		if (index == GL_INVALID_INDEX)
+			index = glGetUniformBlockIndex(pass, ("type_" + name).c_str());
+
+		return index;
+	}
+	void ShaderVariableContainer::m_resolveLocations(GLuint pass, ProgramLocations& locs)
+	{
+		GLint count = 0;
 
 		const GLsizei bufSize = 64; // maximum name length
 		GLchar name[bufSize];		// variable name in GLSL
 		GLsizei length;				// name length
 		GLuint samplerLoc = 0;
 
-		m_uLocs.clear();
+		std::unordered_map<std::string, GLint> uLocs;
+		std::unordered_map<std::string, std::pair<GLint, GLint>> uOffsets; // offset & matrix stride
+
+		// uniform blocks
+		GLuint sysBlock = getUniformBlockIndex(pass, SYSTEM_UNIFORM_BLOCK_NAME);
+		if (sysBlock != GL_INVALID_INDEX)
+			glUniformBlockBinding(pass, sysBlock, SYSTEM_UNIFORM_BLOCK_BINDING);
+
+		locs.BlockSize = 0;
+		GLuint passBlock = getUniformBlockIndex(pass, PASS_UNIFORM_BLOCK_NAME);
+		if (passBlock != GL_INVALID_INDEX) {
+			glUniformBlockBinding(pass, passBlock, PASS_UNIFORM_BLOCK_BINDING);
+			glGetActiveUniformBlockiv(pass, passBlock, GL_UNIFORM_BLOCK_DATA_SIZE, &locs.BlockSize);
+		}
 
 		glGetProgramiv(pass, GL_ACTIVE_UNIFORMS, &count);
 		for (GLuint i = 0; i < count; i++) {
@@ -56,11 +137,50 @@ namespace ed {
 
 			glGetActiveUniform(pass, (GLuint)i, bufSize, &length, &size, &type, name);
 
-			if (type == GL_SAMPLER_2D)
+			GLint block = -1;
+			glGetActiveUniformsiv(pass, 1, &i, GL_UNIFORM_BLOCK_INDEX, &block);
+			if (block != -1) {
+				if ((GLuint)block == passBlock) {
+					GLint offset = 0, matrixStride = 0;
+					glGetActiveUniformsiv(pass, 1, &i, GL_UNIFORM_OFFSET, &offset);
+					glGetActiveUniformsiv(pass, 1, &i, GL_UNIFORM_MATRIX_STRIDE, &matrixStride);
+
+					// members are reported as BlockName.member when the block has an instance name
+					const char* member = strrchr(name, '.');
+					uOffsets[member ? member + 1 : name] = std::make_pair(offset, matrixStride);
+				}
+				continue;
+			}
+
+			if (type == GL_SAMPLER_2D) {
 				glUniform1i(glGetUniformLocation(pass, name), samplerLoc++);
-			else
-				m_uLocs[name] = glGetUniformLocation(pass, name);
+				UniformCallCount++;
+			} else
+				uLocs[name] = glGetUniformLocation(pass, name);
+		}
+
+		locs.Variables.assign(m_slotCount, -1);
+		locs.Offsets.assign(m_slotCount, -1);
+		locs.MatrixStrides.assign(m_slotCount, 0);
+		locs.Uploaded.assign(m_slotCount, UploadedValue { 0, 0 });
+		for (const auto& var : m_vars) {
+			auto loc = uLocs.find(var->Name);
+			if (loc != uLocs.end())
+				locs.Variables[var->LocationSlot] = loc->second;
+
+			auto offset = uOffsets.find(var->Name);
+			if (offset != uOffsets.end()) {
+				locs.Offsets[var->LocationSlot] = offset->second.first;
+				locs.MatrixStrides[var->LocationSlot] = offset->second.second;
+			}
 		}
+
+		locs.Samplers.resize(m_samplers.size());
+		for (int i = 0; i < m_samplers.size(); i++)
+			locs.Samplers[i] = glGetUniformLocation(pass, m_samplers[i].c_str());
+
+		auto dbgLoc = uLocs.find("_sed_dbg_pixel_color");
+		locs.DebugPixelColor = dbgLoc == uLocs.end() ? -1 : dbgLoc->second;
 	}
 	void ShaderVariableContainer::UpdateTextureList(const std::string& fragShader)
 	{
@@ -81,30 +201,116 @@ namespace ed {
 		} catch (std::regex_error& e) {
 			// Syntax error in the regular expression
 		}
+
+		InvalidateLocations();
 	}
 	void ShaderVariableContainer::UpdateTexture(GLuint pass, GLuint unit)
 	{
 		if (unit >= m_samplers.size())
 			return;
 
-		glUniform1i(glGetUniformLocation(pass, m_samplers[unit].c_str()), unit);
+		ProgramLocations* locs = m_getLocations(pass);
+		if (locs == nullptr || locs->Samplers[unit] == -1)
+			return;
+
+		glUniform1i(locs->Samplers[unit], unit);
+		UniformCallCount++;
+	}
+	void ShaderVariableContainer::BindUniformBlock()
+	{
+		m_updateLocations();
+
+		if (m_curLocs == nullptr || m_curLocs->BlockSize <= 0)
+			return;
+
+		if (m_ubo == 0)
+			glGenBuffers(1, &m_ubo);
+
+		// block size changed - reallocate and upload everything on the next Bind()
+		if (m_uboData.size() != m_curLocs->BlockSize) {
+			m_uboData.assign(m_curLocs->BlockSize, 0);
+			for (auto& locs : m_locs)
+				locs.second.Uploaded.assign(m_slotCount, UploadedValue { 0, 0 });
+
+			glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+			glBufferData(GL_UNIFORM_BUFFER, m_uboData.size(), nullptr, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			m_uboProgram = 0;
+		}
+
+		// the debug program might use a different layout
+		if (m_uboProgram != m_curProgram) {
+			m_uboProgram = m_curProgram;
+			m_dirtyBegin = 0;
+			m_dirtyEnd = m_uboData.size();
+		}
+
+		glBindBufferBase(GL_UNIFORM_BUFFER, PASS_UNIFORM_BLOCK_BINDING, m_ubo);
+	}
+	void ShaderVariableContainer::m_writeBlock(GLint offset, const void* data, size_t size)
+	{
+		if (offset < 0 || offset + size > m_uboData.size())
+			return;
+
+		// only mark the bytes as dirty if the value actually changed
+		if (memcmp(m_uboData.data() + offset, data, size) == 0)
+			return;
+
+		memcpy(m_uboData.data() + offset, data, size);
+
+		if (m_dirtyBegin >= m_dirtyEnd) {
+			m_dirtyBegin = offset;
+			m_dirtyEnd = offset + size;
+		} else {
+			m_dirtyBegin = std::min<size_t>(m_dirtyBegin, offset);
+			m_dirtyEnd = std::max<size_t>(m_dirtyEnd, offset + size);
+		}
+	}
+	void ShaderVariableContainer::m_packVariable(ShaderVariable* var, GLint offset, GLint matrixStride)
+	{
+		int cols = var->GetColumnCount();
+		int rows = var->GetRowCount();
+
+		if (rows > 1) {
+			// every column of a matrix starts at a multiple of matrixStride
+			for (int c = 0; c < cols; c++)
+				m_writeBlock(offset + c * matrixStride, var->AsFloatPtr(0, c), rows * sizeof(float));
+		} else if (var->GetBaseType() == ShaderVariable::ValueType::Boolean1) {
+			// bools are 4 bytes wide in a block
+			GLint vals[4] = { 0 };
+			for (int c = 0; c < cols; c++)
+				vals[c] = var->AsBoolean(c);
+			m_writeBlock(offset, vals, cols * sizeof(GLint));
+		} else
+			m_writeBlock(offset, var->Data, ShaderVariable::GetSize(var->GetType()));
 	}
 	void ShaderVariableContainer::Bind(void* item)
 	{
+		m_updateLocations();
+
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+
 		for (int i = 0; i < m_vars.size(); i++) {
 			FunctionVariableManager::Instance().AddToList(m_vars[i]);
 
-			if (m_uLocs.count(m_vars[i]->Name) == 0)
+			GLint loc = m_curLocs ? m_curLocs->Variables[m_vars[i]->LocationSlot] : -1;
+			GLint offset = m_curLocs ? m_curLocs->Offsets[m_vars[i]->LocationSlot] : -1;
+			if (loc == -1 && offset == -1)
 				continue;
 
-			GLint loc = m_uLocs[m_vars[i]->Name];
+			// skip system values that haven't changed since the last upload to this program
+			UploadedValue& uploaded = m_curLocs->Uploaded[m_vars[i]->LocationSlot];
+			unsigned int version = systemVM.GetVersion(m_vars[i], item);
+			if (version != 0 && uploaded.Version == version && uploaded.Flags == m_vars[i]->Flags)
+				continue;
+			uploaded.Version = version;
+			uploaded.Flags = m_vars[i]->Flags;
 
 			// update values if needed
-			SystemVariableManager::Instance().Update(m_vars[i], item);
+			systemVM.Update(m_vars[i], item);
 			FunctionVariableManager::Instance().Update(m_vars[i]);
 
-			// update uniform every time we bind this container
-			// TODO: maybe we shouldn't update variables that havent changed
 			ShaderVariable::ValueType type = m_vars[i]->GetType();
 
 			// check the flags
@@ -121,6 +327,12 @@ namespace ed {
 				}
 			}
 
+			// a member of the PassVariables block
+			if (offset != -1) {
+				m_packVariable(m_vars[i], offset, m_curLocs->MatrixStrides[m_vars[i]->LocationSlot]);
+				continue;
+			}
+
 			switch (type) {
 			case ShaderVariable::ValueType::Boolean1:
 				glUniform1i(loc, m_vars[i]->AsBoolean());
@@ -162,6 +374,17 @@ namespace ed {
 				glUniformMatrix4fv(loc, 1, GL_FALSE, m_vars[i]->AsFloatPtr());
 				break;
 			}
+			UniformCallCount++;
+		}
+
+		// upload the part of the block that changed
+		if (m_ubo != 0 && m_dirtyBegin < m_dirtyEnd) {
+			glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+			glBufferSubData(GL_UNIFORM_BUFFER, m_dirtyBegin, m_dirtyEnd - m_dirtyBegin, m_uboData.data() + m_dirtyBegin);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			m_dirtyBegin = m_dirtyEnd = 0;
+			UniformCallCount++;
 		}
 	}
 	bool ShaderVariableContainer::ContainsVariable(const char* name)
@@ -1,6 +1,6 @@
 #pragma once
 #include <SHADERed/Objects/ShaderVariable.h>
-#include <map>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
@@ -19,21 +19,65 @@ namespace ed {
 		ShaderVariableContainer();
 		~ShaderVariableContainer();
 
-		inline void Add(ShaderVariable* var) { m_vars.push_back(var); }
+		void Add(ShaderVariable* var);
 		ShaderVariable* AddCopy(ShaderVariable var);
 		void Remove(const char* name);
 
 		bool ContainsVariable(const char* name);
-		void UpdateUniformInfo(GLuint pass);
+		void UpdateUniformInfo(GLuint pass); // call after (re)linking the program
+		void SelectProgram(GLuint pass);	 // switch between already linked programs (normal <-> debug)
+		void InvalidateLocations();			 // call when a variable gets renamed
 		void UpdateTexture(GLuint pass, GLuint unit);
 		void UpdateTextureList(const std::string& fragShader);
 		void Bind(void* item = nullptr);
+		void BindUniformBlock(); // call once per pass, after glUseProgram
 		inline std::vector<ShaderVariable*>& GetVariables() { return m_vars; }
 		inline const std::vector<std::string>& GetSamplerList() { return m_samplers; }
 
+		// location of the _sed_dbg_pixel_color uniform in the selected program
+		inline GLint GetDebugPixelColorLocation() { return m_curLocs ? m_curLocs->DebugPixelColor : -1; }
+
+		// number of glUniform* calls & uniform buffer uploads - RenderEngine resets it every frame
+		static unsigned int UniformCallCount;
+
 	private:
+		// system value version (see SystemVariableManager::GetVersion) & flags that were last uploaded to a program
+		struct UploadedValue {
+			unsigned int Version;
+			char Flags;
+		};
+
+		// uniform locations of a linked program - resolved once per link
+		struct ProgramLocations {
+			std::vector<GLint> Variables; // indexed with ShaderVariable::LocationSlot
+			std::vector<GLint> Samplers;  // indexed with texture unit
+			GLint DebugPixelColor;
+
+			// members of the PassVariables block, -1 if the variable is a plain uniform
+			std::vector<GLint> Offsets;
+			std::vector<GLint> MatrixStrides;
+			GLint BlockSize; // 0 if the program doesn't declare the block
+
+			std::vector<UploadedValue> Uploaded; // uniform values are per program so this can't live in ShaderVariable
+		};
+		ProgramLocations* m_getLocations(GLuint pass);
+		void m_resolveLocations(GLuint pass, ProgramLocations& locs);
+		void m_updateLocations();
+
+		void m_packVariable(ShaderVariable* var, GLint offset, GLint matrixStride);
+		void m_writeBlock(GLint offset, const void* data, size_t size);
+
 		std::vector<ShaderVariable*> m_vars;
-		std::map<std::string, GLint> m_uLocs;
 		std::vector<std::string> m_samplers;
+
+		std::unordered_map<GLuint, ProgramLocations> m_locs;
+		ProgramLocations* m_curLocs;
+		GLuint m_curProgram;
+		int m_slotCount;
+
+		// CPU copy of the uniform block - only the bytes that changed get uploaded
+		GLuint m_ubo, m_uboProgram;
+		std::vector<char> m_uboData;
+		size_t m_dirtyBegin, m_dirtyEnd;
 	};
 }
\ No newline at end of file
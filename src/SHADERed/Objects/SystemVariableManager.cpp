@@ -5,7 +5,7 @@ namespace ed {
 	void SystemVariableManager::Reset()
 	{
 		m_timer.Restart();
-		m_curState.FrameIndex = 0;
+		SetFrameIndex(0);
 		m_curGeoTransform.clear();
 		m_prevGeoTransform.clear();
 		m_advTimer = 0;
@@ -14,6 +14,130 @@ namespace ed {
 	{
 		memcpy(&m_prevState, &m_curState, sizeof(m_curState));
 		m_prevGeoTransform = m_curGeoTransform;
+
+		// previous values are the current values, so they also share their versions
+		memcpy(m_prevVersion, m_curVersion, sizeof(m_curVersion));
+	}
+	void SystemVariableManager::SetViewportSize(float x, float y)
+	{
+		glm::vec2 size(x, y);
+		if (m_curState.Viewport == size)
+			return;
+
+		m_curState.Viewport = size;
+		m_updateMatrices(false, true);
+	}
+	void SystemVariableManager::m_updateMatrices(bool viewChanged, bool viewportChanged)
+	{
+		if (viewChanged)
+			m_bump(SystemShaderVariable::View);
+
+		if (viewportChanged) {
+			m_snapshot.Projection = GetProjectionMatrix();
+			m_snapshot.Orthographic = GetOrthographicMatrix();
+
+			m_bump(SystemShaderVariable::ViewportSize);
+			m_bump(SystemShaderVariable::Projection);
+			m_bump(SystemShaderVariable::Orthographic);
+		}
+
+		m_snapshot.ViewProjection = m_snapshot.Projection * m_snapshot.View;
+		m_snapshot.ViewOrthographic = m_snapshot.Orthographic * m_snapshot.View;
+
+		m_bump(SystemShaderVariable::ViewProjection);
+		m_bump(SystemShaderVariable::ViewOrthographic);
+	}
+	void SystemVariableManager::UpdateSnapshot()
+	{
+		// the camera is modified directly so we have to check for changes here
+		glm::mat4 view = GetViewMatrix();
+		if (view != m_snapshot.View) {
+			m_snapshot.View = view;
+			m_updateMatrices(true, false);
+		}
+
+		Camera* cam = GetCamera();
+		glm::vec3 camPos = cam->GetPosition();
+		if (camPos != m_snapshot.CameraPosition) {
+			m_snapshot.CameraPosition = camPos;
+			m_bump(SystemShaderVariable::CameraPosition);
+			m_bump(SystemShaderVariable::CameraPosition3);
+		}
+
+		glm::vec3 camDir = cam->GetViewDirection();
+		if (camDir != m_snapshot.CameraDirection) {
+			m_snapshot.CameraDirection = camDir;
+			m_bump(SystemShaderVariable::CameraDirection3);
+		}
+
+		float time = GetTime();
+		if (time != m_snapshot.Time) {
+			m_snapshot.Time = time;
+			m_bump(SystemShaderVariable::Time);
+		}
+	}
+	unsigned int SystemVariableManager::GetVersion(ed::ShaderVariable* var, void* item)
+	{
+		if (var->System == SystemShaderVariable::None || var->System == SystemShaderVariable::PluginVariable || var->System >= SystemShaderVariable::Count)
+			return 0;
+
+		bool isLastFrame = var->Flags & (char)ShaderVariable::Flag::LastFrame;
+
+		if (var->System == SystemShaderVariable::GeometryTransform) {
+			auto& transforms = isLastFrame ? m_prevGeoTransform : m_curGeoTransform;
+			auto it = transforms.find((PipelineItem*)item);
+			return it == transforms.end() ? 0 : it->second.Version;
+		}
+
+		if (isLastFrame) {
+			// these two don't read the previous state
+			if (var->System == SystemShaderVariable::Time || var->System == SystemShaderVariable::IsSavingToFile)
+				return 0;
+
+			return m_prevVersion[(int)var->System];
+		}
+
+		return m_curVersion[(int)var->System];
+	}
+	void SystemVariableManager::UpdateUniformBuffer()
+	{
+		UniformBlock block;
+		memset(&block, 0, sizeof(block));
+
+		block.View = m_snapshot.View;
+		block.Projection = m_snapshot.Projection;
+		block.ViewProjection = m_snapshot.ViewProjection;
+		block.Orthographic = m_snapshot.Orthographic;
+		block.ViewOrthographic = m_snapshot.ViewOrthographic;
+		block.CameraPosition = glm::vec4(m_snapshot.CameraPosition, 1);
+		block.CameraDirection = glm::vec4(m_snapshot.CameraDirection, 0);
+		block.Mouse = GetMouse();
+		block.MouseButton = GetMouseButton();
+		block.ViewportSize = GetViewportSize();
+		block.MousePosition = GetMousePosition();
+		block.Time = m_snapshot.Time;
+		block.TimeDelta = GetTimeDelta();
+		block.FrameIndex = GetFrameIndex();
+		block.IsSavingToFile = m_curState.IsSavingToFile;
+		block.KeysWASD = GetKeysWASD();
+
+		if (m_ubo == 0) {
+			glGenBuffers(1, &m_ubo);
+			glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+			glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			m_uboData = block;
+		} else if (memcmp(&block, &m_uboData, sizeof(block)) != 0) {
+			glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			m_uboData = block;
+			ShaderVariableContainer::UniformCallCount++;
+		}
+
+		glBindBufferBase(GL_UNIFORM_BUFFER, SYSTEM_UNIFORM_BLOCK_BINDING, m_ubo);
 	}
 	void SystemVariableManager::Update(ed::ShaderVariable* var, void* item)
 	{
@@ -25,24 +149,19 @@ namespace ed {
 				glm::mat4 rawMatrix;
 				switch (var->System) {
 				case ed::SystemShaderVariable::View:
-					rawMatrix = this->GetViewMatrix();
-					memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+					memcpy(var->Data, glm::value_ptr(m_snapshot.View), sizeof(glm::mat4));
 					break;
 				case ed::SystemShaderVariable::Projection:
-					rawMatrix = this->GetProjectionMatrix();
-					memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+					memcpy(var->Data, glm::value_ptr(m_snapshot.Projection), sizeof(glm::mat4));
 					break;
 				case ed::SystemShaderVariable::ViewProjection:
-					rawMatrix = this->GetViewProjectionMatrix();
-					memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+					memcpy(var->Data, glm::value_ptr(m_snapshot.ViewProjection), sizeof(glm::mat4));
 					break;
 				case ed::SystemShaderVariable::Orthographic:
-					rawMatrix = this->GetOrthographicMatrix();
-					memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+					memcpy(var->Data, glm::value_ptr(m_snapshot.Orthographic), sizeof(glm::mat4));
 					break;
 				case ed::SystemShaderVariable::ViewOrthographic:
-					rawMatrix = this->GetViewOrthographicMatrix();
-					memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+					memcpy(var->Data, glm::value_ptr(m_snapshot.ViewOrthographic), sizeof(glm::mat4));
 					break;
 				case ed::SystemShaderVariable::GeometryTransform:
 					rawMatrix = this->GetGeometryTransform((PipelineItem*)item);
@@ -65,7 +184,7 @@ namespace ed {
 					memcpy(var->Data, glm::value_ptr(raw), sizeof(glm::vec4));
 				} break;
 				case ed::SystemShaderVariable::Time: {
-					float raw = this->GetTime();
+					float raw = m_snapshot.Time;
 					memcpy(var->Data, &raw, sizeof(float));
 				} break;
 				case ed::SystemShaderVariable::TimeDelta: {
@@ -85,16 +204,13 @@ namespace ed {
 					memcpy(var->Data, &raw, sizeof(bool));
 				} break;
 				case ed::SystemShaderVariable::CameraPosition: {
-					glm::vec3 cam = this->GetCamera()->GetPosition();
-					memcpy(var->Data, glm::value_ptr(glm::vec4(cam, 1)), sizeof(glm::vec4));
+					memcpy(var->Data, glm::value_ptr(glm::vec4(m_snapshot.CameraPosition, 1)), sizeof(glm::vec4));
 				} break;
 				case ed::SystemShaderVariable::CameraPosition3: {
-					glm::vec3 cam = this->GetCamera()->GetPosition();
-					memcpy(var->Data, glm::value_ptr(cam), sizeof(glm::vec3));
+					memcpy(var->Data, glm::value_ptr(m_snapshot.CameraPosition), sizeof(glm::vec3));
 				} break;
 				case ed::SystemShaderVariable::CameraDirection3: {
-					glm::vec3 cam = this->GetCamera()->GetViewDirection();
-					memcpy(var->Data, glm::value_ptr(cam), sizeof(glm::vec3));
+					memcpy(var->Data, glm::value_ptr(m_snapshot.CameraDirection), sizeof(glm::vec3));
 				} break;
 				case ed::SystemShaderVariable::KeysWASD: {
 					glm::ivec4 raw = this->GetKeysWASD();
@@ -134,7 +250,7 @@ namespace ed {
 					memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
 				} break;
 				case ed::SystemShaderVariable::GeometryTransform:
-					rawMatrix = m_prevGeoTransform[(PipelineItem*)item];
+					rawMatrix = m_prevGeoTransform[(PipelineItem*)item].Matrix;
 					memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
 					break;
 				case ed::SystemShaderVariable::ViewportSize: {
@@ -32,6 +32,16 @@ namespace ed {
 			m_curState.IsSavingToFile = false;
 			m_curGeoTransform.clear();
 			m_prevGeoTransform.clear();
+			m_ubo = 0;
+
+			m_snapshot.View = m_snapshot.Projection = m_snapshot.ViewProjection = glm::mat4(1.0f);
+			m_snapshot.Orthographic = m_snapshot.ViewOrthographic = glm::mat4(1.0f);
+			m_snapshot.CameraPosition = m_snapshot.CameraDirection = glm::vec3(0.0f);
+			m_snapshot.Time = 0.0f;
+
+			m_lastVersion = 0;
+			for (int i = 0; i < (int)SystemShaderVariable::Count; i++)
+				m_curVersion[i] = m_prevVersion[i] = ++m_lastVersion;
 		}
 
 		static inline ed::ShaderVariable::ValueType GetType(ed::SystemShaderVariable sysVar)
@@ -63,6 +73,15 @@ namespace ed {
 
 		void Update(ed::ShaderVariable* var, void* item = nullptr);
 
+		// every system value gets a new version number when it changes - 0 means that the value isn't tracked and must always be updated
+		unsigned int GetVersion(ed::ShaderVariable* var, void* item = nullptr);
+
+		// recomputes the values that can't be tracked through the setters (camera & time), call once per frame
+		void UpdateSnapshot();
+
+		// uploads the SystemVariables block if any of its values changed and binds it
+		void UpdateUniformBuffer();
+
 		static ed::SystemShaderVariable GetTypeFromName(const std::string& name);
 
 		void Reset();
@@ -74,7 +93,7 @@ namespace ed {
 		inline glm::mat4 GetOrthographicMatrix() { return glm::ortho(0.0f, m_curState.Viewport.x, m_curState.Viewport.y, 0.0f, 0.1f, 1000.0f); }
 		inline glm::mat4 GetViewProjectionMatrix() { return GetProjectionMatrix() * GetViewMatrix(); }
 		inline glm::mat4 GetViewOrthographicMatrix() { return GetOrthographicMatrix() * GetViewMatrix(); }
-		inline glm::mat4 GetGeometryTransform(PipelineItem* item) { return m_curGeoTransform[item]; }
+		inline glm::mat4 GetGeometryTransform(PipelineItem* item) { return m_curGeoTransform[item].Matrix; }
 		inline glm::vec2 GetViewportSize() { return m_curState.Viewport; }
 		inline glm::ivec4 GetKeysWASD() { return m_curState.WASD; }
 		inline glm::vec2 GetMousePosition() { return m_curState.MousePosition; }
@@ -88,17 +107,25 @@ namespace ed {
 
 		inline void SetGeometryTransform(PipelineItem* item, const glm::vec3& scale, const glm::vec3& rota, const glm::vec3& pos)
 		{
-			m_curGeoTransform[item] = glm::translate(glm::mat4(1), pos) * glm::yawPitchRoll(rota.y, rota.x, rota.z) * glm::scale(glm::mat4(1.0f), scale);
+			GeometryTransform& transform = m_curGeoTransform[item];
+			if (transform.Version != 0 && transform.Scale == scale && transform.Rotation == rota && transform.Position == pos)
+				return;
+
+			transform.Scale = scale;
+			transform.Rotation = rota;
+			transform.Position = pos;
+			transform.Matrix = glm::translate(glm::mat4(1), pos) * glm::yawPitchRoll(rota.y, rota.x, rota.z) * glm::scale(glm::mat4(1.0f), scale);
+			transform.Version = ++m_lastVersion;
 		}
-		inline void SetViewportSize(float x, float y) { m_curState.Viewport = glm::vec2(x, y); }
-		inline void SetMousePosition(float x, float y) { m_curState.MousePosition = glm::vec2(x, y); }
-		inline void SetMouse(float x, float y, float left, float right) { m_curState.Mouse = glm::vec4(x, y, left, right); }
-		inline void SetMouseButton(float x, float y, float left, float right) { m_curState.MouseButton = glm::vec4(x, y, left, right); }
-		inline void SetTimeDelta(float x) { m_curState.DeltaTime = x; }
-		inline void SetPicked(bool picked) { m_curState.IsPicked = picked; }
-		inline void SetKeysWASD(int w, int a, int s, int d) { m_curState.WASD = glm::ivec4(w, a, s, d); }
-		inline void SetFrameIndex(unsigned int ind) { m_curState.FrameIndex = ind; }
-		inline void SetSavingToFile(bool isSaving) { m_curState.IsSavingToFile = isSaving; }
+		void SetViewportSize(float x, float y);
+		inline void SetMousePosition(float x, float y) { m_set(m_curState.MousePosition, glm::vec2(x, y), SystemShaderVariable::MousePosition); }
+		inline void SetMouse(float x, float y, float left, float right) { m_set(m_curState.Mouse, glm::vec4(x, y, left, right), SystemShaderVariable::Mouse); }
+		inline void SetMouseButton(float x, float y, float left, float right) { m_set(m_curState.MouseButton, glm::vec4(x, y, left, right), SystemShaderVariable::MouseButton); }
+		inline void SetTimeDelta(float x) { m_set(m_curState.DeltaTime, x, SystemShaderVariable::TimeDelta); }
+		inline void SetPicked(bool picked) { m_set(m_curState.IsPicked, picked, SystemShaderVariable::IsPicked); }
+		inline void SetKeysWASD(int w, int a, int s, int d) { m_set(m_curState.WASD, glm::ivec4(w, a, s, d), SystemShaderVariable::KeysWASD); }
+		inline void SetFrameIndex(unsigned int ind) { m_set(m_curState.FrameIndex, ind, SystemShaderVariable::FrameIndex); }
+		inline void SetSavingToFile(bool isSaving) { m_set(m_curState.IsSavingToFile, isSaving, SystemShaderVariable::IsSavingToFile); }
 
 		inline void AdvanceTimer(float t) { m_advTimer += t; }
 
@@ -119,6 +146,53 @@ namespace ed {
 			glm::vec4 Mouse, MouseButton;
 		} m_prevState, m_curState;
 
-		std::unordered_map<PipelineItem*, glm::mat4> m_curGeoTransform, m_prevGeoTransform;
+		struct GeometryTransform {
+			glm::vec3 Scale, Rotation, Position;
+			glm::mat4 Matrix;
+			unsigned int Version = 0;
+		};
+		std::unordered_map<PipelineItem*, GeometryTransform> m_curGeoTransform, m_prevGeoTransform;
+
+		// values computed once per frame (or when the viewport changes) instead of once per variable
+		struct Snapshot {
+			glm::mat4 View, Projection, ViewProjection, Orthographic, ViewOrthographic;
+			glm::vec3 CameraPosition, CameraDirection;
+			float Time;
+		} m_snapshot;
+		void m_updateMatrices(bool viewChanged, bool viewportChanged);
+
+		unsigned int m_lastVersion;
+		unsigned int m_curVersion[(int)SystemShaderVariable::Count], m_prevVersion[(int)SystemShaderVariable::Count];
+		inline void m_bump(SystemShaderVariable var) { m_curVersion[(int)var] = ++m_lastVersion; }
+
+		template <typename T>
+		inline void m_set(T& value, const T& newValue, SystemShaderVariable var)
+		{
+			if (value != newValue) {
+				value = newValue;
+				m_bump(var);
+			}
+		}
+
+		// matches the std140 layout of:
+		// layout(std140) uniform SystemVariables {
+		//	mat4 View, Projection, ViewProjection, Orthographic, ViewOrthographic;
+		//	vec4 CameraPosition, CameraDirection, Mouse, MouseButton;
+		//	vec2 ViewportSize, MousePosition;
+		//	float Time, TimeDelta;
+		//	uint FrameIndex;
+		//	bool IsSavingToFile;
+		//	ivec4 KeysWASD;
+		// } sys;
+		struct UniformBlock {
+			glm::mat4 View, Projection, ViewProjection, Orthographic, ViewOrthographic;
+			glm::vec4 CameraPosition, CameraDirection, Mouse, MouseButton;
+			glm::vec2 ViewportSize, MousePosition;
+			float Time, TimeDelta;
+			unsigned int FrameIndex;
+			int IsSavingToFile;
+			glm::ivec4 KeysWASD;
+		} m_uboData;
+		GLuint m_ubo;
 	};
 }
\ No newline at end of file
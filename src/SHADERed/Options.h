@@ -17,6 +17,12 @@
 #define DEBUG_PRIMITIVE_GROUP 170
 #define DEBUG_INSTANCE_GROUP 512
 
+// opt-in std140 uniform blocks - variables declared inside them are uploaded through a UBO instead of glUniform*
+#define SYSTEM_UNIFORM_BLOCK_NAME "SystemVariables" // shared by all passes, updated once per frame
+#define SYSTEM_UNIFORM_BLOCK_BINDING 0
+#define PASS_UNIFORM_BLOCK_NAME "PassVariables" // one buffer per pass
+#define PASS_UNIFORM_BLOCK_BINDING 1
+
 #ifdef _WIN32
 #define SHADERED_MAX_PATH 260
 #else
@@ -3,6 +3,7 @@
 #include <SHADERed/Objects/Names.h>
 #include <SHADERed/Objects/Settings.h>
 #include <SHADERed/Objects/ShaderCompiler.h>
+#include <SHADERed/Objects/ShaderFileCache.h>
 #include <SHADERed/Objects/ThemeContainer.h>
 #include <SHADERed/UI/CodeEditorUI.h>
 #include <SHADERed/UI/UIHelper.h>
@@ -137,6 +138,7 @@ namespace ed {
 					pipe::PluginItemData* shader = reinterpret_cast<pipe::PluginItemData*>(m_items[m_editorSaveRequestID]->Data);
 					std::string edsrc = m_editor[m_editorSaveRequestID]->GetText();
 					shader->Owner->CodeEditor_SaveItem(edsrc.c_str(), edsrc.size(), m_paths[m_editorSaveRequestID].c_str()); // TODO: custom stages
+					ShaderFileCache::Instance().Invalidate(m_paths[m_editorSaveRequestID]);
 				} else
 					m_data->Parser.SaveProjectFile(path, text);
 			} else {
@@ -471,6 +473,9 @@ namespace ed {
 	}
 	void CodeEditorUI::UpdateAutoRecompileItems()
 	{
+		// the editor never waits for the compiler - the shaders get replaced once the background compile is done
+		m_data->Renderer.UpdateRecompiles();
+
 		if (m_contentChanged && m_lastAutoRecompile.GetElapsedTime() > 0.8f) {
 			for (int i = 0; i < m_changedEditors.size(); i++) {
 				for (int j = 0; j < m_editor.size(); j++) {
@@ -483,11 +488,11 @@ namespace ed {
 								ps = m_editor[j]->GetText();
 							else if (m_shaderStage[j] == ShaderStage::Geometry)
 								gs = m_editor[j]->GetText();
-							m_data->Renderer.RecompileFromSource(m_items[j]->Name, vs, ps, gs);
+							m_data->Renderer.RecompileFromSourceAsync(m_items[j]->Name, vs, ps, gs);
 						} else if (m_items[j]->Type == PipelineItem::ItemType::ComputePass)
-							m_data->Renderer.RecompileFromSource(m_items[j]->Name, m_editor[j]->GetText());
+							m_data->Renderer.RecompileFromSourceAsync(m_items[j]->Name, m_editor[j]->GetText());
 						else if (m_items[j]->Type == PipelineItem::ItemType::AudioPass)
-							m_data->Renderer.RecompileFromSource(m_items[j]->Name, m_editor[j]->GetText());
+							m_data->Renderer.RecompileFromSourceAsync(m_items[j]->Name, m_editor[j]->GetText());
 						else if (m_items[j]->Type == PipelineItem::ItemType::PluginItem) {
 							std::string pluginCode = m_editor[j]->GetText();
 							((pipe::PluginItemData*)m_items[j]->Data)->Owner->HandleRecompileFromSource(m_items[j]->Name, (int)m_shaderStage[j], pluginCode.c_str(), pluginCode.size());
@@ -518,11 +523,11 @@ namespace ed {
 								ps = std::string(tempText, contentLength);
 							else if (m_shaderStage[j] == ShaderStage::Geometry)
 								gs = std::string(tempText, contentLength);
-							m_data->Renderer.RecompileFromSource(m_items[j]->Name, vs, ps, gs);
+							m_data->Renderer.RecompileFromSourceAsync(m_items[j]->Name, vs, ps, gs);
 						} else if (m_items[j]->Type == PipelineItem::ItemType::ComputePass)
-							m_data->Renderer.RecompileFromSource(m_items[j]->Name, std::string(tempText, contentLength));
+							m_data->Renderer.RecompileFromSourceAsync(m_items[j]->Name, std::string(tempText, contentLength));
 						else if (m_items[j]->Type == PipelineItem::ItemType::AudioPass)
-							m_data->Renderer.RecompileFromSource(m_items[j]->Name, std::string(tempText, contentLength));
+							m_data->Renderer.RecompileFromSourceAsync(m_items[j]->Name, std::string(tempText, contentLength));
 						else if (m_items[j]->Type == PipelineItem::ItemType::PluginItem) {
 							std::string pluginCode = std::string(tempText, contentLength);
 							((pipe::PluginItemData*)m_items[j]->Data)->Owner->HandleRecompileFromSource(m_items[j]->Name, (int)m_shaderStage[j], pluginCode.c_str(), pluginCode.size());
@@ -1119,6 +1124,8 @@ namespace ed {
 
 		m_trackUpdatesNeeded = 0;
 
+		bool includesChanged = false; // a tracked file changed - its #include lines might have too
+
 #if defined(__APPLE__)
 		// TODO: implementation for macos (cant test)
 #elif defined(__linux__) || defined(__unix__)
@@ -1246,7 +1253,7 @@ namespace ed {
 			}
 
 			// update our file collection if needed
-			if (needsUpdate || nPasses.size() != passes.size() || curProject != m_data->Parser.GetOpenedFile() || paths.size() == 0) {
+			if (needsUpdate || includesChanged || nPasses.size() != passes.size() || curProject != m_data->Parser.GetOpenedFile() || paths.size() == 0) {
 #if defined(__APPLE__)
 				// TODO: implementation for macos
 #elif defined(__linux__) || defined(__unix__)
@@ -1266,6 +1273,26 @@ namespace ed {
 				allPasses.clear();
 				paths.clear();
 				curProject = m_data->Parser.GetOpenedFile();
+				includesChanged = false;
+
+				// the include directories for the dependency lookup
+				std::vector<std::string> includeDirs;
+				for (const auto& dir : Settings::Instance().Project.IncludePaths)
+					includeDirs.push_back(m_data->Parser.GetProjectPath(dir));
+				includeDirs.push_back(m_data->Parser.GetProjectPath("."));
+
+				// a pass is recompiled when its shader files or any of the headers that they (transitively) include change
+				auto addFile = [&](const std::string& path, const char* passName) {
+					allFiles.push_back(path);
+					paths.push_back(path.substr(0, path.find_last_of("/\\") + 1));
+					allPasses.push_back(passName);
+
+					for (const auto& dep : ShaderFileCache::Instance().GetDependencies(path, includeDirs)) {
+						allFiles.push_back(dep);
+						paths.push_back(dep.substr(0, dep.find_last_of("/\\") + 1));
+						allPasses.push_back(passName);
+					}
+				};
 
 				// get all paths to all shaders
 				passes = nPasses;
@@ -1275,52 +1302,22 @@ namespace ed {
 					if (pass->Type == PipelineItem::ItemType::ShaderPass) {
 						pipe::ShaderPass* data = (pipe::ShaderPass*)pass->Data;
 
-						std::string vsPath(m_data->Parser.GetProjectPath(data->VSPath));
-						std::string psPath(m_data->Parser.GetProjectPath(data->PSPath));
-
-						allFiles.push_back(vsPath);
-						paths.push_back(vsPath.substr(0, vsPath.find_last_of("/\\") + 1));
-						allPasses.push_back(pass->Name);
-
-						allFiles.push_back(psPath);
-						paths.push_back(psPath.substr(0, psPath.find_last_of("/\\") + 1));
-						allPasses.push_back(pass->Name);
-
-						if (data->GSUsed) {
-							std::string gsPath(m_data->Parser.GetProjectPath(data->GSPath));
-
-							allFiles.push_back(gsPath);
-							paths.push_back(gsPath.substr(0, gsPath.find_last_of("/\\") + 1));
-							allPasses.push_back(pass->Name);
-						}
+						addFile(m_data->Parser.GetProjectPath(data->VSPath), pass->Name);
+						addFile(m_data->Parser.GetProjectPath(data->PSPath), pass->Name);
+						if (data->GSUsed)
+							addFile(m_data->Parser.GetProjectPath(data->GSPath), pass->Name);
 					} else if (pass->Type == PipelineItem::ItemType::ComputePass) {
 						pipe::ComputePass* data = (pipe::ComputePass*)pass->Data;
-
-						std::string path(m_data->Parser.GetProjectPath(data->Path));
-
-						allFiles.push_back(path);
-						paths.push_back(path.substr(0, path.find_last_of("/\\") + 1));
-						allPasses.push_back(pass->Name);
+						addFile(m_data->Parser.GetProjectPath(data->Path), pass->Name);
 					} else if (pass->Type == PipelineItem::ItemType::AudioPass) {
 						pipe::AudioPass* data = (pipe::AudioPass*)pass->Data;
-
-						std::string path(m_data->Parser.GetProjectPath(data->Path));
-
-						allFiles.push_back(path);
-						paths.push_back(path.substr(0, path.find_last_of("/\\") + 1));
-						allPasses.push_back(pass->Name);
+						addFile(m_data->Parser.GetProjectPath(data->Path), pass->Name);
 					} else if (pass->Type == PipelineItem::ItemType::PluginItem) {
 						pipe::PluginItemData* data = (pipe::PluginItemData*)pass->Data;
 
 						int count = data->Owner->ShaderFilePath_GetCount();
-
-						for (int i = 0; i < count; i++) {
-							std::string path(m_data->Parser.GetProjectPath(data->Owner->ShaderFilePath_Get(i)));
-
-							allFiles.push_back(path);
-							paths.push_back(path.substr(0, path.find_last_of("/\\") + 1));
-							allPasses.push_back(pass->Name);
-						}
+						for (int i = 0; i < count; i++)
+							addFile(m_data->Parser.GetProjectPath(data->Owner->ShaderFilePath_Get(i)), pass->Name);
 					}
 				}
 
@@ -1431,6 +1428,7 @@ namespace ed {
 
 									if (!shouldBeIgnored) {
 										m_trackUpdatesNeeded++;
+										includesChanged = true;
 
 										for (int j = 0; j < passes.size(); j++)
 											if (allPasses[i] == passes[j]->Name)
@@ -1498,6 +1496,7 @@ namespace ed {
 
 								if (!shouldBeIgnored) {
 									m_trackUpdatesNeeded++;
+									includesChanged = true;
 
 									for (int j = 0; j < passes.size(); j++)
 										if (allPasses[i] == passes[j]->Name)
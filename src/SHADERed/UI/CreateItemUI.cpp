@@ -775,6 +775,9 @@ namespace ed {
 			m_createFile(origData->Path);
 
 			strcpy(data->Path, origData->Path);
+			data->SampleRate = origData->SampleRate;
+			data->BlockSize = origData->BlockSize;
+			data->Channels = origData->Channels;
 
 			m_errorOccured = !m_data->Pipeline.AddAudioPass(m_item.Name, data);
 			return !m_errorOccured;
@@ -95,6 +95,8 @@ namespace ed {
 				}
 
 				bool hasPluginPreview = isPluginOwner && pobj->Owner->Object_HasPreview(pobj->Type);
+				if (oItem->RT != nullptr)
+					m_data->Renderer.MarkRTVisible(tex);
 				if (oItem->IsCube) {
 					m_cubePrev.Draw(tex);
 					ImGui::Image((void*)(intptr_t)m_cubePrev.GetTexture(), ImVec2(IMAGE_CONTEXT_WIDTH, ((float)imgWH) * IMAGE_CONTEXT_WIDTH), ImVec2(0, 1), ImVec2(1, 0));
@@ -238,7 +240,7 @@ namespace ed {
 
 									if (mitem->InstanceBuffer == m_data->Objects.GetBuffer(items[i])) {
 										for (auto& mesh : mitem->Data->Meshes)
-											gl::CreateVAO(mesh.VAO, mesh.VBO, pdata->InputLayout, mesh.EBO);
+											mesh.CreateVAO(pdata->InputLayout);
 										mitem->InstanceBuffer = nullptr;
 									}
 								} else if (pitem->Type == ed::PipelineItem::ItemType::VertexBuffer) {
@@ -80,6 +80,9 @@ namespace ed {
 			if (ImGui::Begin((name + "###objprev" + std::to_string(i)).c_str(), &item->IsOpen)) {
 				ImVec2 aSize = ImGui::GetContentRegionAvail();
 
+				if (item->RT != nullptr)
+					m_data->Renderer.MarkRTVisible(item->Texture);
+
 				if (item->Plugin != nullptr) {
 					PluginObject* pobj = ((PluginObject*)item->Plugin);
 					pobj->Owner->Object_ShowExtendedPreview(pobj->Type, pobj->Data, pobj->ID);
@@ -145,8 +148,10 @@ namespace ed {
 
 						ImGui::Text("Format:");
 						ImGui::SameLine();
-						if (ImGui::InputText("##objprev_formatinp", buf->ViewFormat, 256))
+						if (ImGui::InputText("##objprev_formatinp", buf->ViewFormat, 256)) {
+							buf->Generation++;
 							m_data->Parser.ModifyProject();
+						}
 						ImGui::SameLine();
 						if (ImGui::Button("APPLY##objprev_applyfmt"))
 							item->CachedFormat = m_data->Objects.ParseBufferFormat(buf->ViewFormat);
@@ -164,19 +169,12 @@ namespace ed {
 						ImGui::PopItemWidth();
 						ImGui::SameLine();
 						if (ImGui::Button("APPLY##objprev_applysize")) {
-							int oldSize = buf->Size;
-							
-							buf->Size = item->CachedSize;
-							if (buf->Size < 0) buf->Size = 0;
-
-							void* newData = calloc(1, buf->Size);
-							memcpy(newData, buf->Data, std::min<int>(oldSize, buf->Size));
-							free(buf->Data);
-							buf->Data = newData;
+							buf->Resize(item->CachedSize);
 
 							glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
 							glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // resize
 							glBindBuffer(GL_UNIFORM_BUFFER, 0);
+							buf->Generation++;
 
 							m_data->Parser.ModifyProject();
 						}
@@ -190,6 +188,7 @@ namespace ed {
 							glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
 							glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // upload data
 							glBindBuffer(GL_UNIFORM_BUFFER, 0);
+							buf->Generation++;
 
 							m_data->Parser.ModifyProject();
 						}
@@ -284,6 +283,7 @@ namespace ed {
 										glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
 										glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // allocate 0 bytes of memory
 										glBindBuffer(GL_UNIFORM_BUFFER, 0);
+										buf->Generation++;
 
 										m_data->Parser.ModifyProject();
 									}
@@ -1,5 +1,6 @@
 #include <SHADERed/Objects/KeyboardShortcuts.h>
 #include <SHADERed/Objects/Logger.h>
+#include <SHADERed/Objects/SPIRVCache.h>
 #include <SHADERed/Objects/Settings.h>
 #include <SHADERed/Objects/ThemeContainer.h>
 #include <SHADERed/Options.h>
@@ -311,6 +312,14 @@ namespace ed {
 		ImGui::SameLine();
 		ImGui::Checkbox("##optg_autorecompile", &settings->General.AutoRecompile);
 
+		/* SPIR-V CACHE */
+		ImGui::Text("Cache compiled SPIR-V on disk: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optg_spirvcache", &settings->General.CacheSPIRV);
+		ImGui::SameLine();
+		if (ImGui::Button("CLEAR##optg_spirvcache_clear"))
+			SPIRVCache::Instance().Clear();
+
 		/* AUTO UNIFORMS: */
 		ImGui::Text("Automatically detect and add uniforms to variable manager: ");
 		ImGui::SameLine();
@@ -793,6 +802,27 @@ namespace ed {
 			m_data->Renderer.RequestTextureResize();
 		}
 
+		/* SHARE RENDER TEXTURE MEMORY: */
+		ImGui::Text("Share memory between intermediate render textures: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_sharertmem", &settings->Preview.ShareRTMemory);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Render textures that are only read later in the same frame reuse each other's memory.\nTheir previews aren't available while the preview is running.");
+
+		/* OPTIMIZE 3D MODELS: */
+		ImGui::Text("Optimize 3D models: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_optimizemodels", &settings->Preview.OptimizeModels);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Merge identical vertices and reorder the triangles for the GPU's vertex cache.\nChanges the vertex IDs. Applies to models loaded afterwards.");
+
+		/* PACK VERTICES: */
+		ImGui::Text("Compress 3D model vertices: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_packvertices", &settings->Preview.PackVertices);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Store normals, tangents and binormals with 10 bits, texture coordinates as half floats and colors with 8 bits.\nApplies when a model's input layout is set up again (e.g. when a project is loaded).");
+
 		/* SWITCH LEFT AND RIGHT: */
 		ImGui::Text("Switch what left and right clicks do: ");
 		ImGui::SameLine();
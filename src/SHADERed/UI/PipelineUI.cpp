@@ -191,10 +191,10 @@ namespace ed {
 						BufferObject* bobj = (BufferObject*)mitem->InstanceBuffer;
 						if (bobj == nullptr) {
 							for (auto& mesh : mitem->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, pass->InputLayout, mesh.EBO);
+								mesh.CreateVAO(pass->InputLayout);
 						} else {
 							for (auto& mesh : mitem->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, pass->InputLayout, mesh.EBO, bobj->ID, m_data->Objects.ParseBufferFormat(bobj->ViewFormat));
+								mesh.CreateVAO(pass->InputLayout, bobj->ID, m_data->Objects.ParseBufferFormat(bobj->ViewFormat));
 						}
 					} else if (pitem->Type == PipelineItem::ItemType::VertexBuffer) {
 						pipe::VertexBuffer* mitem = (pipe::VertexBuffer*)pitem->Data;
@@ -735,7 +735,8 @@ namespace ed {
 		ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0, 0, 0, 0));
 
 		int id = 0;
-		std::vector<ed::ShaderVariable*>& els = isCompute ? ((pipe::ComputePass*)itemData)->Variables.GetVariables() : (isAudio ? ((pipe::AudioPass*)itemData)->Variables.GetVariables() : ((pipe::ShaderPass*)itemData)->Variables.GetVariables());
+		ShaderVariableContainer& container = isCompute ? ((pipe::ComputePass*)itemData)->Variables : (isAudio ? ((pipe::AudioPass*)itemData)->Variables : ((pipe::ShaderPass*)itemData)->Variables);
+		std::vector<ed::ShaderVariable*>& els = container.GetVariables();
 
 		/* EXISTING VARIABLES */
 		for (auto& el : els) {
@@ -870,6 +871,7 @@ namespace ed {
 			ImGui::PushItemWidth(-ImGui::GetStyle().FramePadding.x);
 			if (ImGui::InputText(("##name" + std::to_string(id)).c_str(), const_cast<char*>(el->Name), VARIABLE_NAME_LENGTH)) {
 				m_data->Parser.ModifyProject();
+				container.InvalidateLocations();
 			}
 			ImGui::NextColumn();
 
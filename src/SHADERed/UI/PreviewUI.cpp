@@ -23,6 +23,8 @@
 #define FPS_UPDATE_RATE 0.3f
 #define BOUNDING_BOX_PADDING 0.01f
 #define MAX_PICKED_ITEM_LIST_SIZE 4
+#define RESIZE_SETTLE_TIME 0.1f	 // render textures are reallocated once the preview size stops changing for this long...
+#define RESIZE_MAX_INTERVAL 0.25f // ...or at least this often while it keeps changing
 
 /* bounding box shaders */
 const char* BOX_VS_CODE = R"(
@@ -84,7 +86,7 @@ namespace ed {
 			SystemVariableManager::Instance().AdvanceTimer(deltaTime); // add one second to timer
 			SystemVariableManager::Instance().SetFrameIndex(SystemVariableManager::Instance().GetFrameIndex() + 1);
 
-			m_data->Renderer.Render(m_imgSize.x, m_imgSize.y);
+			m_data->Renderer.Render(m_renderSize.x, m_renderSize.y);
 		});
 		KeyboardShortcuts::Instance().SetCallback("Preview.IncreaseTimeFast", [=]() {
 			if (!m_data->Renderer.IsPaused())
@@ -95,7 +97,7 @@ namespace ed {
 			SystemVariableManager::Instance().AdvanceTimer(0.1f);																   // add one second to timer
 			SystemVariableManager::Instance().SetFrameIndex(SystemVariableManager::Instance().GetFrameIndex() + 0.1f / deltaTime); // add estimated number of frames
 
-			m_data->Renderer.Render(m_imgSize.x, m_imgSize.y);
+			m_data->Renderer.Render(m_renderSize.x, m_renderSize.y);
 		});
 		KeyboardShortcuts::Instance().SetCallback("Preview.TogglePause", [=]() {
 			m_data->Renderer.Pause(!m_data->Renderer.IsPaused());
@@ -205,6 +207,29 @@ namespace ed {
 			m_fullWindowFocus = false;
 		}
 	}
+	void PreviewUI::m_updateRenderSize(const ImVec2& imageSize, float delta)
+	{
+		glm::ivec2 size(std::max<int>(1, imageSize.x), std::max<int>(1, imageSize.y));
+
+		if (size != m_requestedSize) {
+			m_requestedSize = size;
+			m_resizeSettle = 0.0f;
+		} else
+			m_resizeSettle += delta;
+		m_resizeElapsed += delta;
+
+		// dragging a splitter changes the size on every mouse move - ImGui stretches the last
+		// frame in the meantime instead of every render texture being reallocated each frame
+		if (m_renderSize == m_requestedSize)
+			return;
+		if (m_renderSize.x != 0 && m_resizeSettle < RESIZE_SETTLE_TIME && m_resizeElapsed < RESIZE_MAX_INTERVAL)
+			return;
+
+		m_renderSize = m_requestedSize;
+		m_resizeElapsed = 0.0f;
+
+		SystemVariableManager::Instance().SetViewportSize(m_renderSize.x, m_renderSize.y);
+	}
 	void PreviewUI::Pick(PipelineItem* item, bool add)
 	{
 		// reset variables
@@ -293,10 +318,11 @@ namespace ed {
 		ImVec2 imageSize = m_imgSize = ImVec2(ImGui::GetWindowContentRegionWidth(), abs(ImGui::GetWindowContentRegionMax().y - ImGui::GetWindowContentRegionMin().y - (STATUSBAR_HEIGHT - ImGui::GetStyle().FramePadding.y) * statusbar));
 		ed::RenderEngine* renderer = &m_data->Renderer;
 
+		m_updateRenderSize(imageSize, delta);
+
 		if (m_zoomLastSize.x != (int)imageSize.x || m_zoomLastSize.y != (int)imageSize.y) {
 			m_zoomLastSize.x = imageSize.x;
 			m_zoomLastSize.y = imageSize.y;
-			SystemVariableManager::Instance().SetViewportSize(imageSize.x, imageSize.y);
 
 			m_zoom.RebuildVBO(imageSize.x, imageSize.y);
 		}
@@ -307,7 +333,7 @@ namespace ed {
 		bool useFpsLimit = !capWholeApp && m_fpsLimit > 0 && m_elapsedTime >= 1.0f / m_fpsLimit;
 		if (capWholeApp || m_fpsLimit <= 0 || useFpsLimit) {
 			if (!paused) {
-				renderer->Render(imageSize.x, imageSize.y);
+				renderer->Render(m_renderSize.x, m_renderSize.y);
 				m_data->Objects.Update(delta);
 			}
 
@@ -334,8 +360,8 @@ namespace ed {
 
 		m_hasFocus = ImGui::IsWindowFocused();
 
-		if (paused && m_zoomLastSize != renderer->GetLastRenderSize() &&!m_data->Debugger.IsDebugging()) {
-			renderer->Render(imageSize.x, imageSize.y);
+		if (paused && m_renderSize != renderer->GetLastRenderSize() && !m_data->Debugger.IsDebugging()) {
+			renderer->Render(m_renderSize.x, m_renderSize.y);
 			pixelList.clear();
 		}
 
@@ -389,10 +415,10 @@ namespace ed {
 			// update system variable mouse position value
 			if (ImGui::IsMouseDown(0)) {
 				glm::vec4 mbtnlast = SystemVariableManager::Instance().GetMouseButton();
-				SystemVariableManager::Instance().SetMouseButton(std::max<float>(0.0f, m_mousePos.x * imageSize.x),
-					std::max<float>(0.0f, m_mousePos.y * imageSize.y),
-					std::max<float>(0.0f, m_lastButton.x * imageSize.x),
-					std::max<float>(0.0f, m_lastButton.y * imageSize.y));
+				SystemVariableManager::Instance().SetMouseButton(std::max<float>(0.0f, m_mousePos.x * m_renderSize.x),
+					std::max<float>(0.0f, m_mousePos.y * m_renderSize.y),
+					std::max<float>(0.0f, m_lastButton.x * m_renderSize.x),
+					std::max<float>(0.0f, m_lastButton.y * m_renderSize.y));
 			}
 
 			SystemVariableManager::Instance().SetMousePosition(m_mousePos.x, m_mousePos.y);
@@ -539,7 +565,7 @@ namespace ed {
 				bool shiftPickBegan = ImGui::GetIO().KeyShift;
 
 				if ((settings.Preview.BoundingBox && !settings.Preview.Gizmo) || (m_picks.size() != 0 && m_gizmo.Click(s.x, s.y, imageSize.x, imageSize.y) == -1) || m_picks.size() == 0) {
-					renderer->Pick(s.x, s.y, shiftPickBegan, [&](PipelineItem* item) {
+					renderer->Pick(s.x * m_renderSize.x / imageSize.x, s.y * m_renderSize.y / imageSize.y, shiftPickBegan, [&](PipelineItem* item) {
 						if (settings.Preview.PropertyPick)
 							((PropertyUI*)m_ui->Get(ViewID::Properties))->Open(item);
 
@@ -903,7 +929,7 @@ namespace ed {
 				SystemVariableManager::Instance().SetFrameIndex(SystemVariableManager::Instance().GetFrameIndex() + 0.1f / deltaTime); // add estimated number of frames
 			}
 
-			m_data->Renderer.Render(m_imgSize.x, m_imgSize.y);
+			m_data->Renderer.Render(m_renderSize.x, m_renderSize.y);
 		}
 		ImGui::SameLine();
 
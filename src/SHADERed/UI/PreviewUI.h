@@ -20,6 +20,8 @@ namespace ed {
 				, m_overlayColor(0)
 				, m_overlayDepth(0)
 				, m_lastSize(-1, -1)
+				, m_renderSize(0, 0)
+				, m_requestedSize(0, 0)
 		{
 			m_setupShortcuts();
 			m_setupBoundingBox();
@@ -32,6 +34,7 @@ namespace ed {
 			m_mouseLock = false;
 			m_fullWindowFocus = true;
 			m_pauseTime = false;
+			m_resizeSettle = m_resizeElapsed = 0.0f;
 		}
 		~PreviewUI()
 		{
@@ -88,6 +91,11 @@ namespace ed {
 
 		GLuint m_overlayFBO, m_overlayColor, m_overlayDepth;
 		glm::ivec2 m_lastSize, m_zoomLastSize;
+
+		// size the project is rendered at - follows the window size with a delay while it's being resized
+		glm::ivec2 m_renderSize, m_requestedSize;
+		float m_resizeSettle, m_resizeElapsed;
+		void m_updateRenderSize(const ImVec2& imageSize, float delta);
 		bool m_hasFocus;
 		bool m_mouseHovers;
 
@@ -380,6 +380,32 @@ namespace ed {
 						m_dialogShaderType = "Audio";
 						igfd::ImGuiFileDialog::Instance()->OpenModal("PropertyShaderDlg", "Select a shader", "GLSL & HLSL {.glsl,.hlsl,.vert,.vs,.frag,.fs,.geom,.gs,.comp,.cs,.slang,.shader},.*", ".");
 					}
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					/* sample rate, block size & channel count */
+					ImGui::Text("Format:");
+					ImGui::NextColumn();
+					ImGui::PushItemWidth(BUTTON_SPACE_LEFT);
+					ImGui::InputInt3("##pui_ssformat", glm::value_ptr(m_cachedAudioFormat));
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Sample rate, block size (samples per chunk), channels");
+					ImGui::PopItemWidth();
+					ImGui::SameLine();
+					if (ImGui::Button("OK##pui_ssapply", ImVec2(-1, 0))) {
+						bool recompile = item->Stream.setFormat(m_cachedAudioFormat.x, m_cachedAudioFormat.y, m_cachedAudioFormat.z);
+
+						// setFormat() clamps the values
+						item->SampleRate = item->Stream.getSampleRate();
+						item->BlockSize = item->Stream.getBlockSize();
+						item->Channels = item->Stream.getChannels();
+						m_cachedAudioFormat = glm::ivec3(item->SampleRate, item->BlockSize, item->Channels);
+
+						if (recompile)
+							m_data->Renderer.Recompile(m_current->Name);
+
+						m_data->Parser.ModifyProject();
+					}
 				} else if (m_current->Type == ed::PipelineItem::ItemType::Geometry) {
 					ed::pipe::GeometryItem* item = reinterpret_cast<ed::pipe::GeometryItem*>(m_current->Data);
 
@@ -892,7 +918,7 @@ namespace ed {
 							pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
 
 							for (auto& mesh : item->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, ownerData->InputLayout, mesh.EBO);
+								mesh.CreateVAO(ownerData->InputLayout);
 
 							m_data->Parser.ModifyProject();
 						}
@@ -911,7 +937,7 @@ namespace ed {
 								pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
 
 								for (auto& mesh : item->Data->Meshes)
-									gl::CreateVAO(mesh.VAO, mesh.VBO, ownerData->InputLayout, mesh.EBO, buf->ID, fmtList);
+									mesh.CreateVAO(ownerData->InputLayout, buf->ID, fmtList);
 
 								m_data->Parser.ModifyProject();
 							}
@@ -1353,6 +1379,9 @@ namespace ed {
 			if (item->Type == PipelineItem::ItemType::ComputePass) {
 				pipe::ComputePass* cPass = (pipe::ComputePass*)item->Data;
 				m_cachedGroupSize = glm::ivec3(cPass->WorkX, cPass->WorkY, cPass->WorkZ);
+			} else if (item->Type == PipelineItem::ItemType::AudioPass) {
+				pipe::AudioPass* aPass = (pipe::AudioPass*)item->Data;
+				m_cachedAudioFormat = glm::ivec3(aPass->SampleRate, aPass->BlockSize, aPass->Channels);
 			}
 		}
 
@@ -37,5 +37,6 @@ namespace ed {
 		std::string m_dialogShaderType;
 
 		glm::ivec3 m_cachedGroupSize;
+		glm::ivec3 m_cachedAudioFormat; // sample rate, block size, channels
 	};
 }
\ No newline at end of file
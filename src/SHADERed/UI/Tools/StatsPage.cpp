@@ -1,4 +1,5 @@
 #include <SHADERed/UI/Tools/StatsPage.h>
+#include <SHADERed/Objects/SPIRVCache.h>
 #include <SHADERed/Objects/ThemeContainer.h>
 #include <SHADERed/Objects/Settings.h>
 #include <imgui/imgui.h>
@@ -18,6 +19,17 @@ namespace ed {
 
 		ImGui::NewLine();
 
+		SPIRVCache& spvCache = SPIRVCache::Instance();
+		ImGui::Text("SPIR-V cache hits: %u", spvCache.GetHitCount());
+		ImGui::Text("SPIR-V cache misses: %u", spvCache.GetMissCount());
+		ImGui::Text("GL uniform calls per frame: %u", m_data->Renderer.GetUniformCallCount());
+
+		size_t rtMemory = 0, rtMemoryUnshared = 0;
+		m_data->Objects.GetRenderTextureMemory(rtMemory, rtMemoryUnshared);
+		ImGui::Text("Render texture memory: %.2f MB (%.2f MB without sharing)", rtMemory / (1024.0f * 1024.0f), rtMemoryUnshared / (1024.0f * 1024.0f));
+
+		ImGui::NewLine();
+
 		ImGui::Text("SPIR-V: ");
 		ImGui::Separator();
 		m_spirv.Render("stats");